@@ -9,18 +9,22 @@ vertexShader "
     float deltaTime;
     float random01;
     float elapsedSeconds;
+    mat4 viewProj;
+    int instanced;              // 1 while drawing instances of a mesh
   };
 
   layout (location = 0) in vec3 vertPos;
   layout (location = 1) in vec2 vertUVIn;
   layout (location = 4) in vec4 colorIn;
   layout (location = 3) in vec3 normalIn;
+  layout (location = 5) in mat4 smolInstanceModel;   // per instance model matrix
   uniform vec4 color;
 
   out vec4 vertColor; 
   out vec2 uv;
   void main() {
-    gl_Position =  proj * view * model * vec4(vertPos, 1.0);
+    mat4 modelMatrix = instanced != 0 ? smolInstanceModel : model;
+    gl_Position =  proj * view * modelMatrix * vec4(vertPos, 1.0);
     vertColor = colorIn * color;
     uv = vertUVIn;
 }
@@ -251,8 +251,7 @@ void onUpdate(float deltaTime)
   snprintf((char *) buff, sizeof(buff), "#Camera Position:\n%f, %f, %f\nafpjg;", cameraPos.x, cameraPos.y, cameraPos.z);
   textNode->text.setText((const char*)buff);
 
-  textBGNode->sprite.width = textNode->text.textBounds.x;
-  textBGNode->sprite.height = textNode->text.textBounds.y;
+  textBGNode->sprite.setSize(textNode->text.textBounds.x, textNode->text.textBounds.y);
 
   if (keyboard.getKeyDown(smol::KEYCODE_C))
   {
@@ -34,6 +34,8 @@
 
 #include <smol/smol_event_manager.h>
 #include <smol/smol_event.h>
+#include <smol/smol_frame_allocator.h>
+#include <smol/smol_job_system.h>
 
 namespace smol
 {
@@ -147,6 +149,7 @@ namespace smol
       Platform::getWindowSize(window, &displayConfig.width, &displayConfig.height);
 
       // Initialize systems
+      JobSystem::get().initialize(systemConfig.workerThreads);
       ResourceManager::get().initialize();
       Renderer::initialize(ConfigManager::get().rendererConfig());
       ResourceManager& resourceManager = ResourceManager::get();
@@ -178,6 +181,8 @@ namespace smol
         float deltaTime = Platform::getMillisecondsBetweenTicks(startTime, endTime);
 
         startTime = Platform::getTicks();
+        FrameAllocator::get().beginFrame();
+        Platform::beginMemoryFrame();
         Platform::updateWindowEvents(window);
         InputManager::get().update();
         EventManager::get().dispatchEvents();
@@ -215,6 +220,7 @@ namespace smol
       }
 
       //game.onStop();
+      JobSystem::get().shutdown();
       Platform::unloadModule(game.module);
       Platform::destroyWindow(window);
 
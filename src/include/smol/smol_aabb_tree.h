@@ -0,0 +1,79 @@
+#ifndef SMOL_AABB_TREE_H
+#define SMOL_AABB_TREE_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_bounds.h>
+
+namespace smol
+{
+  struct AABBTreeNode;
+
+  // Return false to stop the query
+  typedef bool (*AABBTreeQueryCallback)(uint64 userData, void* context);
+
+  // Called for every leaf the ray hits before maxDistance. Return the distance
+  // of the hit to clip the ray, maxDistance to ignore the leaf or 0 to stop.
+  typedef float (*AABBTreeRayCallback)(uint64 userData, const Ray& ray, float maxDistance, void* context);
+
+  // Dynamic bounding volume hierarchy. Every leaf holds the box of one proxy
+  // grown by a margin, so objects that move a little don't need to touch the
+  // tree. Inserting, removing and moving a proxy keeps the tree balanced with
+  // AVL style rotations, so queries visit O(log n) nodes plus the results.
+  //
+  // Proxies are ids returned by insert(). They stay valid until removed.
+  // The tree is not thread safe.
+  struct SMOL_ENGINE_API AABBTree
+  {
+    private:
+      AABBTreeNode* nodes;
+      int32 capacity;
+      int32 root;
+      int32 freeList;
+      int32 proxyCount;
+
+      int32 allocateNode();
+      void freeNode(int32 node);
+      void insertLeaf(int32 leaf);
+      void removeLeaf(int32 leaf);
+      int32 balance(int32 node);
+
+    public:
+      AABBTree();
+      ~AABBTree();
+
+      int32 insert(const AABB& box, uint64 userData);
+      void remove(int32 proxy);
+
+      // Returns true if the proxy had to be reinserted because the box left
+      // its fat box. Boxes that shrank a lot are also reinserted.
+      bool update(int32 proxy, const AABB& box);
+
+      uint64 getUserData(int32 proxy) const;
+      const AABB& getFatBox(int32 proxy) const;
+      int32 getProxyCount() const;
+      int32 getHeight() const;
+      void reset();
+
+      // Queries test fat boxes, so they might report proxies slightly outside
+      // the volume. Callers that need exact results must test the proxies again.
+      void query(const AABB& box, AABBTreeQueryCallback callback, void* context) const;
+      void query(const Frustum& frustum, AABBTreeQueryCallback callback, void* context) const;
+
+      // Nodes closer to the origin are visited first, so clipping the ray on
+      // the callback quickly prunes everything behind the closest hit.
+      void raycast(const Ray& ray, float maxDistance, AABBTreeRayCallback callback, void* context) const;
+
+      // Finds the k proxies whose fat box is closest to point, sorted by
+      // distance. results and distancesSquared must have room for k elements.
+      // Returns how many proxies were found.
+      int32 queryNearest(const Vector3& point, int32 k, uint64* results, float* distancesSquared) const;
+
+      // Disallow copies
+      AABBTree(const AABBTree& other) = delete;
+      AABBTree(const AABBTree&& other) = delete;
+      void operator=(const AABBTree& other) = delete;
+      void operator=(const AABBTree&& other) = delete;
+  };
+}
+
+#endif  // SMOL_AABB_TREE_H
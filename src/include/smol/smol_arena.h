@@ -1,41 +1,106 @@
 #ifndef SMOL_ARENA
 #define SMOL_ARENA
 #include <smol/smol_engine.h>
+#include <smol/smol_platform.h>
 
 #define KILOBYTE(value) (size_t) ((value) * 1024LL)
 #define MEGABYTE(value) (size_t) (KILOBYTE(value) * 1024LL)
 #define GIGABYTE(value) (size_t) (MEGABYTE(value) * 1024LL)
 
+// Every Arena base address is aligned to SMOL_ARENA_MAX_ALIGNMENT so any
+// alignment up to this value can be requested with pushAligned().
+#define SMOL_ARENA_MAX_ALIGNMENT 64
+
+// Build option: minimum alignment applied to pushAligned() and push<T>().
+// Set it to 16, 32 or 64 to make every typed allocation suitable for SSE/AVX
+// aligned loads. pushSize() is never padded, so consecutive pushSize() calls
+// still produce contiguous memory.
+#ifndef SMOL_ARENA_MIN_ALIGNMENT
+#define SMOL_ARENA_MIN_ALIGNMENT 1
+#endif
+
+static_assert((SMOL_ARENA_MIN_ALIGNMENT & (SMOL_ARENA_MIN_ALIGNMENT - 1)) == 0, "SMOL_ARENA_MIN_ALIGNMENT must be a power of two");
+static_assert(SMOL_ARENA_MIN_ALIGNMENT <= SMOL_ARENA_MAX_ALIGNMENT, "SMOL_ARENA_MIN_ALIGNMENT must not be larger than SMOL_ARENA_MAX_ALIGNMENT");
+
 namespace smol
 {
+  // Opaque position inside an Arena. See Arena::mark() and Arena::rewind().
+  struct ArenaMarker
+  {
+    size_t used;
+  };
+
   class SMOL_ENGINE_API Arena
   {
-    size_t capacity;
+    public:
+    enum Flag : uint32
+    {
+      NONE              = 0,
+      VIRTUAL_MEMORY    = 1 << 0, // Reserve address space up front and commit pages on demand. Memory never moves.
+      DECOMMIT_ON_RESET = 1 << 1  // Return committed pages to the OS on reset(). Only valid with VIRTUAL_MEMORY.
+    };
+
+    private:
+    size_t capacity;    // committed bytes
     size_t used;
+    size_t reserved;    // reserved address space. Only used with VIRTUAL_MEMORY
     char* data;
+    uint32 flags;
+    MemoryTag tag;      // Platform memory tag used for all memory of this arena
 
     public:
 
     Arena();
 
-    Arena(size_t initialSize);
+    Arena(size_t initialSize, MemoryTag tag = MemoryTag::ARENA);
+
+    // Creates a VIRTUAL_MEMORY arena that reserves reserveSize bytes of
+    // address space and commits initialSize bytes of it.
+    Arena(size_t initialSize, size_t reserveSize, uint32 flags = Flag::VIRTUAL_MEMORY, MemoryTag tag = MemoryTag::ARENA);
 
     Arena(Arena&& other);
 
     ~Arena();
 
-    void initialize(size_t initialSize);
+    void initialize(size_t initialSize, MemoryTag tag = MemoryTag::ARENA);
+
+    void initialize(size_t initialSize, size_t reserveSize, uint32 flags = Flag::VIRTUAL_MEMORY, MemoryTag tag = MemoryTag::ARENA);
 
     char* pushSize(size_t size);
 
+    // Returns size bytes aligned to alignment or SMOL_ARENA_MIN_ALIGNMENT,
+    // whichever is larger. alignment must be a power of two.
+    char* pushAligned(size_t size, size_t alignment);
+
+    template <typename T>
+      T* push(size_t count = 1);
+
     void reset();
 
+    // Returns the current position of the arena.
+    ArenaMarker mark() const;
+
+    // Releases everything pushed after marker was taken. Committed memory is kept.
+    void rewind(ArenaMarker marker);
+
     size_t getCapacity() const;
 
     size_t getUsed() const;
 
+    size_t getReserved() const;
+
+    uint32 getFlags() const;
+
+    MemoryTag getMemoryTag() const;
+
     const char* getData() const;
   };
+
+  template <typename T>
+    inline T* Arena::push(size_t count)
+    {
+      return (T*) pushAligned(count * sizeof(T), alignof(T));
+    }
 }
 
 #endif  // SMOL_ARENA
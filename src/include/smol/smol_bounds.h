@@ -0,0 +1,107 @@
+#ifndef SMOL_BOUNDS_H
+#define SMOL_BOUNDS_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_vector3.h>
+
+namespace smol
+{
+  struct Mat4;
+
+  // Distances along a ray are measured in multiples of direction. Use a unit
+  // length direction to get them in world units.
+  struct SMOL_ENGINE_API Ray
+  {
+    Vector3 origin;
+    Vector3 direction;
+
+    Ray();
+    Ray(const Vector3& origin, const Vector3& direction);
+    Vector3 getPoint(float distance) const;
+
+    // Closest triangle hit before maxDistance. Both faces are tested. Three
+    // indices per triangle, or three positions when indices is null. Returns
+    // the index of the triangle or -1. Triangles are tested 4 at a time with SIMD.
+    int32 intersectTriangles(const Vector3* positions, const unsigned int* indices, int32 numTriangles,
+        float maxDistance, float* distance = nullptr) const;
+  };
+
+  struct SMOL_ENGINE_API AABB
+  {
+    Vector3 min;
+    Vector3 max;
+
+    AABB();
+    AABB(const Vector3& min, const Vector3& max);
+
+    // Returns an empty box at the origin when count is zero
+    static AABB fromPoints(const Vector3* points, int32 count);
+
+    // Smallest box containing both boxes
+    static AABB merge(const AABB& a, const AABB& b);
+
+    Vector3 getCenter() const;
+    Vector3 getExtents() const;   // half the size on each axis
+    float getSurfaceArea() const;
+
+    bool overlaps(const AABB& other) const;
+    bool contains(const AABB& other) const;
+
+    // Squared distance from the point to the closest point of the box. Zero when inside.
+    float distanceSquared(const Vector3& point) const;
+
+    // Slab test. Rays starting inside the box hit it at distance 0.
+    bool intersects(const Ray& ray, float maxDistance, float* distance = nullptr) const;
+
+    // Box containing this box after being transformed by an affine matrix
+    AABB transformed(const Mat4& matrix) const;
+  };
+
+  struct SMOL_ENGINE_API BoundingSphere
+  {
+    Vector3 center;
+    float radius;
+
+    BoundingSphere();
+    BoundingSphere(const Vector3& center, float radius);
+
+    // Sphere centered on the bounding box of the points. It's not the smallest
+    // sphere but it's close and takes only two passes over the points.
+    static BoundingSphere fromPoints(const Vector3* points, int32 count);
+
+    // Sphere containing this sphere after being transformed by an affine
+    // matrix. Non uniform scales grow the radius by the largest axis scale.
+    BoundingSphere transformed(const Mat4& matrix) const;
+  };
+
+  // Frustum planes extracted from a view-projection matrix. Planes face inwards.
+  // They are stored as a structure of arrays padded to 8 planes so they can be
+  // tested 4 at a time with SIMD.
+  struct SMOL_ENGINE_API Frustum
+  {
+    enum Plane
+    {
+      PLANE_LEFT    = 0,
+      PLANE_RIGHT   = 1,
+      PLANE_BOTTOM  = 2,
+      PLANE_TOP     = 3,
+      PLANE_NEAR    = 4,
+      PLANE_FAR     = 5,
+      PLANE_COUNT   = 6
+    };
+
+    alignas(16) float planeX[8];
+    alignas(16) float planeY[8];
+    alignas(16) float planeZ[8];
+    alignas(16) float planeW[8];
+
+    static Frustum fromMatrix(const Mat4& viewProjection);
+
+    // Conservative tests. They might return true for volumes just outside a
+    // corner of the frustum but never return false for visible ones.
+    bool intersects(const BoundingSphere& sphere) const;
+    bool intersects(const AABB& box) const;
+  };
+}
+
+#endif  // SMOL_BOUNDS_H
@@ -5,6 +5,8 @@
 #include <smol/smol_color.h>
 #include <smol/smol_mat4.h>
 #include <smol/smol_rect.h>
+#include <smol/smol_point.h>
+#include <smol/smol_bounds.h>
 namespace smol
 {
   enum Layer
@@ -50,7 +52,9 @@ namespace smol
       NONE                = 0,
       VIEWPORT_CHANGED    = 1 << 1,
       PROJECTION_CHANGED  = 1 << 2,
-      CLEAR_COLOR_CHANGED = 1 << 3
+      CLEAR_COLOR_CHANGED = 1 << 3,
+      VIEW_CHANGED        = 1 << 4,
+      PROJECTION_OUTDATED = 1 << 5  // The viewport was empty the last time the projection was computed
     };
 
     enum Type
@@ -76,7 +80,13 @@ namespace smol
     uint32 layers;
     Rectf rect;
     Color clearColor;
+    uint32 flags;
+    uint32 displayGeneration;     // display resize count when the projection was computed
+    Mat4 projectionMatrix;
     Mat4 viewMatrix;
+    Mat4 viewProjectionMatrix;
+
+    bool updateProjection();
 
     public:
     Camera();
@@ -88,6 +98,10 @@ namespace smol
     uint32 getLayerMask() const;
     const Mat4& getProjectionMatrix() const;
 
+    // View and view-projection matrices cached by updateView()
+    const Mat4& getViewMatrix() const;
+    const Mat4& getViewProjectionMatrix() const;
+
     const Rectf& getViewportRect() const;
     Camera& setViewportRect(const Rectf& rect);
 
@@ -109,7 +123,25 @@ namespace smol
     float getOrthographicSize() const;
     float getOrthographicLeft() const;
     float getOrthographicRight() const;
+
+    // Recomputes the projection matrix from the current viewport.
+    // updateView() already does it after the display is resized.
     void update();
+
+    // Makes every camera recompute its projection on its next updateView(),
+    // including cameras that are not rendered when the display is resized.
+    static void displayResized();
+
+    // Recomputes the cached view and view-projection matrices if the camera
+    // world matrix or the projection changed since the last call. Returns true
+    // if the matrices changed.
+    bool updateView(const Mat4& worldMatrix, bool worldMatrixChanged);
+
+    // Ray through a pixel of the screen. screenPoint starts at the top left
+    // corner like the mouse cursor and viewport is the whole display. The ray
+    // starts on the near plane and its direction reaches the far plane, so
+    // hits past distance 1 can't be seen by the camera.
+    Ray screenPointToRay(const Point2& screenPoint, const Rect& viewport) const;
   };
 }
 #endif  // SMOL_CAMERA_H
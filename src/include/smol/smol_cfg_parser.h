@@ -3,12 +3,19 @@
 
 #include <smol/smol_engine.h>
 #include <smol/smol_arena.h>
+#include <smol/smol_hash_map.h>
 #include <smol/smol_vector2.h>
 #include <smol/smol_vector3.h>
 #include <smol/smol_vector4.h>
 
 #define SMOL_CONFIG_VAR_MAX_NAME_LEN 64
 
+// Entries with at least this many variables get a hash map for variable
+// lookups. Smaller entries are faster to scan.
+#ifndef SMOL_CONFIG_VARIABLE_MAP_THRESHOLD
+#define SMOL_CONFIG_VARIABLE_MAP_THRESHOLD 16
+#endif
+
 namespace smol
 {
   struct SMOL_ENGINE_API ConfigVariable
@@ -33,6 +40,8 @@ namespace smol
     uint32 variableCount;
     ConfigVariable* variables;
     ConfigEntry* next;
+    ConfigEntry* nextSameHash;            // next entry with the same name hash
+    HashMap<uint32>* variableMap;         // variable hash -> index. Only for large entries
     const char* name;
     int64 hash;
 
@@ -44,12 +53,19 @@ namespace smol
 
   };
 
+  struct ConfigEntryChain
+  {
+    ConfigEntry* first;
+    ConfigEntry* last;
+  };
+
   struct SMOL_ENGINE_API Config
   {
     smol::Arena arena;
     char* buffer;
     ConfigEntry* entries;
     uint32 entryCount;
+    HashMap<ConfigEntryChain> entryMap;   // name hash -> entries with that name
 
     Config(size_t initialArenaSize);
     Config(const char* path, size_t initialArenaSize = MEGABYTE(1));
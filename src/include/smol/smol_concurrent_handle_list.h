@@ -0,0 +1,243 @@
+#ifndef SMOL_CONCURRENT_HANDLE_LIST
+#define SMOL_CONCURRENT_HANDLE_LIST
+
+#include <smol/smol_handle_list.h>
+#include <smol/smol_platform.h>
+#include <atomic>
+#include <new>
+
+namespace smol
+{
+  //
+  // A fixed capacity HandleList that can be used from several threads at once.
+  //
+  // Unlike HandleList, resources are not kept in a dense array. Each resource
+  // lives in its own slot so nothing ever moves and lookup() is a single
+  // atomic load of the slot version. Free slots are kept in a lock-free stack.
+  //
+  // A slot is alive when its version is odd. remove() bumps the version so
+  // any outstanding handle to that slot stops resolving. Removing a resource
+  // while another thread is still using a pointer to it must be coordinated
+  // by the caller.
+  //
+  // Handles from this list are not registered with Handle<T>::operator->().
+  // Use lookup() instead.
+  //
+  template <typename T>
+    class ConcurrentHandleList
+    {
+      struct Slot
+      {
+        std::atomic<int32> version;
+        std::atomic<int32> nextFreeSlotIndex;
+      };
+
+      Slot* slots;
+      T* resources;
+      int32 capacity;
+      std::atomic<int32> slotsUsed;       // slots handed out at least once
+      std::atomic<int32> resourceCount;
+      std::atomic<uint64> freeSlotListHead; // low 32 bits: slot index + 1, high 32 bits: ABA tag
+
+      int32 popFreeSlot();
+      void pushFreeSlot(int32 slotIndex);
+      int32 acquireSlot();
+      Handle<T> publish(int32 slotIndex);
+
+      public:
+      ConcurrentHandleList(int capacity);
+      ~ConcurrentHandleList();
+
+      // Returns INVALID_HANDLE(T) when the list is full
+      Handle<T> reserve();
+      Handle<T> add(const T&);
+      T* lookup(Handle<T> handle) const;
+      bool remove(Handle<T> handle);
+      int count() const;
+      int getCapacity() const;
+
+      // Calls callback(Handle<T>, T&) for every live resource.
+      template <typename Callback>
+        void forEach(Callback callback);
+
+      // Disallow copies
+      ConcurrentHandleList(const ConcurrentHandleList& other) = delete;
+      ConcurrentHandleList(const ConcurrentHandleList&& other) = delete;
+      void operator=(const ConcurrentHandleList& other) = delete;
+      void operator=(const ConcurrentHandleList&& other) = delete;
+    };
+
+  template <typename T>
+    ConcurrentHandleList<T>::ConcurrentHandleList(int capacity):
+      capacity(capacity),
+      slotsUsed(0),
+      resourceCount(0),
+      freeSlotListHead(0)
+  {
+    slots = (Slot*) Platform::getMemory(sizeof(Slot) * capacity, alignof(Slot), MemoryTag::HANDLE_LIST);
+    resources = (T*) Platform::getMemory(sizeof(T) * capacity, alignof(T), MemoryTag::HANDLE_LIST);
+
+    for (int i = 0; i < capacity; i++)
+    {
+      new (&slots[i].version) std::atomic<int32>(0);
+      new (&slots[i].nextFreeSlotIndex) std::atomic<int32>(-1);
+    }
+  }
+
+  template <typename T>
+    ConcurrentHandleList<T>::~ConcurrentHandleList()
+    {
+      Platform::freeMemory(slots);
+      Platform::freeMemory(resources);
+    }
+
+  template <typename T>
+    int32 ConcurrentHandleList<T>::popFreeSlot()
+    {
+      uint64 head = freeSlotListHead.load(std::memory_order_acquire);
+      while (true)
+      {
+        const int32 slotIndex = (int32) (head & 0xFFFFFFFF) - 1;
+        if (slotIndex < 0)
+          return -1;
+
+        // The tag changes on every push and pop so a slot that was popped and
+        // pushed back in the meantime doesn't fool the compare exchange.
+        const int32 next = slots[slotIndex].nextFreeSlotIndex.load(std::memory_order_relaxed);
+        const uint64 newHead = ((head >> 32) + 1) << 32 | (uint64) (uint32) (next + 1);
+        if (freeSlotListHead.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+          return slotIndex;
+      }
+    }
+
+  template <typename T>
+    void ConcurrentHandleList<T>::pushFreeSlot(int32 slotIndex)
+    {
+      uint64 head = freeSlotListHead.load(std::memory_order_relaxed);
+      while (true)
+      {
+        slots[slotIndex].nextFreeSlotIndex.store((int32) (head & 0xFFFFFFFF) - 1, std::memory_order_relaxed);
+        const uint64 newHead = ((head >> 32) + 1) << 32 | (uint64) (uint32) (slotIndex + 1);
+        if (freeSlotListHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed))
+          return;
+      }
+    }
+
+  template <typename T>
+    Handle<T> ConcurrentHandleList<T>::publish(int32 slotIndex)
+    {
+      // Release so the resource is visible to any thread that sees the new version
+      Slot& slot = slots[slotIndex];
+      const int32 version = slot.version.load(std::memory_order_relaxed) + 1;
+      slot.version.store(version, std::memory_order_release);
+      resourceCount.fetch_add(1, std::memory_order_relaxed);
+
+      Handle<T> handle;
+      handle.slotIndex = slotIndex;
+      handle.version = version;
+      return handle;
+    }
+
+  template <typename T>
+    int32 ConcurrentHandleList<T>::acquireSlot()
+    {
+      int32 slotIndex = popFreeSlot();
+      if (slotIndex >= 0)
+        return slotIndex;
+
+      // No free slots. Take one that was never used.
+      slotIndex = slotsUsed.fetch_add(1, std::memory_order_relaxed);
+      if (slotIndex >= capacity)
+      {
+        slotsUsed.fetch_sub(1, std::memory_order_relaxed);
+        Log::error("ConcurrentHandleList<%s> is full. Capacity is %d", typeid(T).name(), capacity);
+        return -1;
+      }
+      return slotIndex;
+    }
+
+  template <typename T>
+    Handle<T> ConcurrentHandleList<T>::reserve()
+    {
+      const int32 slotIndex = acquireSlot();
+      if (slotIndex < 0)
+        return INVALID_HANDLE(T);
+
+      return publish(slotIndex);
+    }
+
+  template <typename T>
+    Handle<T> ConcurrentHandleList<T>::add(const T& t)
+    {
+      const int32 slotIndex = acquireSlot();
+      if (slotIndex < 0)
+        return INVALID_HANDLE(T);
+
+      // Copy before publishing the slot so lookup() never sees a partial resource
+      memcpy((void*) &resources[slotIndex], (void*) &t, sizeof(T));
+      return publish(slotIndex);
+    }
+
+  template <typename T>
+    T* ConcurrentHandleList<T>::lookup(Handle<T> handle) const
+    {
+      if (handle.slotIndex < 0 || handle.slotIndex >= capacity)
+        return nullptr;
+
+      if (slots[handle.slotIndex].version.load(std::memory_order_acquire) != handle.version)
+        return nullptr;
+
+      return &resources[handle.slotIndex];
+    }
+
+  template <typename T>
+    bool ConcurrentHandleList<T>::remove(Handle<T> handle)
+    {
+      if (handle.slotIndex < 0 || handle.slotIndex >= capacity || (handle.version & 1) == 0)
+        return false;
+
+      // Only one thread can win this exchange, so a handle is never removed twice
+      int32 expected = handle.version;
+      if (!slots[handle.slotIndex].version.compare_exchange_strong(expected, handle.version + 1, std::memory_order_acq_rel))
+        return false;
+
+      resourceCount.fetch_sub(1, std::memory_order_relaxed);
+      pushFreeSlot(handle.slotIndex);
+      return true;
+    }
+
+  template <typename T>
+    inline int ConcurrentHandleList<T>::count() const
+    {
+      return resourceCount.load(std::memory_order_relaxed);
+    }
+
+  template <typename T>
+    inline int ConcurrentHandleList<T>::getCapacity() const
+    {
+      return capacity;
+    }
+
+  template <typename T>
+    template <typename Callback>
+    void ConcurrentHandleList<T>::forEach(Callback callback)
+    {
+      int32 numSlots = slotsUsed.load(std::memory_order_acquire);
+      if (numSlots > capacity)
+        numSlots = capacity;
+
+      for (int32 i = 0; i < numSlots; i++)
+      {
+        const int32 version = slots[i].version.load(std::memory_order_acquire);
+        if ((version & 1) == 0)
+          continue;
+
+        Handle<T> handle;
+        handle.slotIndex = i;
+        handle.version = version;
+        callback(handle, resources[i]);
+      }
+    }
+}
+
+#endif  // SMOL_CONCURRENT_HANDLE_LIST
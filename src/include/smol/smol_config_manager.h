@@ -54,6 +54,7 @@ namespace smol
     bool captureCursor = false;
     int glVersionMajor = 3;
     int glVersionMinor = 0;
+    int workerThreads = -1;     // -1 means one per logical processor, not counting the main thread
 
     GlobalSystemConfig();
     GlobalSystemConfig(const Config& config);
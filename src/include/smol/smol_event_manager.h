@@ -24,8 +24,17 @@ namespace smol
 
   class SMOL_ENGINE_API EventManager final
   {
+    // Queued events live in FrameAllocator memory. Events pushed on frame N
+    // must be dispatched before the end of frame N+1.
+    struct QueuedEvent
+    {
+      Event event;
+      QueuedEvent* next;
+    };
+
     HandleList<EventHandler> handlers;
-    Arena events;
+    QueuedEvent* firstEvent;
+    QueuedEvent* lastEvent;
     EventManager();
 
     public:
@@ -1,4 +1,5 @@
 #include <smol/smol_handle_list.h>
+#include <smol/smol_hash_map.h>
 #include <smol/smol_texture.h>
 #include <smol/smol_rect.h>
 #include <smol/smol_vector2.h>
@@ -46,6 +47,7 @@ namespace smol
     uint16 glyphCount;
     Kerning* kerning;
     Glyph* glyph;
+    HashMap<uint16> glyphMap;   // glyph id -> index into glyph
     const char* name;
     Handle<Texture> texture;
   };
@@ -68,6 +70,7 @@ namespace smol
     uint16 getGlyphCount() const;
     const Kerning* getKernings(int* count = nullptr) const; 
     const Glyph* getGlyphs(int* count = nullptr) const; 
+    const Glyph* findGlyph(uint16 id) const;
 #ifndef SMOL_MODULE_GAME
     const FontInfo* getFontInfo() const;
 #endif
@@ -0,0 +1,57 @@
+#ifndef SMOL_FRAME_ALLOCATOR_H
+#define SMOL_FRAME_ALLOCATOR_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_arena.h>
+
+namespace smol
+{
+  // Double buffered scratch memory for data that only lives for a frame.
+  // Memory pushed during frame N stays valid until the end of frame N+1, so
+  // anything produced late in a frame can still be consumed early in the next
+  // one. beginFrame() must be called exactly once per frame.
+  class SMOL_ENGINE_API FrameAllocator final
+  {
+    Arena arenas[2];
+    uint32 current;
+    uint64 frameCount;
+    FrameAllocator();
+
+    public:
+    static FrameAllocator& get();
+
+    // Swaps buffers. Memory from two frames ago is released.
+    void beginFrame();
+
+    char* pushSize(size_t size);
+
+    char* pushAligned(size_t size, size_t alignment);
+
+    template <typename T>
+      T* push(size_t count = 1);
+
+    ArenaMarker mark() const;
+
+    void rewind(ArenaMarker marker);
+
+    uint64 getFrameCount() const;
+
+    Arena& getCurrentArena();
+
+    const Arena& getPreviousArena() const;
+
+    // Disallow copies
+    FrameAllocator(const FrameAllocator& other) = delete;
+    FrameAllocator(const FrameAllocator&& other) = delete;
+    void operator=(const FrameAllocator& other) = delete;
+    void operator=(const FrameAllocator&& other) = delete;
+  };
+
+  template <typename T>
+    inline T* FrameAllocator::push(size_t count)
+    {
+      return arenas[current].push<T>(count);
+    }
+}
+
+#endif //SMOL_FRAME_ALLOCATOR_H
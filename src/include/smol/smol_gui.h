@@ -93,8 +93,7 @@ namespace smol
       DEFAULT_H_SPACING = 5,
     };
 
-    StreamBuffer streamBuffer;
-    Arena glyphDrawDataArena;
+    StreamBuffer streamBuffer = {};
     Handle<Material> material;
     GUISkin skin;
     Rect lastRect;                    // Rect of the last control drawn
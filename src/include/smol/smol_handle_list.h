@@ -5,9 +5,10 @@
 #include <smol/smol_arena.h>
 #include <string.h>
 #include <typeinfo>
+#include <algorithm>
 
 #define getSlotIndex(slotInfo) ((int)((char*) (slotInfo) - slots.getData()) / sizeof(SlotInfo))
-#define INVALID_HANDLE(T) (Handle<T>{ (int) 0xFFFFFFFF, (int) 0xFFFFFFFF})
+#define INVALID_HANDLE(T) (smol::Handle<T>{ (int) 0xFFFFFFFF, (int) 0xFFFFFFFF})
 
 namespace smol
 {
@@ -99,20 +100,59 @@ namespace smol
     {
       Arena slots;
       Arena resources;
+      Arena resourceSlots;          // slot index of each resource. Maps the dense resource array back to slots.
       int resourceCount;
       int freeSlotListCount;
       int freeSlotListStart;
 
+      int slotCount() const;
+      void rebuildFreeSlotList();
+
       public:
       HandleList(int initialCapacity = 32 * sizeof(T));
+
+      // Creates a pointer stable HandleList. Address space for maxCapacity
+      // resources is reserved up front and committed as the list grows, so
+      // resources never move when adding and pointers returned by lookup()
+      // stay valid. Removing still moves the last resource into the hole.
+      HandleList(int initialCapacity, int maxCapacity);
       Handle<T> reserve();
       Handle<T> add(const T&);
       Handle<T> add(T&&);
       T* lookup(Handle<T> handle) const;
       void remove(Handle<T> handle);
+
+      // Batch versions of reserve(), add() and remove(). The list grows at
+      // most once per call and resources reserved or added in the same call
+      // are contiguous on the array returned by getArray().
+      void reserveMany(int count, Handle<T>* handles);
+      void addMany(const T* source, int count, Handle<T>* handles);
+
+      // Removes all handles with a single compaction pass that preserves the
+      // order of the remaining resources. Invalid handles are ignored.
+      // Returns how many resources were removed.
+      int removeMany(const Handle<T>* handles, int count);
+
       void reset();
       int count() const;
       const T* getArray() const;
+      bool isPointerStable() const;
+
+      // Returns the handle of the resource at index on the array returned by getArray().
+      Handle<T> getHandle(int resourceIndex) const;
+
+      // Calls callback(Handle<T>, T&) for every resource in array order.
+      template <typename Callback>
+        void forEach(Callback callback);
+
+      // Reorders resources by slot index so resources created together stay
+      // together after swap-removes scattered them, and makes free slots be
+      // reused from the lowest index. Invalidates pointers but not handles.
+      void defragment();
+
+      // Reorders resources so that less(a, b) holds for consecutive resources.
+      template <typename Less>
+        void defragment(Less less);
     };
 
   //
@@ -120,8 +160,21 @@ namespace smol
   //
   template<typename T> 
     HandleList<T>::HandleList(int initialCapacity):
-      slots(sizeof(SlotInfo) * initialCapacity),
-      resources(sizeof(T) * initialCapacity),
+      slots(sizeof(SlotInfo) * initialCapacity, MemoryTag::HANDLE_LIST),
+      resources(sizeof(T) * initialCapacity, MemoryTag::HANDLE_LIST),
+      resourceSlots(sizeof(int) * initialCapacity, MemoryTag::HANDLE_LIST),
+      resourceCount(0),
+      freeSlotListCount(0),
+      freeSlotListStart(-1)
+  { 
+    Handle<T>::registerList(this);
+  }
+
+  template<typename T> 
+    HandleList<T>::HandleList(int initialCapacity, int maxCapacity):
+      slots(sizeof(SlotInfo) * initialCapacity, sizeof(SlotInfo) * maxCapacity, Arena::VIRTUAL_MEMORY, MemoryTag::HANDLE_LIST),
+      resources(sizeof(T) * initialCapacity, sizeof(T) * maxCapacity, Arena::VIRTUAL_MEMORY, MemoryTag::HANDLE_LIST),
+      resourceSlots(sizeof(int) * initialCapacity, sizeof(int) * maxCapacity, Arena::VIRTUAL_MEMORY, MemoryTag::HANDLE_LIST),
       resourceCount(0),
       freeSlotListCount(0),
       freeSlotListStart(-1)
@@ -135,17 +188,28 @@ namespace smol
       return resourceCount;
     }
 
+  template<typename T>
+    inline int HandleList<T>::slotCount() const
+    {
+      return (int) (slots.getUsed() / sizeof(SlotInfo));
+    }
+
   template<typename T>
     const T* HandleList<T>::getArray() const
     {
       return (const T*) resources.getData();
     }
 
+  template<typename T>
+    inline bool HandleList<T>::isPointerStable() const
+    {
+      return (resources.getFlags() & Arena::VIRTUAL_MEMORY) != 0;
+    }
+
   template<typename T>
     Handle<T> HandleList<T>::reserve()
     {
       SlotInfo* slotInfo;
-      T* resource;
       ++resourceCount;
 
       if(freeSlotListCount)
@@ -161,18 +225,80 @@ namespace smol
         slotInfo = (SlotInfo*) slots.pushSize(sizeof(SlotInfo));
         slotInfo->version = 0;
         resources.pushSize(sizeof(T));
+        resourceSlots.pushSize(sizeof(int));
       }
 
       slotInfo->resourceIndex = resourceCount - 1;   // The newly added resource or the first empty space from a deleted resource
-      resource = ((T*) resources.getData())+ slotInfo->resourceIndex; // gets the resource this slot points to
 
       // Create a handle to the resource
       Handle<T> handle;
       handle.slotIndex = getSlotIndex(slotInfo);
       handle.version = slotInfo->version;
+      ((int*) resourceSlots.getData())[slotInfo->resourceIndex] = handle.slotIndex;
       return handle;
     }
 
+  template<typename T>
+    void HandleList<T>::reserveMany(int count, Handle<T>* handles)
+    {
+      if (count <= 0)
+        return;
+
+      const int firstResourceIndex = resourceCount;
+      resourceCount += count;
+
+      // Only grow by what the free slot list can't provide
+      const int numReusedSlots = count < freeSlotListCount ? count : freeSlotListCount;
+      const int numNewSlots = count - numReusedSlots;
+      const int firstNewSlotIndex = slotCount();
+      if (numNewSlots > 0)
+        slots.pushSize(numNewSlots * sizeof(SlotInfo));
+
+      // We need room for every resource, not just for the new slots
+      const int numResourcesAllocated = (int) (resources.getUsed() / sizeof(T));
+      if (resourceCount > numResourcesAllocated)
+      {
+        resources.pushSize((resourceCount - numResourcesAllocated) * sizeof(T));
+        resourceSlots.pushSize((resourceCount - numResourcesAllocated) * sizeof(int));
+      }
+
+      SlotInfo* allSlots = (SlotInfo*) slots.getData();
+      int* allResourceSlots = (int*) resourceSlots.getData();
+
+      for (int i = 0; i < count; i++)
+      {
+        int slotIndex;
+        if (i < numReusedSlots)
+        {
+          slotIndex = freeSlotListStart;
+          freeSlotListStart = allSlots[slotIndex].nextFreeSlotIndex;
+          --freeSlotListCount;
+        }
+        else
+        {
+          slotIndex = firstNewSlotIndex + (i - numReusedSlots);
+          allSlots[slotIndex].version = 0;
+        }
+
+        const int resourceIndex = firstResourceIndex + i;
+        allSlots[slotIndex].resourceIndex = resourceIndex;
+        allResourceSlots[resourceIndex] = slotIndex;
+        handles[i].slotIndex = slotIndex;
+        handles[i].version = allSlots[slotIndex].version;
+      }
+    }
+
+  template<typename T>
+    void HandleList<T>::addMany(const T* source, int count, Handle<T>* handles)
+    {
+      if (count <= 0)
+        return;
+
+      const int firstResourceIndex = resourceCount;
+      reserveMany(count, handles);
+      memcpy((void*) (((T*) resources.getData()) + firstResourceIndex), (void*) source, count * sizeof(T));
+    }
+
   template<typename T>
     Handle<T> HandleList<T>::add(T&& t)
     {
@@ -193,7 +319,7 @@ namespace smol
   template <typename T>
     T* HandleList<T>::lookup(Handle<T> handle) const
     {
-      if (handle.slotIndex >= slots.getCapacity() || handle.slotIndex < 0)
+      if (handle.slotIndex >= slotCount() || handle.slotIndex < 0)
       {
         return nullptr;
       }
@@ -215,22 +341,35 @@ namespace smol
       // move the last resource to the place of the one being deleted
       // and fix the slot so it points to the correct resource index.
 
-      if (handle.slotIndex >= slots.getCapacity() / sizeof(T) || handle.slotIndex < 0)
+      if (handle.slotIndex >= slotCount() || handle.slotIndex < 0)
       {
         Log::warning("Attempting to remove a Handle slot out of bounds");
         return;
       }
 
-      SlotInfo* slotOfLast = ((SlotInfo*) slots.getData()) + (resourceCount-1);
-      SlotInfo* slotOfRemoved = ((SlotInfo*)  slots.getData()) + handle.slotIndex;
+      SlotInfo* allSlots = (SlotInfo*) slots.getData();
+      int* allResourceSlots = (int*) resourceSlots.getData();
+      SlotInfo* slotOfRemoved = allSlots + handle.slotIndex;
+      if (slotOfRemoved->version != handle.version)
+      {
+        Log::warning("Attempting to remove a Handle that is no longer valid");
+        return;
+      }
+
+      const int indexOfRemoved = slotOfRemoved->resourceIndex;
+      const int indexOfLast = resourceCount - 1;
       ++slotOfRemoved->version;
 
-      if (slotOfRemoved != slotOfLast)
+      if (indexOfRemoved != indexOfLast)
       {
         // Move the last resource to the space left by the one being removed
-        T* resourceLast = ((T*) resources.getData()) + slotOfLast->resourceIndex;
-        T* resourceRemoved = ((T*) resources.getData()) + slotOfRemoved->resourceIndex;
+        T* resourceLast = ((T*) resources.getData()) + indexOfLast;
+        T* resourceRemoved = ((T*) resources.getData()) + indexOfRemoved;
         memcpy((void*) resourceRemoved, (void*) resourceLast, sizeof(T));
+
+        const int slotIndexOfLast = allResourceSlots[indexOfLast];
+        allSlots[slotIndexOfLast].resourceIndex = indexOfRemoved;
+        allResourceSlots[indexOfRemoved] = slotIndexOfLast;
       }
 
       slotOfRemoved->nextFreeSlotIndex = freeSlotListStart;
@@ -239,21 +378,169 @@ namespace smol
       --resourceCount;
     }
 
+  template <typename T>
+    int HandleList<T>::removeMany(const Handle<T>* handles, int count)
+    {
+      const int numSlots = slotCount();
+      SlotInfo* allSlots = (SlotInfo*) slots.getData();
+      int* allResourceSlots = (int*) resourceSlots.getData();
+      int firstRemovedIndex = resourceCount;
+      int numRemoved = 0;
+
+      // Free the slots and mark removed resources with a slot index of -1
+      for (int i = 0; i < count; i++)
+      {
+        const Handle<T>& handle = handles[i];
+        if (handle.slotIndex < 0 || handle.slotIndex >= numSlots)
+          continue;
+
+        SlotInfo* slot = allSlots + handle.slotIndex;
+        if (slot->version != handle.version)
+          continue;
+
+        const int resourceIndex = slot->resourceIndex;
+        allResourceSlots[resourceIndex] = -1;
+        if (resourceIndex < firstRemovedIndex)
+          firstRemovedIndex = resourceIndex;
+
+        ++slot->version;
+        slot->nextFreeSlotIndex = freeSlotListStart;
+        freeSlotListStart = handle.slotIndex;
+        ++freeSlotListCount;
+        ++numRemoved;
+      }
+
+      // Close the gaps, moving each remaining resource only once
+      T* allResources = (T*) resources.getData();
+      int writeIndex = firstRemovedIndex;
+      for (int readIndex = firstRemovedIndex; readIndex < resourceCount; readIndex++)
+      {
+        const int slotIndex = allResourceSlots[readIndex];
+        if (slotIndex == -1)
+          continue;
+
+        memcpy((void*) &allResources[writeIndex], (void*) &allResources[readIndex], sizeof(T));
+        allResourceSlots[writeIndex] = slotIndex;
+        allSlots[slotIndex].resourceIndex = writeIndex;
+        ++writeIndex;
+      }
+
+      resourceCount -= numRemoved;
+      return numRemoved;
+    }
+
   template <typename T>
     void HandleList<T>::reset()
     {
-      // invalidate ALL slots
+      // invalidate ALL live slots. Slots are kept so their versions keep
+      // growing and old handles never become valid again.
+      SlotInfo* allSlots = (SlotInfo*) slots.getData();
+      int* allResourceSlots = (int*) resourceSlots.getData();
       for (int i = 0; i < resourceCount; i++)
       {
-        SlotInfo* slot = ((SlotInfo*)  slots.getData()) + i;
-        slot->version++;
+        allSlots[allResourceSlots[i]].version++;
       }
 
-      slots.reset();
-      resources.reset();
       resourceCount = 0;
-      freeSlotListCount = 0;
+      rebuildFreeSlotList();
+    }
+
+  template <typename T>
+    void HandleList<T>::rebuildFreeSlotList()
+    {
+      const int numSlots = slotCount();
+      SlotInfo* allSlots = (SlotInfo*) slots.getData();
+      const int* allResourceSlots = (const int*) resourceSlots.getData();
+
+      // Mark used slots with their resource index and everything else as free
+      for (int i = 0; i < numSlots; i++)
+        allSlots[i].resourceIndex = -1;
+
+      for (int i = 0; i < resourceCount; i++)
+        allSlots[allResourceSlots[i]].resourceIndex = i;
+
+      // Link free slots so the lowest index is reused first
       freeSlotListStart = -1;
+      freeSlotListCount = 0;
+      for (int i = numSlots - 1; i >= 0; i--)
+      {
+        if (allSlots[i].resourceIndex != -1)
+          continue;
+
+        allSlots[i].nextFreeSlotIndex = freeSlotListStart;
+        freeSlotListStart = i;
+        ++freeSlotListCount;
+      }
+    }
+
+  template <typename T>
+    Handle<T> HandleList<T>::getHandle(int resourceIndex) const
+    {
+      if (resourceIndex < 0 || resourceIndex >= resourceCount)
+        return INVALID_HANDLE(T);
+
+      Handle<T> handle;
+      handle.slotIndex = ((const int*) resourceSlots.getData())[resourceIndex];
+      handle.version = ((const SlotInfo*) slots.getData())[handle.slotIndex].version;
+      return handle;
+    }
+
+  template <typename T>
+    template <typename Callback>
+    void HandleList<T>::forEach(Callback callback)
+    {
+      T* allResources = (T*) resources.getData();
+      for (int i = 0; i < resourceCount; i++)
+      {
+        callback(getHandle(i), allResources[i]);
+      }
+    }
+
+  template <typename T>
+    void HandleList<T>::defragment()
+    {
+      const int* allResourceSlots = (const int*) resourceSlots.getData();
+      const T* allResources = (const T*) resources.getData();
+      defragment([allResourceSlots, allResources](const T& a, const T& b)
+          {
+            return allResourceSlots[&a - allResources] < allResourceSlots[&b - allResources];
+          });
+    }
+
+  template <typename T>
+    template <typename Less>
+    void HandleList<T>::defragment(Less less)
+    {
+      if (resourceCount > 1)
+      {
+        T* allResources = (T*) resources.getData();
+        int* allResourceSlots = (int*) resourceSlots.getData();
+
+        // Sort resource indices, then move resources to their new place
+        Arena scratch(resourceCount * (sizeof(int) * 2 + sizeof(T)) + SMOL_ARENA_MAX_ALIGNMENT, MemoryTag::HANDLE_LIST);
+        int* order = scratch.push<int>(resourceCount);
+        int* sortedResourceSlots = scratch.push<int>(resourceCount);
+        T* sortedResources = scratch.push<T>(resourceCount);
+
+        for (int i = 0; i < resourceCount; i++)
+          order[i] = i;
+
+        std::stable_sort(order, order + resourceCount, [allResources, &less](int a, int b)
+            {
+              return less(allResources[a], allResources[b]);
+            });
+
+        for (int i = 0; i < resourceCount; i++)
+        {
+          memcpy((void*) &sortedResources[i], (void*) &allResources[order[i]], sizeof(T));
+          sortedResourceSlots[i] = allResourceSlots[order[i]];
+        }
+
+        memcpy((void*) allResources, (void*) sortedResources, resourceCount * sizeof(T));
+        memcpy((void*) allResourceSlots, (void*) sortedResourceSlots, resourceCount * sizeof(int));
+      }
+
+      rebuildFreeSlotList();
     }
 }
 
@@ -0,0 +1,433 @@
+#ifndef SMOL_HASH_MAP_H
+#define SMOL_HASH_MAP_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_platform.h>
+#include <smol/smol_arena.h>
+#include <smol/smol_log.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMOL_HASH_MAP_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//
+// Open addressing hash map with Swiss table style metadata.
+//
+// Every slot has a control byte. Control bytes are grouped in blocks of 16 and
+// a lookup checks a whole group at once (a single SSE2 compare when
+// available). Keys are 64 bit hashes, usually from smol::stringToHash(). The
+// map never compares the original strings, so callers that can't afford a
+// hash collision must keep the name around and check it after find().
+//
+// Values are treated as plain data, like everything stored in an Arena.
+//
+// Memory can come from three places:
+// - Platform memory owned by the map. The map grows as needed.
+// - An Arena. Capacity is fixed and memory is released with the arena.
+// - A caller provided block of getMemorySize(capacity) bytes. Capacity is fixed.
+//
+
+namespace smol
+{
+  template <typename T>
+    class HashMap
+    {
+      enum : uint8
+      {
+        GROUP_SIZE  = 16,
+        CTRL_EMPTY  = 0x80,
+        CTRL_DELETED = 0xFE
+        // Full slots store the lower 7 bits of the hash (0x00 ~ 0x7F)
+      };
+
+      struct Slot
+      {
+        uint64 key;
+        T value;
+      };
+
+      uint8* ctrl;
+      Slot* slots;
+      size_t slotCount;       // always a multiple of GROUP_SIZE and a power of two
+      size_t itemCount;
+      size_t tombstoneCount;
+      MemoryTag tag;
+      bool ownsMemory;
+
+      static inline uint64 mix(uint64 key);
+      static inline uint32 firstBit(uint32 mask);
+      static inline uint32 matchGroup(const uint8* group, uint8 value);
+      static inline uint32 matchEmpty(const uint8* group);
+      static inline uint32 matchEmptyOrDeleted(const uint8* group);
+      static size_t getSlotCount(size_t capacity);
+      static size_t getSlotsOffset(size_t slotCount);
+      void setMemory(void* memory, size_t slotCount);
+      void rehash(size_t newSlotCount);
+      Slot* findSlot(uint64 key) const;
+
+      public:
+      HashMap();
+
+      // Creates a map that owns its memory and grows as needed
+      HashMap(size_t capacity, MemoryTag tag = MemoryTag::GENERAL);
+
+      HashMap(const HashMap& other) = delete;
+      HashMap& operator=(const HashMap& other) = delete;
+
+      ~HashMap();
+
+      // Bytes needed to hold capacity items with a fixed size map
+      static size_t getMemorySize(size_t capacity);
+
+      void initialize(size_t capacity, MemoryTag tag = MemoryTag::GENERAL);
+
+      void initialize(Arena& arena, size_t capacity);
+
+      void initialize(void* memory, size_t capacity);
+
+      // Adds or replaces the value for key. Returns a pointer to the stored
+      // value or nullptr if a fixed size map is full.
+      T* insert(uint64 key, const T& value);
+
+      T* find(uint64 key) const;
+
+      bool remove(uint64 key);
+
+      // Removes all items. Memory is kept.
+      void reset();
+
+      size_t count() const;
+
+      size_t getCapacity() const;
+    };
+
+  //
+  // Group probing helpers
+  //
+
+  template<typename T>
+    inline uint64 HashMap<T>::mix(uint64 key)
+    {
+      // Spread sequential keys (like glyph ids) over the whole table
+      key ^= key >> 33;
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= key >> 33;
+      return key;
+    }
+
+  template<typename T>
+    inline uint32 HashMap<T>::firstBit(uint32 mask)
+    {
+#ifdef _MSC_VER
+      unsigned long index;
+      _BitScanForward(&index, mask);
+      return (uint32) index;
+#else
+      return (uint32) __builtin_ctz(mask);
+#endif
+    }
+
+  template<typename T>
+    inline uint32 HashMap<T>::matchGroup(const uint8* group, uint8 value)
+    {
+#ifdef SMOL_HASH_MAP_SSE2
+      __m128i ctrlBytes = _mm_loadu_si128((const __m128i*) group);
+      return (uint32) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrlBytes, _mm_set1_epi8((char) value)));
+#else
+      uint32 mask = 0;
+      for (uint32 i = 0; i < GROUP_SIZE; i++)
+      {
+        if (group[i] == value)
+          mask |= 1 << i;
+      }
+      return mask;
+#endif
+    }
+
+  template<typename T>
+    inline uint32 HashMap<T>::matchEmpty(const uint8* group)
+    {
+      return matchGroup(group, CTRL_EMPTY);
+    }
+
+  template<typename T>
+    inline uint32 HashMap<T>::matchEmptyOrDeleted(const uint8* group)
+    {
+      // Both EMPTY and DELETED have the high bit set, full slots don't.
+#ifdef SMOL_HASH_MAP_SSE2
+      __m128i ctrlBytes = _mm_loadu_si128((const __m128i*) group);
+      return (uint32) _mm_movemask_epi8(ctrlBytes);
+#else
+      uint32 mask = 0;
+      for (uint32 i = 0; i < GROUP_SIZE; i++)
+      {
+        if (group[i] & 0x80)
+          mask |= 1 << i;
+      }
+      return mask;
+#endif
+    }
+
+  //
+  // Memory
+  //
+
+  template<typename T>
+    size_t HashMap<T>::getSlotCount(size_t capacity)
+    {
+      // Keep the load factor at or below 7/8
+      size_t minSlots = capacity + capacity / 7 + 1;
+      size_t slotCount = GROUP_SIZE;
+      while (slotCount < minSlots)
+        slotCount <<= 1;
+      return slotCount;
+    }
+
+  template<typename T>
+    size_t HashMap<T>::getSlotsOffset(size_t slotCount)
+    {
+      const size_t alignment = alignof(Slot);
+      return (slotCount + alignment - 1) & ~(alignment - 1);
+    }
+
+  template<typename T>
+    size_t HashMap<T>::getMemorySize(size_t capacity)
+    {
+      const size_t slotCount = getSlotCount(capacity);
+      return getSlotsOffset(slotCount) + slotCount * sizeof(Slot);
+    }
+
+  template<typename T>
+    void HashMap<T>::setMemory(void* memory, size_t slotCount)
+    {
+      this->slotCount = slotCount;
+      ctrl = (uint8*) memory;
+      slots = (Slot*) (((char*) memory) + getSlotsOffset(slotCount));
+      itemCount = 0;
+      tombstoneCount = 0;
+      memset(ctrl, CTRL_EMPTY, slotCount);
+    }
+
+  template<typename T>
+    HashMap<T>::HashMap():
+      ctrl(nullptr), slots(nullptr), slotCount(0), itemCount(0), tombstoneCount(0), tag(MemoryTag::GENERAL), ownsMemory(false) { }
+
+  template<typename T>
+    HashMap<T>::HashMap(size_t capacity, MemoryTag tag):
+      ctrl(nullptr), slots(nullptr), slotCount(0), itemCount(0), tombstoneCount(0), tag(tag), ownsMemory(false)
+    {
+      initialize(capacity, tag);
+    }
+
+  template<typename T>
+    HashMap<T>::~HashMap()
+    {
+      if (ownsMemory)
+        Platform::freeMemory(ctrl);
+    }
+
+  template<typename T>
+    void HashMap<T>::initialize(size_t capacity, MemoryTag tag)
+    {
+      if (ownsMemory)
+        Platform::freeMemory(ctrl);
+
+      const size_t newSlotCount = getSlotCount(capacity);
+      this->tag = tag;
+      ownsMemory = true;
+      setMemory(Platform::getMemory(getSlotsOffset(newSlotCount) + newSlotCount * sizeof(Slot), alignof(Slot), tag), newSlotCount);
+    }
+
+  template<typename T>
+    void HashMap<T>::initialize(Arena& arena, size_t capacity)
+    {
+      tag = arena.getMemoryTag();
+      ownsMemory = false;
+      setMemory(arena.pushAligned(getMemorySize(capacity), alignof(Slot)), getSlotCount(capacity));
+    }
+
+  template<typename T>
+    void HashMap<T>::initialize(void* memory, size_t capacity)
+    {
+      SMOL_ASSERT(((size_t) memory & (alignof(Slot) - 1)) == 0, "HashMap memory must be aligned to %zu bytes", alignof(Slot));
+      tag = MemoryTag::GENERAL;
+      ownsMemory = false;
+      setMemory(memory, getSlotCount(capacity));
+    }
+
+  template<typename T>
+    void HashMap<T>::rehash(size_t newSlotCount)
+    {
+      uint8* oldCtrl = ctrl;
+      Slot* oldSlots = slots;
+      const size_t oldSlotCount = slotCount;
+
+      setMemory(Platform::getMemory(getSlotsOffset(newSlotCount) + newSlotCount * sizeof(Slot), alignof(Slot), tag), newSlotCount);
+      for (size_t i = 0; i < oldSlotCount; i++)
+      {
+        if ((oldCtrl[i] & 0x80) == 0)
+          insert(oldSlots[i].key, oldSlots[i].value);
+      }
+
+      Platform::freeMemory(oldCtrl);
+    }
+
+  //
+  // Lookup
+  //
+  // Groups are probed with quadratic steps. A lookup stops at the first group
+  // that has an EMPTY slot, since an insert would never have skipped it.
+  //
+
+  template<typename T>
+    typename HashMap<T>::Slot* HashMap<T>::findSlot(uint64 key) const
+    {
+      if (itemCount == 0)
+        return nullptr;
+
+      const uint64 hash = mix(key);
+      const uint8 h2 = (uint8) (hash & 0x7F);
+      const size_t groupMask = (slotCount / GROUP_SIZE) - 1;
+      size_t groupIndex = (size_t) (hash >> 7) & groupMask;
+
+      for (size_t probe = 0; probe <= groupMask; probe++)
+      {
+        const size_t groupStart = groupIndex * GROUP_SIZE;
+        const uint8* group = ctrl + groupStart;
+
+        uint32 match = matchGroup(group, h2);
+        while (match)
+        {
+          const size_t slotIndex = groupStart + firstBit(match);
+          if (slots[slotIndex].key == key)
+            return &slots[slotIndex];
+          match &= match - 1;
+        }
+
+        if (matchEmpty(group))
+          break;
+
+        groupIndex = (groupIndex + probe + 1) & groupMask;
+      }
+
+      return nullptr;
+    }
+
+  template<typename T>
+    T* HashMap<T>::find(uint64 key) const
+    {
+      Slot* slot = findSlot(key);
+      return slot ? &slot->value : nullptr;
+    }
+
+  template<typename T>
+    T* HashMap<T>::insert(uint64 key, const T& value)
+    {
+      Slot* existing = findSlot(key);
+      if (existing)
+      {
+        existing->value = value;
+        return &existing->value;
+      }
+
+      // A default constructed map owns its memory
+      if (!ctrl)
+        initialize(GROUP_SIZE - 2, tag);
+
+      if ((itemCount + tombstoneCount + 1) * 8 > slotCount * 7)
+      {
+        if (!ownsMemory)
+        {
+          if (itemCount + 1 > slotCount - slotCount / 8)
+          {
+            Log::error("HashMap is full. Capacity is fixed at %zu items", slotCount - slotCount / 8);
+            return nullptr;
+          }
+          // A fixed size map can still reuse tombstones below
+        }
+        else
+        {
+          // Grow only if the map is actually full, otherwise just drop the tombstones
+          rehash(itemCount * 2 >= slotCount - slotCount / 8 ? slotCount * 2 : slotCount);
+        }
+      }
+
+      const uint64 hash = mix(key);
+      const uint8 h2 = (uint8) (hash & 0x7F);
+      const size_t groupMask = (slotCount / GROUP_SIZE) - 1;
+      size_t groupIndex = (size_t) (hash >> 7) & groupMask;
+
+      for (size_t probe = 0; probe <= groupMask; probe++)
+      {
+        const size_t groupStart = groupIndex * GROUP_SIZE;
+        const uint32 available = matchEmptyOrDeleted(ctrl + groupStart);
+        if (available)
+        {
+          const size_t slotIndex = groupStart + firstBit(available);
+          if (ctrl[slotIndex] == CTRL_DELETED)
+            tombstoneCount--;
+
+          ctrl[slotIndex] = h2;
+          slots[slotIndex].key = key;
+          slots[slotIndex].value = value;
+          itemCount++;
+          return &slots[slotIndex].value;
+        }
+
+        groupIndex = (groupIndex + probe + 1) & groupMask;
+      }
+
+      Log::error("HashMap failed to find a free slot for key %llu", (unsigned long long) key);
+      return nullptr;
+    }
+
+  template<typename T>
+    bool HashMap<T>::remove(uint64 key)
+    {
+      Slot* slot = findSlot(key);
+      if (!slot)
+        return false;
+
+      const size_t slotIndex = slot - slots;
+      const size_t groupStart = slotIndex & ~((size_t) GROUP_SIZE - 1);
+
+      // If the group still has an EMPTY slot no lookup ever probed past it, so
+      // the slot can go back to EMPTY instead of leaving a tombstone.
+      if (matchEmpty(ctrl + groupStart))
+      {
+        ctrl[slotIndex] = CTRL_EMPTY;
+      }
+      else
+      {
+        ctrl[slotIndex] = CTRL_DELETED;
+        tombstoneCount++;
+      }
+
+      itemCount--;
+      return true;
+    }
+
+  template<typename T>
+    void HashMap<T>::reset()
+    {
+      if (ctrl)
+        memset(ctrl, CTRL_EMPTY, slotCount);
+      itemCount = 0;
+      tombstoneCount = 0;
+    }
+
+  template<typename T>
+    inline size_t HashMap<T>::count() const { return itemCount; }
+
+  template<typename T>
+    inline size_t HashMap<T>::getCapacity() const { return slotCount - slotCount / 8; }
+}
+
+#undef SMOL_HASH_MAP_SSE2
+#endif  // SMOL_HASH_MAP_H
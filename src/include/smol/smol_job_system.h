@@ -0,0 +1,90 @@
+#ifndef SMOL_JOB_SYSTEM_H
+#define SMOL_JOB_SYSTEM_H
+
+#include <smol/smol_engine.h>
+#include <atomic>
+
+namespace smol
+{
+  struct Thread;
+  struct Semaphore;
+  struct Job;
+  struct JobQueue;
+
+  typedef void (*JobFunction)(void* data);
+  typedef void (*ParallelForFunction)(int32 start, int32 end, void* data);
+
+  // Counts unfinished jobs. Pass it to JobSystem::run() and wait on it with
+  // JobSystem::wait() or use it as a dependency for other jobs.
+  // A counter must outlive every job that references it.
+  struct SMOL_ENGINE_API JobCounter
+  {
+    std::atomic<int32> value;
+    std::atomic<int32> lock;
+    Job* waitingJobs;               // jobs that depend on this counter
+
+    JobCounter();
+    bool isDone() const;
+
+    // Disallow copies
+    JobCounter(const JobCounter& other) = delete;
+    void operator=(const JobCounter& other) = delete;
+  };
+
+  // Work stealing job scheduler. Every worker thread owns a queue. Threads push
+  // and pop jobs from the bottom of their own queue and steal from the top of
+  // other queues when theirs is empty.
+  //
+  // Jobs can be scheduled from the main thread or from inside other jobs.
+  // The FrameAllocator is not thread safe so jobs must not push to it. Memory
+  // they need must be allocated by whoever schedules them.
+  class SMOL_ENGINE_API JobSystem final
+  {
+    Thread** threads;
+    JobQueue* queues;               // one per thread. Index 0 is the main thread
+    Semaphore* wakeUp;
+    int32 workerCount;
+    std::atomic<int32> sleepingWorkers;
+    std::atomic<bool> running;
+    JobSystem();
+
+    static uint32 workerThreadEntryPoint(void* data);
+    Job* allocateJob();
+    Job* getJob();
+    void schedule(Job* job);
+    void execute(Job* job);
+    void wakeWorkers(int32 count);
+
+    public:
+    static JobSystem& get();
+
+    // Starts workerCount worker threads. If workerCount is negative, starts
+    // one worker per logical processor, not counting the calling thread.
+    // The calling thread becomes the main thread of the job system.
+    bool initialize(int32 workerCount = -1);
+    void shutdown();
+    bool isInitialized() const;
+    int32 getWorkerCount() const;
+
+    // Schedules function(data). counter is incremented now and decremented
+    // when the job finishes. The job only starts after dependency reaches
+    // zero. If the job system is not initialized the job runs immediately.
+    void run(JobFunction function, void* data, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+    // Runs jobs until counter reaches zero. The calling thread executes jobs
+    // while it waits, so it's safe to call it from inside a job.
+    void wait(JobCounter* counter);
+
+    // Calls function(start, end, data) for consecutive ranges of at most
+    // batchSize elements covering [0, count) and waits for all of them.
+    void parallelFor(int32 count, int32 batchSize, ParallelForFunction function, void* data);
+
+    // Disallow copies
+    JobSystem(const JobSystem& other) = delete;
+    JobSystem(const JobSystem&& other) = delete;
+    void operator=(const JobSystem& other) = delete;
+    void operator=(const JobSystem&& other) = delete;
+  };
+}
+
+#endif  // SMOL_JOB_SYSTEM_H
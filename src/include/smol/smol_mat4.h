@@ -6,6 +6,8 @@
 
 namespace smol
 {
+  struct Quaternion;
+
   struct SMOL_ENGINE_API Mat4
   {
     float e[4][4];    // Access the matrix members as a 2 dimentional array
@@ -15,16 +17,32 @@ namespace smol
     static Mat4 initScale(float x, float y, float z);
     static Mat4 initTranslation(float x, float y, float z);
     static Mat4 initRotation(float x, float y, float z);
+
+    // Builds translation * rotation * scale directly. Rotation is in degrees
+    // and matches initRotation().
+    static Mat4 fromTRS(const Vector3& position, const Vector3& rotation, const Vector3& scale);
+
+    // Same as above with the rotation given by a normalized quaternion. No trigonometry involved.
+    static Mat4 fromTRS(const Vector3& position, const Quaternion& rotation, const Vector3& scale);
+    static Mat4 initRotation(const Quaternion& rotation);
     static Mat4 perspective(float fov, float aspect, float zNear, float zFar);
     static Mat4 ortho(float left, float right, float top, float bottom, float zNear, float zFar);
     static Mat4 transpose(const Mat4& m);
     static Mat4 invert(const Mat4& m);
+
+    // Inverse of a matrix whose last row is (0, 0, 0, 1), like any matrix
+    // built from translation, rotation and scale. Much cheaper than invert().
+    static Mat4 affineInvert(const Mat4& m);
     static Mat4 mul(const Mat4& a, const Mat4& b);
     static Vector3 mul(const Mat4& a, const Vector3& b);
 
+    // out[i] = a[i] * b[i] for count matrices. out may alias a or b.
+    static void mulBatch(const Mat4* a, const Mat4* b, Mat4* out, size_t count);
+
     Mat4& mul(const Mat4& other);
     Mat4 transposed() const;
     Mat4 inverse() const;
+    Mat4 affineInverse() const;
   };
 }
 
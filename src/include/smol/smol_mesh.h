@@ -3,6 +3,7 @@
 
 #include <smol/smol_engine.h>
 #include <smol/smol_handle_list.h>
+#include <smol/smol_bounds.h>
 
 #define SMOL_GL_DEFINE_EXTERN
 #include <smol/smol_gl.h> //TODO(marcio): Make this API independent. Remove all GL specifics from this header
@@ -25,6 +26,7 @@ namespace smol
       UV1 = 2,
       NORMAL = 3,
       COLOR = 4,
+      INSTANCE_MODEL = 5,   // per instance mat4. Takes locations 5 to 8.
       INDEX // this one does not point to an attribute buffer
     };
     bool dynamic;
@@ -41,6 +43,14 @@ namespace smol
     size_t indicesArraySize;
     unsigned int numIndices;
     unsigned int numVertices;
+    AABB boundingBox;                 // local space bounds of the vertex positions
+    BoundingSphere boundingSphere;
+
+    // CPU copy of the triangles for exact raycasts. Only triangle meshes keep
+    // one, and only when SMOL_MESH_KEEP_TRIANGLES is enabled. indices is null
+    // for meshes without an index buffer.
+    Vector3* positions;
+    unsigned int* indices;
   };
 
   template class SMOL_ENGINE_API smol::HandleList<smol::Mesh>;
@@ -22,8 +22,36 @@
 
 namespace smol
 {
+  // Every allocation made through the Platform is accounted to a MemoryTag.
+  enum class MemoryTag : uint8
+  {
+    GENERAL = 0,
+    ARENA,
+    HANDLE_LIST,
+    CONFIG,
+    FILE_BUFFER,
+    IMAGE,
+    POOL,
+    FRAME,
+    PACKAGE,
+    COUNT
+  };
+
+  struct MemoryStats
+  {
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t budgetBytes;         // 0 means no budget
+    uint32 liveAllocations;
+    uint64 totalAllocations;
+    uint32 frameAllocations;    // allocations made during the last frame
+    size_t frameBytes;          // bytes allocated during the last frame
+  };
+
   struct Window;
   struct Module;
+  struct Thread;
+  struct Semaphore;
   struct MouseState;
   struct KeyboardState;
 
@@ -34,6 +62,8 @@ namespace smol
       MAX_PATH_LEN = 1024
     };
 
+    typedef uint32 (*ThreadFunction)(void* data);
+
 #ifndef SMOL_MODULE_GAME
     // Basic windowing functions
     static Window* createWindow(int32 width, int32 height, const char* title);
@@ -66,21 +96,49 @@ namespace smol
     static void showCursor(bool status);
 
     // File handling
-    static char* loadFileToBuffer(const char* fileName, size_t* loadedFileSize=nullptr, size_t extraBytes=0, size_t offset=0);
+    static char* loadFileToBuffer(const char* fileName, size_t* loadedFileSize=nullptr, size_t extraBytes=0, size_t offset=0, MemoryTag tag = MemoryTag::FILE_BUFFER);
     static char* loadFileToBufferNullTerminated(const char* fileName, size_t* fileSize = nullptr);
     static void unloadFileBuffer(const char* fileBuffer);
     static const char* getBinaryPath();
 
     // Memory management
-    static void* getMemory(size_t size);
-    static void* resizeMemory(void* memory, size_t);
+    static void* getMemory(size_t size, size_t alignment = 0, MemoryTag tag = MemoryTag::GENERAL);
+    static void* resizeMemory(void* memory, size_t, size_t alignment = 0, MemoryTag tag = MemoryTag::GENERAL); // tag is only used when memory is null
     static void freeMemory(void* memory);
 
+    // Virtual memory
+    static size_t getMemoryPageSize();
+    static void* reserveMemory(size_t size);
+    static bool commitMemory(void* memory, size_t size, MemoryTag tag = MemoryTag::GENERAL);
+    static void decommitMemory(void* memory, size_t size, MemoryTag tag = MemoryTag::GENERAL);
+    static void releaseMemory(void* memory, size_t size);
+
+    // Memory tracking
+    static const MemoryStats& getMemoryStats(MemoryTag tag);
+    static const MemoryStats& getTotalMemoryStats();
+    static const char* getMemoryTagName(MemoryTag tag);
+    static void setMemoryBudget(MemoryTag tag, size_t bytes);
+    static void beginMemoryFrame();   // call once per frame to update frame allocation rates
+    static void dumpMemoryStats();
+
     // Time
     static uint64 getTicks();   // return number of ticks since platform startup
     static float getMillisecondsBetweenTicks(uint64 start, uint64 end);
     static float getSecondsSinceStartup();
 
+    // Threads
+    static Thread* createThread(ThreadFunction function, void* data);
+    static void waitThread(Thread* thread);    // waits for the thread to finish and releases it
+    static uint32 getProcessorCount();          // logical processors
+    static uint32 getCurrentThreadId();
+    static void yieldThread();
+
+    // Counting semaphores
+    static Semaphore* createSemaphore(uint32 initialCount = 0);
+    static void destroySemaphore(Semaphore* semaphore);
+    static void waitSemaphore(Semaphore* semaphore);
+    static void signalSemaphore(Semaphore* semaphore, uint32 count = 1);
+
     // get/set working directory
     static bool getWorkingDirectory(char* buffer, size_t buffSize);
     static bool setWorkingDirectory(const char* buffer);
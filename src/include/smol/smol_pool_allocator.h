@@ -0,0 +1,93 @@
+#ifndef SMOL_POOL_ALLOCATOR_H
+#define SMOL_POOL_ALLOCATOR_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_arena.h>
+
+// Size classes are powers of two from SMOL_POOL_MIN_BLOCK_SIZE to
+// SMOL_POOL_MAX_BLOCK_SIZE. Anything larger goes straight to the Platform.
+#define SMOL_POOL_MIN_BLOCK_SIZE 64
+#define SMOL_POOL_MAX_BLOCK_SIZE KILOBYTE(16)
+#define SMOL_POOL_SIZE_CLASS_COUNT 9
+
+#ifndef SMOL_POOL_CHUNK_SIZE
+#define SMOL_POOL_CHUNK_SIZE KILOBYTE(64)
+#endif
+
+namespace smol
+{
+  struct PoolAllocatorStats
+  {
+    struct SizeClass
+    {
+      size_t blockSize;
+      uint32 blocksInUse;
+      uint32 blocksFree;
+      uint32 peakBlocksInUse;
+    };
+
+    SizeClass sizeClass[SMOL_POOL_SIZE_CLASS_COUNT];
+    size_t requestedBytes;        // bytes asked for by live allocations
+    size_t usedBytes;             // bytes of blocks handed out, including rounding waste
+    size_t peakUsedBytes;
+    size_t reservedBytes;         // bytes of chunks owned by the pool
+    size_t peakReservedBytes;
+    size_t largeBytes;            // live allocations larger than SMOL_POOL_MAX_BLOCK_SIZE
+    size_t peakLargeBytes;
+    uint32 allocationCount;       // live allocations
+    uint32 chunkCount;
+    float internalFragmentation;  // 1 - requestedBytes / usedBytes
+    float externalFragmentation;  // 1 - usedBytes / reservedBytes
+  };
+
+  // Hands out small blocks from free lists of fixed size classes. Blocks are
+  // carved from large chunks so many small, long lived allocations don't hit
+  // the system allocator. Every block is aligned to SMOL_POOL_MIN_BLOCK_SIZE.
+  // Chunks are only returned to the system when the allocator is destroyed.
+  class SMOL_ENGINE_API PoolAllocator final
+  {
+    struct FreeBlock
+    {
+      FreeBlock* next;
+    };
+
+    struct Chunk
+    {
+      Chunk* next;
+    };
+
+    FreeBlock* freeList[SMOL_POOL_SIZE_CLASS_COUNT];
+    Chunk* chunks;
+    PoolAllocatorStats stats;
+
+    bool addChunk(uint32 sizeClassIndex);
+
+    public:
+    PoolAllocator();
+    ~PoolAllocator();
+
+    // The engine wide pool
+    static PoolAllocator& get();
+
+    // Returns a block of at least size bytes.
+    void* getMemory(size_t size);
+
+    // size must be the same size passed to getMemory().
+    void freeMemory(void* memory, size_t size);
+
+    // Returns the amount of memory actually reserved for an allocation of size bytes.
+    static size_t getBlockSize(size_t size);
+
+    PoolAllocatorStats getStats() const;
+
+    void logStats() const;
+
+    // Disallow copies
+    PoolAllocator(const PoolAllocator& other) = delete;
+    PoolAllocator(const PoolAllocator&& other) = delete;
+    void operator=(const PoolAllocator& other) = delete;
+    void operator=(const PoolAllocator&& other) = delete;
+  };
+}
+
+#endif //SMOL_POOL_ALLOCATOR_H
@@ -0,0 +1,46 @@
+#ifndef SMOL_QUATERNION
+#define SMOL_QUATERNION
+
+#include <smol/smol_engine.h>
+#include <smol/smol_vector3.h>
+
+namespace smol
+{
+  // Unit quaternion used to represent rotations.
+  // Euler angles are in degrees and follow the same convention as
+  // Mat4::initRotation(): Rz * Ry * Rx.
+  struct SMOL_ENGINE_API Quaternion
+  {
+    float x;
+    float y;
+    float z;
+    float w;
+
+    Quaternion();
+    Quaternion(float x, float y, float z, float w);
+
+    static Quaternion identity();
+    static Quaternion fromEuler(float x, float y, float z);
+    static Quaternion fromEuler(const Vector3& degrees);
+    static Quaternion fromAxisAngle(const Vector3& axis, float degrees);
+
+    // a * b applies b first, then a.
+    static Quaternion mul(const Quaternion& a, const Quaternion& b);
+    static float dot(const Quaternion& a, const Quaternion& b);
+
+    // Normalized linear interpolation. Cheap, but the angular speed is not constant.
+    static Quaternion nlerp(const Quaternion& a, const Quaternion& b, float t);
+
+    // Spherical linear interpolation. Constant angular speed.
+    static Quaternion slerp(const Quaternion& a, const Quaternion& b, float t);
+
+    // Rotates v by this quaternion. The quaternion must be normalized.
+    Vector3 rotate(const Vector3& v) const;
+    Vector3 toEuler() const;
+    Quaternion conjugated() const;
+    Quaternion& normalize();
+    float length() const;
+  };
+}
+
+#endif  // SMOL_QUATERNION
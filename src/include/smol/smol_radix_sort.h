@@ -0,0 +1,28 @@
+#ifndef SMOL_RADIX_SORT_H
+#define SMOL_RADIX_SORT_H
+
+#include <smol/smol_engine.h>
+
+namespace smol
+{
+  // Stable LSD radix sort of 64bit keys, 8 bits per pass.
+  // Only the lowest keyBits bits of each key are compared, the remaining bits
+  // are carried along untouched. Passes where every key has the same digit
+  // are skipped.
+  // temp must be large enough for count keys. The sorted keys end up either
+  // on keys or on temp. The returned pointer tells which one.
+  SMOL_ENGINE_API uint64* radixSort(uint64* keys, uint64* temp, uint32 count, uint32 keyBits = 64);
+
+  // Same as radixSort() but histograms and scatters are split across the
+  // JobSystem workers. Small arrays, or when the JobSystem is not initialized,
+  // are sorted on the calling thread.
+  SMOL_ENGINE_API uint64* radixSortParallel(uint64* keys, uint64* temp, uint32 count, uint32 keyBits = 64);
+
+  // Sorts keys that are expected to be close to sorted order, like keys that
+  // were sorted last frame and changed a little. Already sorted input costs a
+  // single read. Input with few keys out of place is insertion sorted and
+  // anything else falls back to radixSortParallel(). Same contract as radixSort().
+  SMOL_ENGINE_API uint64* adaptiveSort(uint64* keys, uint64* temp, uint32 count, uint32 keyBits = 64);
+}
+
+#endif  // SMOL_RADIX_SORT_H
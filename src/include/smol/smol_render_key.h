@@ -0,0 +1,68 @@
+#ifndef SMOL_RENDER_KEY_H
+#define SMOL_RENDER_KEY_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_renderer_types.h>
+#include <smol/smol_scene_node.h>
+
+namespace smol
+{
+  // Camera render keys are built for every camera from the scene render keys.
+  // Only the lower 41 bits are sorted. The node index rides along on top.
+  //
+  // Opaque and every other queue draw front-to-back inside coarse depth slices
+  // so materials still get batched within a slice:
+  // 64-----------41-------40-------32------------28--------------12-----------0
+  // node index    | culled | queue  | depth >> 12 | material rank | depth & 0xFFF
+  //
+  // Transparent draws back-to-front:
+  // 64-----------41-------40-------32------------------16--------------0
+  // node index    | culled | queue  | 0xFFFF - depth    | material rank
+  //
+  // Material rank is the position of the material when sorted by shader and
+  // then by texture, so similar materials end up next to each other.
+  // Meshes outside the camera frustum have the culled bit set so they sort
+  // after everything that is drawn.
+  //
+  // Sprites and text are drawn by their batcher all at once, so they have no
+  // view depth. Each type gets a depth of its own past the deepest mesh. That
+  // keeps the sprites of a batcher next to each other even when text nodes
+  // share their material.
+  const uint32 CAMERA_RENDER_KEY_BITS = 41;
+  const uint64 CAMERA_RENDER_KEY_CULLED = 1ULL << 40;
+  const uint32 RENDER_KEY_SPRITE_DEPTH = 0xFFFF;
+  const uint32 RENDER_KEY_TEXT_DEPTH = 0xFFFE;
+  const uint32 RENDER_KEY_MAX_DEPTH = 0xFFFD;   // deepest mesh
+
+  inline uint64 encodeCameraRenderKey(uint32 nodeIndex, uint8 queue, uint16 materialRank, uint32 depth)
+  {
+    uint64 key = ((uint64) nodeIndex) << CAMERA_RENDER_KEY_BITS | ((uint64) queue) << 32;
+    if (queue == RenderQueue::QUEUE_TRANSPARENT)
+      key |= ((uint64) (RENDER_KEY_SPRITE_DEPTH - depth)) << 16 | materialRank;
+    else
+      key |= ((uint64) (depth >> 12)) << 28 | ((uint64) materialRank) << 12 | (depth & 0xFFF);
+    return key;
+  }
+
+  // Key of a SPRITE or TEXT node
+  inline uint64 encodeBatchedCameraRenderKey(SceneNode::Type type, uint32 nodeIndex, uint8 queue, uint16 materialRank)
+  {
+    const uint32 depth = type == SceneNode::TEXT ? RENDER_KEY_TEXT_DEPTH : RENDER_KEY_SPRITE_DEPTH;
+    return encodeCameraRenderKey(nodeIndex, queue, materialRank, depth);
+  }
+
+  inline uint32 getNodeIndexFromCameraRenderKey(uint64 key)
+  {
+    return (uint32) (key >> CAMERA_RENDER_KEY_BITS);
+  }
+
+  inline uint32 getMaterialRankFromCameraRenderKey(uint64 key)
+  {
+    const uint8 queue = (uint8) (key >> 32);
+    if (queue == RenderQueue::QUEUE_TRANSPARENT)
+      return (uint32) key & 0xFFFF;
+    return ((uint32) key >> 12) & 0xFFFF;
+  }
+}
+
+#endif  // SMOL_RENDER_KEY_H
@@ -82,6 +82,16 @@ namespace smol
 
     static void updateGlobalShaderParams(const Mat4& proj, const Mat4& view, const Mat4& model, float deltaTime);
 
+    // Uploads the camera and per frame part of the global shader params.
+    // Call it once per camera and updateModelMatrix() once per draw.
+    static void updateCameraShaderParams(const Mat4& proj, const Mat4& view, const Mat4& viewProj, float deltaTime);
+    static void updateModelMatrix(const Mat4& model);
+
+    // Draws count copies of the mesh in one call, one per model matrix.
+    // The current material shader must support instancing.
+    static bool isInstancingSupported(const Material* material);
+    static void drawMeshInstanced(const Mesh& mesh, const Mat4* modelMatrices, uint32 count);
+
     //
     // Render Target
     //
@@ -11,12 +11,30 @@
 #include <smol/smol_color.h>
 #include <smol/smol_scene_node.h>
 #include <smol/smol_sprite_batcher.h>
+#include <smol/smol_event_manager.h>
+#include <float.h>
 
 namespace smol
 {
   struct Image;
   struct MeshData;
   struct ResourceManager;
+  struct SceneRenderQueue;
+  struct SceneSpatialIndex;
+  struct AABB;
+  struct Frustum;
+  struct Rectf;
+  struct Ray;
+  struct Point2;
+
+  struct SMOL_ENGINE_API RaycastHit
+  {
+    Handle<SceneNode> node;
+    Vector3 point;                // world space
+    float distance;               // in multiples of the ray direction
+    int32 triangle;               // -1 when the node was hit by its bounds only
+  };
+
   struct SMOL_ENGINE_API Scene final
   {
     private:
@@ -24,14 +42,22 @@ namespace smol
       HandleList<Renderable> renderables;
       HandleList<SceneNode> nodes;
       HandleList<SpriteBatcher> batchers;
-      Arena renderKeys;
-      Arena renderKeysSorted;
       Handle<smol::Texture> defaultTexture;
       Handle<smol::ShaderProgram> defaultShader;
       Handle<smol::Material> defaultMaterial;
       Mat4 viewMatrix;
+      EventHandlerId eventHandler;
+      SceneRenderQueue* renderQueue;     // render keys kept between frames
+      SceneSpatialIndex* spatialIndex;   // bounds of mesh, sprite and text nodes
 
     public:
+      // Per node state computed by updateTransforms()
+      enum NodeState : uint8
+      {
+        NODE_ACTIVE             = 1,      // active in hierarchy
+        NODE_TRANSFORM_CHANGED  = 1 << 1  // world matrix was recomputed this frame
+      };
+
       Scene();
       ~Scene();
 
@@ -42,6 +68,7 @@ namespace smol
       Handle<Renderable> createRenderable(Handle<Material> material, Handle<Mesh> mesh);
       void destroyRenderable(Handle<Renderable> handle);
       void destroyRenderable(Renderable* renderable);
+      void setRenderableMaterial(Handle<Renderable> handle, Handle<Material> material);
 
       Handle<SpriteBatcher> createSpriteBatcher(Handle<Material> material, int capacity = 32);
       void setSpriteBatcherMode(Handle<SpriteBatcher> handle);
@@ -53,13 +80,74 @@ namespace smol
 #ifndef SMOL_MODULE_GAME
       Handle<SceneNode> createNode(SceneNode::Type type, const Transform& transform);
       void destroyNode(Handle<SceneNode> handle);
+
+      // Creates count nodes of the same type in one go. transforms must have
+      // count elements and handles must have room for count handles.
+      void createNodes(int count, SceneNode::Type type, const Transform* transforms, Handle<SceneNode>* handles);
+      void destroyNodes(const Handle<SceneNode>* handles, int count);
 #endif
 
       //
       // Render
       //
+
+      // Updates the world matrix of every active node in a single linear pass,
+      // visiting parents before their children. Returns one NodeState mask per
+      // node, indexed like getNodes(). The result lives in frame memory.
+      const uint8* updateTransforms();
+
       void render(float deltaTime);
 
+      // Appends render keys for nodes created since the last call, or rebuilds
+      // them all after invalidateRenderQueue(). nodeState comes from
+      // updateTransforms(). Returns true if the keys changed.
+      bool updateRenderQueue(const uint8* nodeState);
+
+      // Render keys as of the last updateRenderQueue(), in node order. The
+      // node index is on the upper 32 bits. Cameras have keys of their own.
+      const uint64* getRenderKeys(int32* count) const;
+      const uint64* getCameraRenderKeys(int32* count) const;
+
+      // Render keys and the spatial index are kept between frames and only
+      // rebuilt when something they depend on changes. Node creation,
+      // destruction, activation and parenting are tracked by the scene, and
+      // ResourceManager::updateMesh() calls it when mesh bounds change. Call it
+      // after changing what a node draws or a parent through Transform::setParent().
+      void invalidateRenderQueue();
+
+      //
+      // Spatial queries
+      //
+
+      // Mesh nodes are indexed by the world bounds of their mesh on a dynamic
+      // AABB tree kept up to date by updateTransforms(). Queries return
+      // handles of active mesh nodes and might include nodes slightly outside
+      // the volume. They return how many handles were written to results.
+      int32 queryNodes(const AABB& box, Handle<SceneNode>* results, int32 maxResults) const;
+      int32 queryNodes(const Frustum& frustum, Handle<SceneNode>* results, int32 maxResults) const;
+
+      // The k nodes closest to point, closest first
+      int32 queryNearestNodes(const Vector3& point, int32 k, Handle<SceneNode>* results) const;
+
+      // Active sprite and text nodes whose quads overlap rect on the XY plane,
+      // from a spatial hash also kept up to date by updateTransforms().
+      // rect.x and rect.y are its minimum corner.
+      int32 queryNodes(const Rectf& rect, Handle<SceneNode>* results, int32 maxResults) const;
+
+      // Active mesh nodes on layerMask hit by the ray before maxDistance,
+      // closest first. Candidates come from the AABB tree and are tested
+      // against their mesh bounds and, when exact is set and the mesh kept its
+      // triangles, against every triangle. Returns how many hits were written.
+      int32 raycast(const Ray& ray, uint32 layerMask, RaycastHit* hits, int32 maxHits,
+          float maxDistance = FLT_MAX, bool exact = true) const;
+
+      // Closest mesh node under a pixel of the screen seen by a camera node.
+      // screenPoint starts at the top left corner like the mouse cursor.
+      // Returns an invalid handle if nothing visible is there.
+      Handle<SceneNode> pick(const Point2& screenPoint, Handle<SceneNode> camera, RaycastHit* hit = nullptr) const;
+
+      bool onEvent(const Event& event);
+
 
       // Disallow copies
       Scene(const Scene& other) = delete;
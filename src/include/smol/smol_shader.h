@@ -23,6 +23,7 @@ namespace smol
 
       Type type;
       char name[SMOL_MAX_SHADER_PARAMETER_NAME_LEN];
+      uint64 hash;        // stringToHash(name)
 
       union
       {
@@ -35,6 +36,7 @@ namespace smol
   struct SMOL_ENGINE_API ShaderProgram
   {
     bool valid;
+    bool instancing;    // declares smolInstanceModel and can draw instances
     union
     {
       unsigned int glProgramId;
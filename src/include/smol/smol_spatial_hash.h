@@ -0,0 +1,77 @@
+#ifndef SMOL_SPATIAL_HASH_H
+#define SMOL_SPATIAL_HASH_H
+
+#include <smol/smol_engine.h>
+#include <smol/smol_rect.h>
+
+namespace smol
+{
+  struct SpatialHashProxy;
+  struct SpatialHashEntry;
+
+  // Return false to stop the query
+  typedef bool (*SpatialHashQueryCallback)(uint64 userData, void* context);
+
+  // Uniform grid over the XY plane for 2D objects. Cells are hashed into a
+  // bucket table, so the world has no bounds and empty space costs nothing.
+  // Rects use x and y as their minimum corner.
+  //
+  // Every proxy is linked to the cells its rect touches. Moving a proxy
+  // without leaving its cells only stores the new rect. Proxies that cover
+  // too many cells are kept on a separate list tested by every query.
+  //
+  // Proxies are ids returned by insert(). They stay valid until removed.
+  // The hash is not thread safe.
+  struct SMOL_ENGINE_API SpatialHash
+  {
+    private:
+      SpatialHashProxy* proxies;
+      SpatialHashEntry* entries;
+      int32* buckets;
+      int32* largeProxies;
+      int32 proxyCapacity;
+      int32 entryCapacity;
+      int32 bucketCount;
+      int32 largeCapacity;
+      int32 largeCount;
+      int32 freeProxy;
+      int32 freeEntry;
+      int32 proxyCount;
+      int32 entryCount;
+      float cellSize;
+      float inverseCellSize;
+
+      int32 allocateEntry();
+      void link(int32 proxy);
+      void unlink(int32 proxy);
+      void rehash(int32 newBucketCount);
+
+    public:
+      SpatialHash();
+      SpatialHash(float cellSize);
+      ~SpatialHash();
+
+      int32 insert(const Rectf& rect, uint64 userData);
+      void remove(int32 proxy);
+
+      // Returns true if the proxy had to be moved to other cells.
+      bool update(int32 proxy, const Rectf& rect);
+
+      uint64 getUserData(int32 proxy) const;
+      const Rectf& getRect(int32 proxy) const;
+      int32 getProxyCount() const;
+      float getCellSize() const;
+      void reset();
+
+      // Reports every proxy whose rect overlaps rect exactly once.
+      void query(const Rectf& rect, SpatialHashQueryCallback callback, void* context) const;
+
+      // Disallow copies
+      SpatialHash(const SpatialHash& other) = delete;
+      SpatialHash(const SpatialHash&& other) = delete;
+      void operator=(const SpatialHash& other) = delete;
+      void operator=(const SpatialHash&& other) = delete;
+  };
+}
+
+#endif  // SMOL_SPATIAL_HASH_H
@@ -16,7 +16,7 @@ namespace smol
   {
     Handle<SpriteBatcher> batcher;
     Rect rect;
-    float width;
+    float width;      // change the size with setSize()
     float height;
     Color color1;
     Color color2;
@@ -33,6 +33,9 @@ namespace smol
 
   static void destroy(Handle<SceneNode> handle);
 
+  // Sprites are culled by their size, so resizing lets the scene index the
+  // node again.
+  void setSize(float width, float height);
   };
 }
 #endif //SMOL_SPRITE_NODE_H
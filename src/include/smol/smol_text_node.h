@@ -18,7 +18,6 @@ namespace smol
 
   struct SMOL_ENGINE_API TextNode final : public NodeComponent
   {
-    Arena arena;
     Handle<Font> font;
     Handle<SpriteBatcher> batcher;
     Color color;
@@ -26,6 +25,7 @@ namespace smol
     Vector3 center;
     Vector2 textBounds;
     size_t textLen;
+    size_t memorySize;        // size of the PoolAllocator block holding drawData and text
     float lineHeightScale;
     char* text;
     GlyphDrawData* drawData;
@@ -33,6 +33,7 @@ namespace smol
 
     void setText(const char* text);
     const char* getText() const;
+    void freeText();
 
     static Handle<SceneNode> create(
         Handle<SpriteBatcher> batcher,
@@ -3,6 +3,7 @@
 
 #include <smol/smol_engine.h>
 #include <smol/smol_vector3.h>
+#include <smol/smol_quaternion.h>
 #include <smol/smol_mat4.h>
 #include <smol/smol_handle_list.h>
 
@@ -14,8 +15,10 @@ namespace smol
   class SMOL_ENGINE_API Transform
   {
     Vector3 position;
-    Vector3 rotation;
+    Quaternion rotation;              // always normalized
     Vector3 scale;
+    mutable Vector3 eulerRotation;    // degrees. Derived from rotation on demand
+    mutable bool eulerDirty;
     bool dirty;
     Handle<SceneNode> parent;
     Mat4 model;
@@ -33,6 +36,10 @@ namespace smol
 
     bool update(const Scene& scene);
 
+    // Computes the world matrix from parentMatrix and the local position,
+    // rotation and scale. It does not look at the dirty flag.
+    void updateMatrix(const Mat4& parentMatrix);
+
     const Mat4& getMatrix() const;
 
     Transform& setPosition(float x, float y, float z);
@@ -47,6 +54,8 @@ namespace smol
 
     Transform& setRotation(const Vector3& rotation);
 
+    Transform& setRotation(const Quaternion& rotation);
+
     Transform& setParent(Handle<SceneNode> parent);
 
     Transform& unparent();
@@ -55,8 +64,13 @@ namespace smol
 
     const Vector3& getScale() const;
 
+    // Rotation as Euler angles in degrees. When the rotation was set from a
+    // quaternion the angles are recomputed from it and may differ from the
+    // ones originally passed to setRotation().
     const Vector3& getRotation() const;
 
+    const Quaternion& getRotationQuaternion() const;
+
     Handle<SceneNode> getParent() const;
 
     void setDirty(bool value);
@@ -64,6 +78,9 @@ namespace smol
     // returns true if the node or it's parents have changed this frame.
     bool isDirty(const Scene& scene) const;
 
+    // returns true if the node has changed this frame, ignoring it's parents.
+    bool isLocalDirty() const;
+
   };
 }
 #endif  // SMOL_TRANSFORM_H
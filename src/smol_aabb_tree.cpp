@@ -0,0 +1,536 @@
+#include <smol/smol_aabb_tree.h>
+#include <smol/smol_platform.h>
+#include <smol/smol_log.h>
+
+// Build option: how much leaf boxes grow on every side, in world units.
+#ifndef SMOL_AABB_TREE_MARGIN
+#define SMOL_AABB_TREE_MARGIN 0.1f
+#endif
+
+namespace smol
+{
+  const int32 AABB_TREE_NULL_NODE = -1;
+  const int32 AABB_TREE_STACK_SIZE = 256;
+
+  struct AABBTreeNode
+  {
+    AABB box;
+    uint64 userData;
+    union
+    {
+      int32 parent;
+      int32 next;                 // next free node when on the free list
+    };
+    int32 child1;
+    int32 child2;
+    int32 height;                 // 0 for leaves, -1 for free nodes
+
+    inline bool isLeaf() const { return child1 == AABB_TREE_NULL_NODE; }
+  };
+
+  static inline AABB fatten(const AABB& box, float margin)
+  {
+    return AABB(
+        Vector3(box.min.x - margin, box.min.y - margin, box.min.z - margin),
+        Vector3(box.max.x + margin, box.max.y + margin, box.max.z + margin));
+  }
+
+  static inline int32 maxHeight(int32 a, int32 b)
+  {
+    return a > b ? a : b;
+  }
+
+  AABBTree::AABBTree():
+    nodes(nullptr), capacity(0), root(AABB_TREE_NULL_NODE), freeList(AABB_TREE_NULL_NODE), proxyCount(0) { }
+
+  AABBTree::~AABBTree()
+  {
+    Platform::freeMemory(nodes);
+  }
+
+  int32 AABBTree::allocateNode()
+  {
+    if (freeList == AABB_TREE_NULL_NODE)
+    {
+      const int32 oldCapacity = capacity;
+      capacity = capacity > 0 ? capacity * 2 : 64;
+      nodes = (AABBTreeNode*) Platform::resizeMemory(nodes, capacity * sizeof(AABBTreeNode));
+
+      for (int32 i = oldCapacity; i < capacity; i++)
+      {
+        nodes[i].next = i + 1;
+        nodes[i].height = -1;
+      }
+      nodes[capacity - 1].next = AABB_TREE_NULL_NODE;
+      freeList = oldCapacity;
+    }
+
+    const int32 node = freeList;
+    freeList = nodes[node].next;
+    nodes[node].parent = AABB_TREE_NULL_NODE;
+    nodes[node].child1 = AABB_TREE_NULL_NODE;
+    nodes[node].child2 = AABB_TREE_NULL_NODE;
+    nodes[node].height = 0;
+    nodes[node].userData = 0;
+    return node;
+  }
+
+  void AABBTree::freeNode(int32 node)
+  {
+    nodes[node].next = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+  }
+
+  int32 AABBTree::insert(const AABB& box, uint64 userData)
+  {
+    const int32 proxy = allocateNode();
+    nodes[proxy].box = fatten(box, SMOL_AABB_TREE_MARGIN);
+    nodes[proxy].userData = userData;
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+  }
+
+  void AABBTree::remove(int32 proxy)
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < capacity && nodes[proxy].height == 0, "Invalid AABBTree proxy %d", proxy);
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+  }
+
+  bool AABBTree::update(int32 proxy, const AABB& box)
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < capacity && nodes[proxy].height == 0, "Invalid AABBTree proxy %d", proxy);
+
+    // Still inside its fat box and the fat box is not much larger than needed
+    const AABB& fatBox = nodes[proxy].box;
+    if (fatBox.contains(box) && fatten(box, 4.0f * SMOL_AABB_TREE_MARGIN).contains(fatBox))
+      return false;
+
+    removeLeaf(proxy);
+    nodes[proxy].box = fatten(box, SMOL_AABB_TREE_MARGIN);
+    insertLeaf(proxy);
+    return true;
+  }
+
+  uint64 AABBTree::getUserData(int32 proxy) const
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < capacity && nodes[proxy].height == 0, "Invalid AABBTree proxy %d", proxy);
+    return nodes[proxy].userData;
+  }
+
+  const AABB& AABBTree::getFatBox(int32 proxy) const
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < capacity && nodes[proxy].height == 0, "Invalid AABBTree proxy %d", proxy);
+    return nodes[proxy].box;
+  }
+
+  int32 AABBTree::getProxyCount() const
+  {
+    return proxyCount;
+  }
+
+  int32 AABBTree::getHeight() const
+  {
+    return root == AABB_TREE_NULL_NODE ? 0 : nodes[root].height;
+  }
+
+  void AABBTree::reset()
+  {
+    for (int32 i = 0; i < capacity; i++)
+    {
+      nodes[i].next = i + 1 < capacity ? i + 1 : AABB_TREE_NULL_NODE;
+      nodes[i].height = -1;
+    }
+    freeList = capacity > 0 ? 0 : AABB_TREE_NULL_NODE;
+    root = AABB_TREE_NULL_NODE;
+    proxyCount = 0;
+  }
+
+  void AABBTree::insertLeaf(int32 leaf)
+  {
+    if (root == AABB_TREE_NULL_NODE)
+    {
+      root = leaf;
+      nodes[root].parent = AABB_TREE_NULL_NODE;
+      return;
+    }
+
+    // Walk down to the sibling that grows the total surface area the least
+    const AABB leafBox = nodes[leaf].box;
+    int32 index = root;
+    while (!nodes[index].isLeaf())
+    {
+      const int32 child1 = nodes[index].child1;
+      const int32 child2 = nodes[index].child2;
+      const float area = nodes[index].box.getSurfaceArea();
+      const float combinedArea = AABB::merge(nodes[index].box, leafBox).getSurfaceArea();
+
+      // Cost of making a new parent for this node and the leaf
+      const float cost = 2.0f * combinedArea;
+
+      // Minimum cost of pushing the leaf further down the tree
+      const float inheritanceCost = 2.0f * (combinedArea - area);
+
+      float cost1 = AABB::merge(leafBox, nodes[child1].box).getSurfaceArea() + inheritanceCost;
+      if (!nodes[child1].isLeaf())
+        cost1 -= nodes[child1].box.getSurfaceArea();
+
+      float cost2 = AABB::merge(leafBox, nodes[child2].box).getSurfaceArea() + inheritanceCost;
+      if (!nodes[child2].isLeaf())
+        cost2 -= nodes[child2].box.getSurfaceArea();
+
+      if (cost < cost1 && cost < cost2)
+        break;
+
+      index = cost1 < cost2 ? child1 : child2;
+    }
+
+    const int32 sibling = index;
+    const int32 oldParent = nodes[sibling].parent;
+    const int32 newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == AABB_TREE_NULL_NODE)
+      root = newParent;
+    else if (nodes[oldParent].child1 == sibling)
+      nodes[oldParent].child1 = newParent;
+    else
+      nodes[oldParent].child2 = newParent;
+
+    // Fix heights and boxes on the way up
+    index = nodes[leaf].parent;
+    while (index != AABB_TREE_NULL_NODE)
+    {
+      index = balance(index);
+      const int32 child1 = nodes[index].child1;
+      const int32 child2 = nodes[index].child2;
+      nodes[index].height = 1 + maxHeight(nodes[child1].height, nodes[child2].height);
+      nodes[index].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+      index = nodes[index].parent;
+    }
+  }
+
+  void AABBTree::removeLeaf(int32 leaf)
+  {
+    if (leaf == root)
+    {
+      root = AABB_TREE_NULL_NODE;
+      return;
+    }
+
+    // The sibling takes the place of the parent
+    const int32 parent = nodes[leaf].parent;
+    const int32 grandParent = nodes[parent].parent;
+    const int32 sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+    freeNode(parent);
+
+    if (grandParent == AABB_TREE_NULL_NODE)
+    {
+      root = sibling;
+      nodes[sibling].parent = AABB_TREE_NULL_NODE;
+      return;
+    }
+
+    if (nodes[grandParent].child1 == parent)
+      nodes[grandParent].child1 = sibling;
+    else
+      nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+
+    int32 index = grandParent;
+    while (index != AABB_TREE_NULL_NODE)
+    {
+      index = balance(index);
+      const int32 child1 = nodes[index].child1;
+      const int32 child2 = nodes[index].child2;
+      nodes[index].height = 1 + maxHeight(nodes[child1].height, nodes[child2].height);
+      nodes[index].box = AABB::merge(nodes[child1].box, nodes[child2].box);
+      index = nodes[index].parent;
+    }
+  }
+
+  // If one child of a is more than one level taller than the other, rotates
+  // it up to take the place of a. Returns the index of the node now at the
+  // place of a. With c as the taller child and f as its taller child:
+  // a(b, c(f, g)) becomes c(a(b, g), f)
+  int32 AABBTree::balance(int32 a)
+  {
+    AABBTreeNode* nodeA = nodes + a;
+    if (nodeA->isLeaf() || nodeA->height < 2)
+      return a;
+
+    const int32 b = nodeA->child1;
+    const int32 c = nodeA->child2;
+    AABBTreeNode* nodeB = nodes + b;
+    AABBTreeNode* nodeC = nodes + c;
+    const int32 heightDifference = nodeC->height - nodeB->height;
+
+    if (heightDifference > 1)
+    {
+      // Rotate c up
+      const int32 f = nodeC->child1;
+      const int32 g = nodeC->child2;
+      AABBTreeNode* nodeF = nodes + f;
+      AABBTreeNode* nodeG = nodes + g;
+
+      nodeC->child1 = a;
+      nodeC->parent = nodeA->parent;
+      nodeA->parent = c;
+
+      if (nodeC->parent == AABB_TREE_NULL_NODE)
+        root = c;
+      else if (nodes[nodeC->parent].child1 == a)
+        nodes[nodeC->parent].child1 = c;
+      else
+        nodes[nodeC->parent].child2 = c;
+
+      // The taller grandchild stays on c
+      if (nodeF->height > nodeG->height)
+      {
+        nodeC->child2 = f;
+        nodeA->child2 = g;
+        nodeG->parent = a;
+        nodeA->box = AABB::merge(nodeB->box, nodeG->box);
+        nodeC->box = AABB::merge(nodeA->box, nodeF->box);
+        nodeA->height = 1 + maxHeight(nodeB->height, nodeG->height);
+        nodeC->height = 1 + maxHeight(nodeA->height, nodeF->height);
+      }
+      else
+      {
+        nodeC->child2 = g;
+        nodeA->child2 = f;
+        nodeF->parent = a;
+        nodeA->box = AABB::merge(nodeB->box, nodeF->box);
+        nodeC->box = AABB::merge(nodeA->box, nodeG->box);
+        nodeA->height = 1 + maxHeight(nodeB->height, nodeF->height);
+        nodeC->height = 1 + maxHeight(nodeA->height, nodeG->height);
+      }
+      return c;
+    }
+
+    if (heightDifference < -1)
+    {
+      // Rotate b up
+      const int32 d = nodeB->child1;
+      const int32 e = nodeB->child2;
+      AABBTreeNode* nodeD = nodes + d;
+      AABBTreeNode* nodeE = nodes + e;
+
+      nodeB->child1 = a;
+      nodeB->parent = nodeA->parent;
+      nodeA->parent = b;
+
+      if (nodeB->parent == AABB_TREE_NULL_NODE)
+        root = b;
+      else if (nodes[nodeB->parent].child1 == a)
+        nodes[nodeB->parent].child1 = b;
+      else
+        nodes[nodeB->parent].child2 = b;
+
+      if (nodeD->height > nodeE->height)
+      {
+        nodeB->child2 = d;
+        nodeA->child1 = e;
+        nodeE->parent = a;
+        nodeA->box = AABB::merge(nodeC->box, nodeE->box);
+        nodeB->box = AABB::merge(nodeA->box, nodeD->box);
+        nodeA->height = 1 + maxHeight(nodeC->height, nodeE->height);
+        nodeB->height = 1 + maxHeight(nodeA->height, nodeD->height);
+      }
+      else
+      {
+        nodeB->child2 = e;
+        nodeA->child1 = d;
+        nodeD->parent = a;
+        nodeA->box = AABB::merge(nodeC->box, nodeD->box);
+        nodeB->box = AABB::merge(nodeA->box, nodeE->box);
+        nodeA->height = 1 + maxHeight(nodeC->height, nodeD->height);
+        nodeB->height = 1 + maxHeight(nodeA->height, nodeE->height);
+      }
+      return b;
+    }
+
+    return a;
+  }
+
+  //
+  // Queries
+  //
+
+  void AABBTree::query(const AABB& box, AABBTreeQueryCallback callback, void* context) const
+  {
+    if (root == AABB_TREE_NULL_NODE)
+      return;
+
+    int32 stack[AABB_TREE_STACK_SIZE];
+    int32 stackCount = 0;
+    stack[stackCount++] = root;
+
+    while (stackCount > 0)
+    {
+      const AABBTreeNode& node = nodes[stack[--stackCount]];
+      if (!node.box.overlaps(box))
+        continue;
+
+      if (node.isLeaf())
+      {
+        if (!callback(node.userData, context))
+          return;
+        continue;
+      }
+
+      SMOL_ASSERT(stackCount + 2 <= AABB_TREE_STACK_SIZE, "AABBTree query stack overflow", 0);
+      stack[stackCount++] = node.child1;
+      stack[stackCount++] = node.child2;
+    }
+  }
+
+  void AABBTree::query(const Frustum& frustum, AABBTreeQueryCallback callback, void* context) const
+  {
+    if (root == AABB_TREE_NULL_NODE)
+      return;
+
+    int32 stack[AABB_TREE_STACK_SIZE];
+    int32 stackCount = 0;
+    stack[stackCount++] = root;
+
+    while (stackCount > 0)
+    {
+      const AABBTreeNode& node = nodes[stack[--stackCount]];
+      if (!frustum.intersects(node.box))
+        continue;
+
+      if (node.isLeaf())
+      {
+        if (!callback(node.userData, context))
+          return;
+        continue;
+      }
+
+      SMOL_ASSERT(stackCount + 2 <= AABB_TREE_STACK_SIZE, "AABBTree query stack overflow", 0);
+      stack[stackCount++] = node.child1;
+      stack[stackCount++] = node.child2;
+    }
+  }
+
+  void AABBTree::raycast(const Ray& ray, float maxDistance, AABBTreeRayCallback callback, void* context) const
+  {
+    float rootDistance;
+    if (root == AABB_TREE_NULL_NODE || !nodes[root].box.intersects(ray, maxDistance, &rootDistance))
+      return;
+
+    // Distances are kept along with nodes so nodes behind a closer hit are skipped without testing them again
+    int32 stack[AABB_TREE_STACK_SIZE];
+    float stackDistance[AABB_TREE_STACK_SIZE];
+    int32 stackCount = 0;
+    stack[stackCount] = root;
+    stackDistance[stackCount++] = rootDistance;
+
+    while (stackCount > 0)
+    {
+      --stackCount;
+      if (stackDistance[stackCount] > maxDistance)
+        continue;
+
+      const AABBTreeNode& node = nodes[stack[stackCount]];
+      if (node.isLeaf())
+      {
+        const float distance = callback(node.userData, ray, maxDistance, context);
+        if (distance == 0.0f)
+          return;
+
+        if (distance < maxDistance)
+          maxDistance = distance;
+        continue;
+      }
+
+      float distance1, distance2;
+      const bool hit1 = nodes[node.child1].box.intersects(ray, maxDistance, &distance1);
+      const bool hit2 = nodes[node.child2].box.intersects(ray, maxDistance, &distance2);
+      SMOL_ASSERT(stackCount + 2 <= AABB_TREE_STACK_SIZE, "AABBTree query stack overflow", 0);
+
+      // The closest child is pushed last so it's visited first
+      if (hit1 && hit2 && distance1 < distance2)
+      {
+        stack[stackCount] = node.child2;
+        stackDistance[stackCount++] = distance2;
+        stack[stackCount] = node.child1;
+        stackDistance[stackCount++] = distance1;
+        continue;
+      }
+
+      if (hit1)
+      {
+        stack[stackCount] = node.child1;
+        stackDistance[stackCount++] = distance1;
+      }
+
+      if (hit2)
+      {
+        stack[stackCount] = node.child2;
+        stackDistance[stackCount++] = distance2;
+      }
+    }
+  }
+
+  int32 AABBTree::queryNearest(const Vector3& point, int32 k, uint64* results, float* distancesSquared) const
+  {
+    if (root == AABB_TREE_NULL_NODE || k <= 0)
+      return 0;
+
+    int32 stack[AABB_TREE_STACK_SIZE];
+    float stackDistance[AABB_TREE_STACK_SIZE];
+    int32 stackCount = 0;
+    stack[stackCount] = root;
+    stackDistance[stackCount++] = nodes[root].box.distanceSquared(point);
+    int32 found = 0;
+
+    while (stackCount > 0)
+    {
+      --stackCount;
+      const float distance = stackDistance[stackCount];
+
+      // Nothing under this node can be closer than the farthest result
+      if (found == k && distance >= distancesSquared[k - 1])
+        continue;
+
+      const AABBTreeNode& node = nodes[stack[stackCount]];
+      if (node.isLeaf())
+      {
+        // Insertion sort into the results. The farthest one drops when full.
+        int32 i = found < k ? found++ : k - 1;
+        while (i > 0 && distancesSquared[i - 1] > distance)
+        {
+          distancesSquared[i] = distancesSquared[i - 1];
+          results[i] = results[i - 1];
+          i--;
+        }
+        distancesSquared[i] = distance;
+        results[i] = node.userData;
+        continue;
+      }
+
+      const float distance1 = nodes[node.child1].box.distanceSquared(point);
+      const float distance2 = nodes[node.child2].box.distanceSquared(point);
+      const bool child1First = distance1 < distance2;
+      SMOL_ASSERT(stackCount + 2 <= AABB_TREE_STACK_SIZE, "AABBTree query stack overflow", 0);
+
+      // The closest child is pushed last so it's visited first
+      stack[stackCount] = child1First ? node.child2 : node.child1;
+      stackDistance[stackCount++] = child1First ? distance2 : distance1;
+      stack[stackCount] = child1First ? node.child1 : node.child2;
+      stackDistance[stackCount++] = child1First ? distance1 : distance2;
+    }
+
+    return found;
+  }
+}
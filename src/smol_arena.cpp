@@ -7,61 +7,154 @@
 // Note the Arena does not care about constructors or destructors of the objects
 // it stores. For the arena anything it stores is plain data.
 // Keep that in mind when using it.
+//
+// Arenas created with VIRTUAL_MEMORY reserve a range of address space up front
+// and commit pages from it as they grow. Growing never copies and pointers to
+// memory returned by pushSize() stay valid for the lifetime of the arena.
 
 namespace smol
 {
+  static size_t alignToPageSize(size_t size)
+  {
+    const size_t pageSize = Platform::getMemoryPageSize();
+    return (size + pageSize - 1) & ~(pageSize - 1);
+  }
 
   Arena::Arena():
-    capacity(0), used(0), data(nullptr) { }
+    capacity(0), used(0), reserved(0), data(nullptr), flags(Flag::NONE), tag(MemoryTag::ARENA) { }
 
-  Arena::Arena(size_t initialSize) 
+  Arena::Arena(size_t initialSize, MemoryTag tag)
   {
-    initialize(initialSize); 
+    initialize(initialSize, tag);
   }
 
-  Arena::Arena(Arena&& other)
-  { 
-    this->~Arena();
+  Arena::Arena(size_t initialSize, size_t reserveSize, uint32 flags, MemoryTag tag)
+  {
+    initialize(initialSize, reserveSize, flags, tag);
+  }
 
+  Arena::Arena(Arena&& other)
+  {
     capacity = other.capacity;
     used = other.used;
+    reserved = other.reserved;
     data = other.data;
+    flags = other.flags;
+    tag = other.tag;
 
     other.data = nullptr;
     other.used = 0;
     other.capacity = 0;
+    other.reserved = 0;
   }
 
-  Arena::~Arena() 
+  Arena::~Arena()
   {
-    Platform::freeMemory(data); 
+    if (flags & Flag::VIRTUAL_MEMORY)
+    {
+      if (data)
+      {
+        // Decommit first so committed pages are accounted back to our memory tag
+        if (capacity > 0)
+          Platform::decommitMemory(data, capacity, tag);
+        Platform::releaseMemory(data, reserved);
+      }
+    }
+    else
+    {
+      Platform::freeMemory(data);
+    }
   }
 
-  void Arena::initialize(size_t initialSize)
+  void Arena::initialize(size_t initialSize, MemoryTag tag)
   {
     capacity = initialSize;
     used = 0;
+    reserved = 0;
+    flags = Flag::NONE;
+    this->tag = tag;
     if (initialSize > 0)
-      data = (char*) Platform::getMemory(capacity);
+      data = (char*) Platform::getMemory(capacity, SMOL_ARENA_MAX_ALIGNMENT, tag);
     else
       data = nullptr;
   }
 
+  void Arena::initialize(size_t initialSize, size_t reserveSize, uint32 flags, MemoryTag tag)
+  {
+    SMOL_ASSERT((flags & Flag::VIRTUAL_MEMORY) || !(flags & Flag::DECOMMIT_ON_RESET),
+        "DECOMMIT_ON_RESET requires a VIRTUAL_MEMORY Arena", 0);
+
+    if (!(flags & Flag::VIRTUAL_MEMORY))
+    {
+      initialize(initialSize, tag);
+      return;
+    }
+
+    this->flags = flags;
+    this->tag = tag;
+    used = 0;
+    capacity = 0;
+    reserved = alignToPageSize(reserveSize > initialSize ? reserveSize : initialSize);
+    data = (char*) Platform::reserveMemory(reserved);
+
+    if (!data)
+    {
+      Log::error("Failed to reserve %zu bytes of virtual memory for Arena", reserved);
+      reserved = 0;
+      return;
+    }
+
+    // Capacity stays at 0 if the commit fails so pushSize() tries again
+    if (initialSize > 0)
+    {
+      const size_t initialCapacity = alignToPageSize(initialSize);
+      if (Platform::commitMemory(data, initialCapacity, tag))
+        capacity = initialCapacity;
+      else
+        Log::error("Failed to commit %zu bytes of virtual memory for Arena", initialCapacity);
+    }
+  }
+
   char* Arena::pushSize(size_t size)
   {
-    if (used + size >= capacity)
+    if (used + size > capacity)
     {
-      size_t newCapacity = 2 * (capacity + size);
-      // get next pow2 larger than current capacity
-      newCapacity = (newCapacity >> 1) | newCapacity;
-      newCapacity = (newCapacity >> 2) | newCapacity;
-      newCapacity = (newCapacity >> 4) | newCapacity;
-      newCapacity = (newCapacity >> 8) | newCapacity;
-      newCapacity = (newCapacity >> 16) | newCapacity;
-      newCapacity = (newCapacity >> 32) | newCapacity;
-      newCapacity++;
-      data = (char*) Platform::resizeMemory(data, newCapacity);
-      capacity = newCapacity;
+      if (flags & Flag::VIRTUAL_MEMORY)
+      {
+        if (used + size > reserved)
+        {
+          SMOL_ASSERT(used + size <= reserved,
+              "Arena out of reserved memory. Requested %zu bytes but only %zu are reserved", used + size, reserved);
+          return nullptr;
+        }
+
+        // Commit at least twice the current capacity so we don't call into the OS for every push.
+        size_t newCapacity = alignToPageSize(used + size > 2 * capacity ? used + size : 2 * capacity);
+        if (newCapacity > reserved)
+          newCapacity = reserved;
+
+        if (!Platform::commitMemory(data + capacity, newCapacity - capacity, tag))
+        {
+          Log::error("Failed to commit %zu bytes of virtual memory for Arena", newCapacity - capacity);
+          return nullptr;
+        }
+
+        capacity = newCapacity;
+      }
+      else
+      {
+        size_t newCapacity = 2 * (capacity + size);
+        // get next pow2 larger than current capacity
+        newCapacity = (newCapacity >> 1) | newCapacity;
+        newCapacity = (newCapacity >> 2) | newCapacity;
+        newCapacity = (newCapacity >> 4) | newCapacity;
+        newCapacity = (newCapacity >> 8) | newCapacity;
+        newCapacity = (newCapacity >> 16) | newCapacity;
+        newCapacity = (newCapacity >> 32) | newCapacity;
+        newCapacity++;
+        data = (char*) Platform::resizeMemory(data, newCapacity, SMOL_ARENA_MAX_ALIGNMENT, tag);
+        capacity = newCapacity;
+      }
     }
 
     char* memPtr = data + used;
@@ -69,11 +162,56 @@ namespace smol
     return memPtr;
   }
 
-  inline void Arena::reset() { used = 0; }
+  char* Arena::pushAligned(size_t size, size_t alignment)
+  {
+    if (alignment < SMOL_ARENA_MIN_ALIGNMENT)
+      alignment = SMOL_ARENA_MIN_ALIGNMENT;
+
+    SMOL_ASSERT((alignment & (alignment - 1)) == 0, "Arena alignment must be a power of two. Got %zu", alignment);
+    SMOL_ASSERT(alignment <= SMOL_ARENA_MAX_ALIGNMENT,
+        "Arena alignment %zu is larger than SMOL_ARENA_MAX_ALIGNMENT (%d)", alignment, SMOL_ARENA_MAX_ALIGNMENT);
+
+    // The base address is always aligned to SMOL_ARENA_MAX_ALIGNMENT, so
+    // aligning the offset is enough. It also survives the arena moving around.
+    const size_t alignedOffset = (used + alignment - 1) & ~(alignment - 1);
+    char* memPtr = pushSize((alignedOffset - used) + size);
+    if (!memPtr)
+      return nullptr;
+
+    return data + alignedOffset;
+  }
+
+  void Arena::reset()
+  {
+    used = 0;
+
+    if ((flags & Flag::DECOMMIT_ON_RESET) && capacity > 0)
+    {
+      Platform::decommitMemory(data, capacity, tag);
+      capacity = 0;
+    }
+  }
+
+  ArenaMarker Arena::mark() const
+  {
+    return ArenaMarker{ used };
+  }
+
+  void Arena::rewind(ArenaMarker marker)
+  {
+    SMOL_ASSERT(marker.used <= used, "Rewinding Arena to a marker ahead of its current position (%zu > %zu)", marker.used, used);
+    used = marker.used;
+  }
 
   inline size_t Arena::getCapacity() const { return capacity; }
 
   inline size_t Arena::getUsed() const { return used; }
 
+  inline size_t Arena::getReserved() const { return reserved; }
+
+  inline uint32 Arena::getFlags() const { return flags; }
+
+  inline MemoryTag Arena::getMemoryTag() const { return tag; }
+
   const char* Arena::getData() const { return data; }
 }
@@ -0,0 +1,518 @@
+#include <smol/smol_bounds.h>
+#include <smol/smol_mat4.h>
+#include <math.h>
+
+// Build option: set SMOL_BOUNDS_SIMD to 0 to use the scalar code path.
+#ifndef SMOL_BOUNDS_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMOL_BOUNDS_SIMD 1
+#else
+#define SMOL_BOUNDS_SIMD 0
+#endif
+#endif
+
+#if SMOL_BOUNDS_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace smol
+{
+  //
+  // Ray
+  //
+
+  Ray::Ray(): origin(0.0f), direction(0.0f, 0.0f, -1.0f) {}
+
+  Ray::Ray(const Vector3& origin, const Vector3& direction): origin(origin), direction(direction) {}
+
+  Vector3 Ray::getPoint(float distance) const
+  {
+    return Vector3(origin.x + direction.x * distance, origin.y + direction.y * distance, origin.z + direction.z * distance);
+  }
+
+  // Determinants smaller than this mean the ray is parallel to the triangle
+  const float RAY_TRIANGLE_EPSILON = 1e-12f;
+
+  static inline void getTriangle(const Vector3* positions, const unsigned int* indices, int32 triangle,
+      const Vector3** v0, const Vector3** v1, const Vector3** v2)
+  {
+    if (indices)
+    {
+      *v0 = &positions[indices[3 * triangle]];
+      *v1 = &positions[indices[3 * triangle + 1]];
+      *v2 = &positions[indices[3 * triangle + 2]];
+    }
+    else
+    {
+      *v0 = &positions[3 * triangle];
+      *v1 = &positions[3 * triangle + 1];
+      *v2 = &positions[3 * triangle + 2];
+    }
+  }
+
+  int32 Ray::intersectTriangles(const Vector3* positions, const unsigned int* indices, int32 numTriangles,
+      float maxDistance, float* distance) const
+  {
+    // Moller-Trumbore
+    int32 closest = -1;
+    float closestDistance = maxDistance;
+
+#if SMOL_BOUNDS_SIMD
+    const __m128 ox = _mm_set1_ps(origin.x);
+    const __m128 oy = _mm_set1_ps(origin.y);
+    const __m128 oz = _mm_set1_ps(origin.z);
+    const __m128 dx = _mm_set1_ps(direction.x);
+    const __m128 dy = _mm_set1_ps(direction.y);
+    const __m128 dz = _mm_set1_ps(direction.z);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 epsilon = _mm_set1_ps(RAY_TRIANGLE_EPSILON);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (int32 first = 0; first < numTriangles; first += 4)
+    {
+      // Gather 4 triangles as a structure of arrays. Missing lanes repeat the
+      // first triangle and are masked out.
+      const int32 lanes = numTriangles - first < 4 ? numTriangles - first : 4;
+      alignas(16) float v[9][4];
+      for (int32 lane = 0; lane < 4; lane++)
+      {
+        const Vector3 *v0, *v1, *v2;
+        getTriangle(positions, indices, first + (lane < lanes ? lane : 0), &v0, &v1, &v2);
+        v[0][lane] = v0->x; v[1][lane] = v0->y; v[2][lane] = v0->z;
+        v[3][lane] = v1->x; v[4][lane] = v1->y; v[5][lane] = v1->z;
+        v[6][lane] = v2->x; v[7][lane] = v2->y; v[8][lane] = v2->z;
+      }
+
+      const __m128 v0x = _mm_load_ps(v[0]);
+      const __m128 v0y = _mm_load_ps(v[1]);
+      const __m128 v0z = _mm_load_ps(v[2]);
+      const __m128 e1x = _mm_sub_ps(_mm_load_ps(v[3]), v0x);
+      const __m128 e1y = _mm_sub_ps(_mm_load_ps(v[4]), v0y);
+      const __m128 e1z = _mm_sub_ps(_mm_load_ps(v[5]), v0z);
+      const __m128 e2x = _mm_sub_ps(_mm_load_ps(v[6]), v0x);
+      const __m128 e2y = _mm_sub_ps(_mm_load_ps(v[7]), v0y);
+      const __m128 e2z = _mm_sub_ps(_mm_load_ps(v[8]), v0z);
+
+      // p = direction x e2
+      const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+      const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+      const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+      const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+      const __m128 invDet = _mm_div_ps(one, det);
+
+      // s = origin - v0, q = s x e1
+      const __m128 sx = _mm_sub_ps(ox, v0x);
+      const __m128 sy = _mm_sub_ps(oy, v0y);
+      const __m128 sz = _mm_sub_ps(oz, v0z);
+      const __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+      const __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+      const __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+
+      const __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), invDet);
+      const __m128 w = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+      const __m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+      __m128 hit = _mm_cmpgt_ps(_mm_andnot_ps(signMask, det), epsilon);
+      hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+      hit = _mm_and_ps(hit, _mm_cmpge_ps(w, zero));
+      hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, w), one));
+      hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+      hit = _mm_and_ps(hit, _mm_cmplt_ps(t, _mm_set1_ps(closestDistance)));
+
+      int mask = _mm_movemask_ps(hit) & ((1 << lanes) - 1);
+      if (!mask)
+        continue;
+
+      alignas(16) float hitDistance[4];
+      _mm_store_ps(hitDistance, t);
+      for (int32 lane = 0; lane < lanes; lane++)
+      {
+        if ((mask & (1 << lane)) && hitDistance[lane] < closestDistance)
+        {
+          closestDistance = hitDistance[lane];
+          closest = first + lane;
+        }
+      }
+    }
+#else
+    for (int32 triangle = 0; triangle < numTriangles; triangle++)
+    {
+      const Vector3 *v0, *v1, *v2;
+      getTriangle(positions, indices, triangle, &v0, &v1, &v2);
+
+      const Vector3 e1(v1->x - v0->x, v1->y - v0->y, v1->z - v0->z);
+      const Vector3 e2(v2->x - v0->x, v2->y - v0->y, v2->z - v0->z);
+      const Vector3 p(direction.y * e2.z - direction.z * e2.y, direction.z * e2.x - direction.x * e2.z,
+          direction.x * e2.y - direction.y * e2.x);
+      const float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+      if (fabsf(det) <= RAY_TRIANGLE_EPSILON)
+        continue;
+
+      const float invDet = 1.0f / det;
+      const Vector3 s(origin.x - v0->x, origin.y - v0->y, origin.z - v0->z);
+      const float u = (s.x * p.x + s.y * p.y + s.z * p.z) * invDet;
+      if (u < 0.0f || u > 1.0f)
+        continue;
+
+      const Vector3 q(s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x);
+      const float w = (direction.x * q.x + direction.y * q.y + direction.z * q.z) * invDet;
+      if (w < 0.0f || u + w > 1.0f)
+        continue;
+
+      const float t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) * invDet;
+      if (t >= 0.0f && t < closestDistance)
+      {
+        closestDistance = t;
+        closest = triangle;
+      }
+    }
+#endif
+
+    if (closest >= 0 && distance)
+      *distance = closestDistance;
+    return closest;
+  }
+
+  //
+  // AABB
+  //
+
+  AABB::AABB(): min(0.0f), max(0.0f) {}
+
+  AABB::AABB(const Vector3& min, const Vector3& max): min(min), max(max) {}
+
+  AABB AABB::fromPoints(const Vector3* points, int32 count)
+  {
+    if (count <= 0 || !points)
+      return AABB();
+
+    AABB box(points[0], points[0]);
+    for (int32 i = 1; i < count; i++)
+    {
+      const Vector3& p = points[i];
+      if (p.x < box.min.x) box.min.x = p.x;
+      if (p.y < box.min.y) box.min.y = p.y;
+      if (p.z < box.min.z) box.min.z = p.z;
+      if (p.x > box.max.x) box.max.x = p.x;
+      if (p.y > box.max.y) box.max.y = p.y;
+      if (p.z > box.max.z) box.max.z = p.z;
+    }
+    return box;
+  }
+
+  AABB AABB::merge(const AABB& a, const AABB& b)
+  {
+    return AABB(
+        Vector3(fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z)),
+        Vector3(fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z)));
+  }
+
+  Vector3 AABB::getCenter() const
+  {
+    return Vector3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+  }
+
+  Vector3 AABB::getExtents() const
+  {
+    return Vector3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+  }
+
+  float AABB::getSurfaceArea() const
+  {
+    const float x = max.x - min.x;
+    const float y = max.y - min.y;
+    const float z = max.z - min.z;
+    return 2.0f * (x * y + y * z + z * x);
+  }
+
+  bool AABB::overlaps(const AABB& other) const
+  {
+    return min.x <= other.max.x && max.x >= other.min.x
+      && min.y <= other.max.y && max.y >= other.min.y
+      && min.z <= other.max.z && max.z >= other.min.z;
+  }
+
+  bool AABB::contains(const AABB& other) const
+  {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+      && max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+  }
+
+  float AABB::distanceSquared(const Vector3& point) const
+  {
+    const float dx = fmaxf(fmaxf(min.x - point.x, 0.0f), point.x - max.x);
+    const float dy = fmaxf(fmaxf(min.y - point.y, 0.0f), point.y - max.y);
+    const float dz = fmaxf(fmaxf(min.z - point.z, 0.0f), point.z - max.z);
+    return dx * dx + dy * dy + dz * dz;
+  }
+
+  bool AABB::intersects(const Ray& ray, float maxDistance, float* distance) const
+  {
+#if SMOL_BOUNDS_SIMD
+    // The three slabs at once. The last lane is padding that never clips.
+    const __m128 origin = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+    const __m128 direction = _mm_setr_ps(ray.direction.x, ray.direction.y, ray.direction.z, 0.0f);
+    const __m128 boxMin = _mm_setr_ps(min.x, min.y, min.z, 0.0f);
+    const __m128 boxMax = _mm_setr_ps(max.x, max.y, max.z, 0.0f);
+
+    // Parallel to a slab. It either misses or never leaves it.
+    const __m128 parallel = _mm_cmpeq_ps(direction, _mm_setzero_ps());
+    const __m128 outside = _mm_or_ps(_mm_cmplt_ps(origin, boxMin), _mm_cmpgt_ps(origin, boxMax));
+    if (_mm_movemask_ps(_mm_and_ps(parallel, outside)))
+      return false;
+
+    const __m128 invDirection = _mm_div_ps(_mm_set1_ps(1.0f), direction);
+    const __m128 t0 = _mm_mul_ps(_mm_sub_ps(boxMin, origin), invDirection);
+    const __m128 t1 = _mm_mul_ps(_mm_sub_ps(boxMax, origin), invDirection);
+    const __m128 infinity = _mm_set1_ps(INFINITY);
+    __m128 tNear = _mm_min_ps(t0, t1);
+    __m128 tFar = _mm_max_ps(t0, t1);
+    tNear = _mm_or_ps(_mm_andnot_ps(parallel, tNear), _mm_and_ps(parallel, _mm_sub_ps(_mm_setzero_ps(), infinity)));
+    tFar = _mm_or_ps(_mm_andnot_ps(parallel, tFar), _mm_and_ps(parallel, infinity));
+
+    // Largest near and smallest far distance across the lanes
+    tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 0, 3, 2)));
+    tNear = _mm_max_ps(tNear, _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 3, 0, 1)));
+    tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 0, 3, 2)));
+    tFar = _mm_min_ps(tFar, _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    const float tMin = fmaxf(_mm_cvtss_f32(tNear), 0.0f);
+    const float tMax = fminf(_mm_cvtss_f32(tFar), maxDistance);
+    if (tMin > tMax)
+      return false;
+
+    if (distance)
+      *distance = tMin;
+    return true;
+#else
+    const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+    const float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    const float boxMin[3] = { min.x, min.y, min.z };
+    const float boxMax[3] = { max.x, max.y, max.z };
+
+    float tMin = 0.0f;
+    float tMax = maxDistance;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      if (direction[axis] == 0.0f)
+      {
+        // Parallel to the slab. It either misses or never leaves it.
+        if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+          return false;
+        continue;
+      }
+
+      const float invDirection = 1.0f / direction[axis];
+      float t0 = (boxMin[axis] - origin[axis]) * invDirection;
+      float t1 = (boxMax[axis] - origin[axis]) * invDirection;
+      if (t0 > t1)
+      {
+        const float swap = t0;
+        t0 = t1;
+        t1 = swap;
+      }
+
+      tMin = t0 > tMin ? t0 : tMin;
+      tMax = t1 < tMax ? t1 : tMax;
+      if (tMin > tMax)
+        return false;
+    }
+
+    if (distance)
+      *distance = tMin;
+    return true;
+#endif
+  }
+
+  AABB AABB::transformed(const Mat4& m) const
+  {
+    // Transform the center and project the extents on each world axis
+    const Vector3 c = getCenter();
+    const Vector3 e = getExtents();
+
+    const Vector3 center(
+        m.e[0][0] * c.x + m.e[1][0] * c.y + m.e[2][0] * c.z + m.e[3][0],
+        m.e[0][1] * c.x + m.e[1][1] * c.y + m.e[2][1] * c.z + m.e[3][1],
+        m.e[0][2] * c.x + m.e[1][2] * c.y + m.e[2][2] * c.z + m.e[3][2]);
+
+    const Vector3 extents(
+        fabsf(m.e[0][0]) * e.x + fabsf(m.e[1][0]) * e.y + fabsf(m.e[2][0]) * e.z,
+        fabsf(m.e[0][1]) * e.x + fabsf(m.e[1][1]) * e.y + fabsf(m.e[2][1]) * e.z,
+        fabsf(m.e[0][2]) * e.x + fabsf(m.e[1][2]) * e.y + fabsf(m.e[2][2]) * e.z);
+
+    return AABB(
+        Vector3(center.x - extents.x, center.y - extents.y, center.z - extents.z),
+        Vector3(center.x + extents.x, center.y + extents.y, center.z + extents.z));
+  }
+
+  //
+  // BoundingSphere
+  //
+
+  BoundingSphere::BoundingSphere(): center(0.0f), radius(0.0f) {}
+
+  BoundingSphere::BoundingSphere(const Vector3& center, float radius): center(center), radius(radius) {}
+
+  BoundingSphere BoundingSphere::fromPoints(const Vector3* points, int32 count)
+  {
+    if (count <= 0 || !points)
+      return BoundingSphere();
+
+    const Vector3 center = AABB::fromPoints(points, count).getCenter();
+    float radiusSquared = 0.0f;
+    for (int32 i = 0; i < count; i++)
+    {
+      const float dx = points[i].x - center.x;
+      const float dy = points[i].y - center.y;
+      const float dz = points[i].z - center.z;
+      const float distanceSquared = dx * dx + dy * dy + dz * dz;
+      if (distanceSquared > radiusSquared)
+        radiusSquared = distanceSquared;
+    }
+    return BoundingSphere(center, sqrtf(radiusSquared));
+  }
+
+  BoundingSphere BoundingSphere::transformed(const Mat4& m) const
+  {
+    const Vector3 c(
+        m.e[0][0] * center.x + m.e[1][0] * center.y + m.e[2][0] * center.z + m.e[3][0],
+        m.e[0][1] * center.x + m.e[1][1] * center.y + m.e[2][1] * center.z + m.e[3][1],
+        m.e[0][2] * center.x + m.e[1][2] * center.y + m.e[2][2] * center.z + m.e[3][2]);
+
+    const float scaleX = m.e[0][0] * m.e[0][0] + m.e[0][1] * m.e[0][1] + m.e[0][2] * m.e[0][2];
+    const float scaleY = m.e[1][0] * m.e[1][0] + m.e[1][1] * m.e[1][1] + m.e[1][2] * m.e[1][2];
+    const float scaleZ = m.e[2][0] * m.e[2][0] + m.e[2][1] * m.e[2][1] + m.e[2][2] * m.e[2][2];
+    float maxScale = scaleX > scaleY ? scaleX : scaleY;
+    maxScale = maxScale > scaleZ ? maxScale : scaleZ;
+
+    return BoundingSphere(c, radius * sqrtf(maxScale));
+  }
+
+  //
+  // Frustum
+  //
+
+  Frustum Frustum::fromMatrix(const Mat4& m)
+  {
+    // Gribb-Hartmann. Row i of the matrix is (e[0][i], e[1][i], e[2][i], e[3][i]).
+    // OpenGL clip space goes from -w to w on every axis.
+    const float sign[PLANE_COUNT] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+    const int row[PLANE_COUNT] = { 0, 0, 1, 1, 2, 2 };
+
+    Frustum frustum;
+    for (int plane = 0; plane < PLANE_COUNT; plane++)
+    {
+      const int r = row[plane];
+      float x = m.e[0][3] + sign[plane] * m.e[0][r];
+      float y = m.e[1][3] + sign[plane] * m.e[1][r];
+      float z = m.e[2][3] + sign[plane] * m.e[2][r];
+      float w = m.e[3][3] + sign[plane] * m.e[3][r];
+
+      const float length = sqrtf(x * x + y * y + z * z);
+      if (length > 0.0f)
+      {
+        const float invLength = 1.0f / length;
+        x *= invLength;
+        y *= invLength;
+        z *= invLength;
+        w *= invLength;
+      }
+
+      frustum.planeX[plane] = x;
+      frustum.planeY[plane] = y;
+      frustum.planeZ[plane] = z;
+      frustum.planeW[plane] = w;
+    }
+
+    // Padding repeats the near plane so it never rejects anything new
+    for (int plane = PLANE_COUNT; plane < 8; plane++)
+    {
+      frustum.planeX[plane] = frustum.planeX[PLANE_NEAR];
+      frustum.planeY[plane] = frustum.planeY[PLANE_NEAR];
+      frustum.planeZ[plane] = frustum.planeZ[PLANE_NEAR];
+      frustum.planeW[plane] = frustum.planeW[PLANE_NEAR];
+    }
+
+    return frustum;
+  }
+
+  bool Frustum::intersects(const BoundingSphere& sphere) const
+  {
+#if SMOL_BOUNDS_SIMD
+    const __m128 cx = _mm_set1_ps(sphere.center.x);
+    const __m128 cy = _mm_set1_ps(sphere.center.y);
+    const __m128 cz = _mm_set1_ps(sphere.center.z);
+    const __m128 negativeRadius = _mm_set1_ps(-sphere.radius);
+
+    for (int plane = 0; plane < 8; plane += 4)
+    {
+      // distance from the center to 4 planes at once
+      __m128 distance = _mm_mul_ps(_mm_load_ps(planeX + plane), cx);
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(planeY + plane), cy));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(planeZ + plane), cz));
+      distance = _mm_add_ps(distance, _mm_load_ps(planeW + plane));
+
+      if (_mm_movemask_ps(_mm_cmplt_ps(distance, negativeRadius)))
+        return false;
+    }
+    return true;
+#else
+    for (int plane = 0; plane < PLANE_COUNT; plane++)
+    {
+      const float distance = planeX[plane] * sphere.center.x + planeY[plane] * sphere.center.y
+        + planeZ[plane] * sphere.center.z + planeW[plane];
+
+      if (distance < -sphere.radius)
+        return false;
+    }
+    return true;
+#endif
+  }
+
+  bool Frustum::intersects(const AABB& box) const
+  {
+    const Vector3 c = box.getCenter();
+    const Vector3 e = box.getExtents();
+
+#if SMOL_BOUNDS_SIMD
+    const __m128 cx = _mm_set1_ps(c.x);
+    const __m128 cy = _mm_set1_ps(c.y);
+    const __m128 cz = _mm_set1_ps(c.z);
+    const __m128 ex = _mm_set1_ps(e.x);
+    const __m128 ey = _mm_set1_ps(e.y);
+    const __m128 ez = _mm_set1_ps(e.z);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    for (int plane = 0; plane < 8; plane += 4)
+    {
+      const __m128 px = _mm_load_ps(planeX + plane);
+      const __m128 py = _mm_load_ps(planeY + plane);
+      const __m128 pz = _mm_load_ps(planeZ + plane);
+
+      __m128 distance = _mm_mul_ps(px, cx);
+      distance = _mm_add_ps(distance, _mm_mul_ps(py, cy));
+      distance = _mm_add_ps(distance, _mm_mul_ps(pz, cz));
+      distance = _mm_add_ps(distance, _mm_load_ps(planeW + plane));
+
+      // Projected radius of the box on each plane normal
+      __m128 radius = _mm_mul_ps(_mm_andnot_ps(signMask, px), ex);
+      radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, py), ey));
+      radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+
+      if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps())))
+        return false;
+    }
+    return true;
+#else
+    for (int plane = 0; plane < PLANE_COUNT; plane++)
+    {
+      const float distance = planeX[plane] * c.x + planeY[plane] * c.y + planeZ[plane] * c.z + planeW[plane];
+      const float radius = fabsf(planeX[plane]) * e.x + fabsf(planeY[plane]) * e.y + fabsf(planeZ[plane]) * e.z;
+      if (distance + radius < 0.0f)
+        return false;
+    }
+    return true;
+#endif
+  }
+}
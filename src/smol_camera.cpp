@@ -4,65 +4,103 @@
 
 namespace smol
 {
+  static uint32 currentDisplayGeneration = 0;
+
   Camera::Camera() :
     clearOperation(Renderer::ClearBufferFlag::CLEAR_COLOR_BUFFER | Renderer::ClearBufferFlag::CLEAR_DEPTH_BUFFER),
     priority(0),
     layers(Layer::LAYER_0),
     rect(0.0f, 0.0f, 1.0f, 1.0f),
-    clearColor(Color::GRAY)
-  {}
+    clearColor(Color::GRAY),
+    flags(Flag::VIEW_CHANGED | Flag::PROJECTION_CHANGED | Flag::PROJECTION_OUTDATED),
+    displayGeneration(currentDisplayGeneration)
+  {
+    projectionMatrix = Mat4::initIdentity();
+    viewMatrix = Mat4::initIdentity();
+    viewProjectionMatrix = Mat4::initIdentity();
+  }
 
   Camera& Camera::setPerspective(float fov, float zNear, float zFar)
   {
-    Rect viewport = Renderer::getViewport();
-
-    // Should we use a fixed aspectRatio ?
-    float fixedAspect = ConfigManager::get().displayConfig().aspectRatio;
-
-    // Display might be minimized or reduced to size 0
-    if (viewport.h > 0)
-    {
-      this->type = Camera::PERSPECTIVE;
-      this->fov = fov;
-      this->aspect = fixedAspect > 0.0f ? fixedAspect: ((float)viewport.w /viewport.h);
-      this->zNear = zNear;
-      this->zFar = zFar;
-      this->viewMatrix = Mat4::perspective(fov, aspect, zNear, zFar);
-    }
+    this->type = Camera::PERSPECTIVE;
+    this->fov = fov;
+    this->zNear = zNear;
+    this->zFar = zFar;
+    updateProjection();
     return *this;
   }
 
   Camera& Camera::setOrthographic(float size, float zNear, float zFar)
+  {
+    this->type = Camera::ORTHOGRAPHIC;
+    this->zNear = zNear;
+    this->zFar = zFar;
+    this->orthographicSize = size;
+    updateProjection();
+    return *this;
+  }
+
+  bool Camera::updateProjection()
   {
     Rect viewport = Renderer::getViewport();
+
     // Display might be minimized or reduced to size 0
-    if (viewport.h > 0)
+    if (viewport.h <= 0)
     {
-      float hSize = (size * viewport.w) / viewport.h;
-
-      this->type = Camera::ORTHOGRAPHIC;
-      this->zNear = zNear;
-      this->zFar = zFar;
-      this->left = -hSize;
-      this->right = hSize;
-      this->top = size;
-      this->bottom = -size;
-      this->orthographicSize = size;
-      this->viewMatrix = Mat4::ortho(left, right, top, bottom, zNear, zFar);
+      flags |= Flag::PROJECTION_OUTDATED;
+      return false;
     }
-    return *this;
-  }
 
-  void Camera::update()
-  {
     if (type == Camera::PERSPECTIVE)
     {
-      setPerspective(fov,  zNear, zFar);
+      // Should we use a fixed aspectRatio ?
+      float fixedAspect = ConfigManager::get().displayConfig().aspectRatio;
+      this->aspect = fixedAspect > 0.0f ? fixedAspect: ((float)viewport.w /viewport.h);
+      this->projectionMatrix = Mat4::perspective(fov, aspect, zNear, zFar);
     }
     else
     {
-      setOrthographic(top, zNear, zFar); // size is assigned to top on orthographic cameras
+      float hSize = (orthographicSize * viewport.w) / viewport.h;
+      this->left = -hSize;
+      this->right = hSize;
+      this->top = orthographicSize;
+      this->bottom = -orthographicSize;
+      this->projectionMatrix = Mat4::ortho(left, right, top, bottom, zNear, zFar);
     }
+
+    flags = (flags | Flag::PROJECTION_CHANGED) & ~Flag::PROJECTION_OUTDATED;
+    displayGeneration = currentDisplayGeneration;
+    return true;
+  }
+
+  void Camera::update()
+  {
+    updateProjection();
+  }
+
+  void Camera::displayResized()
+  {
+    currentDisplayGeneration++;
+  }
+
+  bool Camera::updateView(const Mat4& worldMatrix, bool worldMatrixChanged)
+  {
+    if ((flags & Flag::PROJECTION_OUTDATED) || displayGeneration != currentDisplayGeneration)
+      updateProjection();
+
+    if (worldMatrixChanged)
+      flags |= Flag::VIEW_CHANGED;
+
+    if (!(flags & (Flag::VIEW_CHANGED | Flag::PROJECTION_CHANGED)))
+      return false;
+
+    // Camera matrices are built from translation, rotation and scale so the affine inverse is enough
+    if (flags & Flag::VIEW_CHANGED)
+      viewMatrix = worldMatrix.affineInverse();
+
+    viewProjectionMatrix = Mat4::mul(projectionMatrix, viewMatrix);
+    flags &= ~(Flag::VIEW_CHANGED | Flag::PROJECTION_CHANGED);
+    return true;
   }
 
   Camera& Camera::setLayerMask(uint32 layers)
@@ -73,7 +111,11 @@ namespace smol
 
   inline uint32 Camera::getLayerMask() const { return layers; }
 
-  inline const Mat4& Camera::getProjectionMatrix() const { return viewMatrix; }
+  inline const Mat4& Camera::getProjectionMatrix() const { return projectionMatrix; }
+
+  inline const Mat4& Camera::getViewMatrix() const { return viewMatrix; }
+
+  inline const Mat4& Camera::getViewProjectionMatrix() const { return viewProjectionMatrix; }
 
   const Rectf& Camera::getViewportRect() const { return rect; }
 
@@ -138,4 +180,36 @@ namespace smol
   float Camera::getOrthographicLeft() const { return this->left; }
 
   float Camera::getOrthographicRight() const { return this->left; }
+
+  // Point in world space from normalized device coordinates
+  static Vector3 unproject(const Mat4& inverseViewProjection, float x, float y, float z)
+  {
+    const Mat4& m = inverseViewProjection;
+    const float w = m.e[0][3] * x + m.e[1][3] * y + m.e[2][3] * z + m.e[3][3];
+    const float invW = w != 0.0f ? 1.0f / w : 1.0f;
+    return Vector3(
+        (m.e[0][0] * x + m.e[1][0] * y + m.e[2][0] * z + m.e[3][0]) * invW,
+        (m.e[0][1] * x + m.e[1][1] * y + m.e[2][1] * z + m.e[3][1]) * invW,
+        (m.e[0][2] * x + m.e[1][2] * y + m.e[2][2] * z + m.e[3][2]) * invW);
+  }
+
+  Ray Camera::screenPointToRay(const Point2& screenPoint, const Rect& viewport) const
+  {
+    // The camera draws to the part of the display given by its viewport rect.
+    // GL viewports start at the bottom left corner.
+    const float left = viewport.w * rect.x;
+    const float bottom = viewport.h * rect.y;
+    const float width = viewport.w * rect.w;
+    const float height = viewport.h * rect.h;
+    if (width <= 0.0f || height <= 0.0f)
+      return Ray();
+
+    const float x = 2.0f * (screenPoint.x + 0.5f - left) / width - 1.0f;
+    const float y = 2.0f * (viewport.h - screenPoint.y - 0.5f - bottom) / height - 1.0f;
+
+    const Mat4 inverseViewProjection = Mat4::invert(viewProjectionMatrix);
+    const Vector3 nearPoint = unproject(inverseViewProjection, x, y, -1.0f);
+    const Vector3 farPoint = unproject(inverseViewProjection, x, y, 1.0f);
+    return Ray(nearPoint, Vector3(farPoint.x - nearPoint.x, farPoint.y - nearPoint.y, farPoint.z - nearPoint.z));
+  }
 }
@@ -5,6 +5,10 @@
 #include <ctype.h>
 #include <string.h>
 
+#ifndef SMOL_CONFIG_ARENA_RESERVE_SIZE
+#define SMOL_CONFIG_ARENA_RESERVE_SIZE MEGABYTE(64)
+#endif
+
 namespace smol
 {
 
@@ -481,6 +485,8 @@ namespace smol
     // Alocate the entry
     ConfigEntry* entry = (ConfigEntry*) arena.pushSize(sizeof(ConfigEntry));
     entry->next = nullptr;
+    entry->nextSameHash = nullptr;
+    entry->variableMap = nullptr;
     entry->name = entryName;
     entry->hash = entryHash;
     entry->variableCount = variableCount;
@@ -494,16 +500,32 @@ namespace smol
       entry->hash = firstVariable->hash;
     }
 
+    // The variables are already in place so the map can go right after the entry
+    if (variableCount >= SMOL_CONFIG_VARIABLE_MAP_THRESHOLD)
+    {
+      entry->variableMap = arena.push<HashMap<uint32>>();
+      entry->variableMap->initialize(arena, variableCount);
+
+      // Keep the first variable when a name is repeated, like the linear search does
+      for (uint32 varIndex = 0; varIndex < entry->variableCount; varIndex++)
+      {
+        const uint64 key = (uint64) entry->variables[varIndex].hash;
+        if (!entry->variableMap->find(key))
+          entry->variableMap->insert(key, varIndex);
+      }
+    }
+
     *out = entry;
 
     return true;
   }
 
+  // Entries are linked by pointers into the arena, so it must never move.
   Config:: Config(size_t initialArenaSize):
-    arena(initialArenaSize), buffer(nullptr), entries(nullptr), entryCount(0) { }
+    arena(initialArenaSize, SMOL_CONFIG_ARENA_RESERVE_SIZE, Arena::VIRTUAL_MEMORY, MemoryTag::CONFIG), buffer(nullptr), entries(nullptr), entryCount(0) { }
 
   Config::Config(const char* path, size_t initialArenaSize):
-    arena(initialArenaSize), buffer(nullptr), entries(nullptr), entryCount(0)
+    arena(initialArenaSize, SMOL_CONFIG_ARENA_RESERVE_SIZE, Arena::VIRTUAL_MEMORY, MemoryTag::CONFIG), buffer(nullptr), entries(nullptr), entryCount(0)
   {
     load(path);
   }
@@ -553,6 +575,22 @@ namespace smol
       return false;
     }
 
+    // Index entries by name. Entries sharing a name hash are chained in file order.
+    entryMap.initialize(arena, entryCount);
+    for (ConfigEntry* entry = entries; entry; entry = entry->next)
+    {
+      ConfigEntryChain* chain = entryMap.find((uint64) entry->hash);
+      if (chain)
+      {
+        chain->last->nextSameHash = entry;
+        chain->last = entry;
+      }
+      else
+      {
+        entryMap.insert((uint64) entry->hash, ConfigEntryChain{entry, entry});
+      }
+    }
+
     return true;
   }
 
@@ -580,8 +618,19 @@ namespace smol
     const size_t varNameLen = strlen(name);
     ConfigVariable* result = nullptr;
     int64 requiredHash = stringToHash(name);
+    uint32 firstIndex = 0;
+
+    if (entry->variableMap)
+    {
+      uint32* index = entry->variableMap->find((uint64) requiredHash);
+      if (!index)
+        firstIndex = entry->variableCount;
+      else if (strncmp(entry->variables[*index].name, name, varNameLen) == 0)
+        firstIndex = *index;
+      // else it's a hash collision. Fall back to the linear search
+    }
 
-    for (uint32 varIndex = 0; varIndex < entry->variableCount; varIndex++)
+    for (uint32 varIndex = firstIndex; varIndex < entry->variableCount; varIndex++)
     {
       ConfigVariable* variable = &entry->variables[varIndex];
 
@@ -608,7 +657,25 @@ namespace smol
   {
     const size_t varNameLen = strlen(name);
     int64 requiredHash = stringToHash(name);
-    ConfigEntry* entry = start ? start->next : entries;
+    ConfigEntry* entry;
+
+    // Entries with the same name hash are chained, so only those are visited.
+    if (start && start->hash == requiredHash)
+    {
+      entry = start->nextSameHash;
+    }
+    else if (!start)
+    {
+      ConfigEntryChain* chain = entryMap.find((uint64) requiredHash);
+      entry = chain ? chain->first : nullptr;
+    }
+    else
+    {
+      // start has a different name. Find the first matching entry after it.
+      entry = start->next;
+      while (entry && entry->hash != requiredHash)
+        entry = entry->next;
+    }
 
     while (entry)
     {
@@ -616,7 +683,7 @@ namespace smol
       {
         return entry;
       }
-      entry = entry->next; 
+      entry = entry->nextSameHash;
     }
 
     return nullptr;
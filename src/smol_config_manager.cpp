@@ -64,6 +64,7 @@ namespace smol
     Vector2 glVersion = entry->getVariableVec2("gl_version", defaultGlVersion);
     glVersionMajor = (int) glVersion.x;
     glVersionMinor = (int) glVersion.y;
+    workerThreads = (int) entry->getVariableNumber("worker_threads", workerThreads);
   }
 
   GlobalDisplayConfig::GlobalDisplayConfig() {}
@@ -1,9 +1,6 @@
 #include <smol/smol_event_manager.h>
 #include <smol/smol_event.h>
-
-#ifndef SMOL_EVENT_QUEUE_INITIAL_CAPACITY
-#define SMOL_EVENT_QUEUE_INITIAL_CAPACITY 16
-#endif
+#include <smol/smol_frame_allocator.h>
 
 namespace smol
 {
@@ -18,7 +15,7 @@ namespace smol
     return instance;
   }
 
-  EventManager::EventManager(): events(SMOL_EVENT_QUEUE_INITIAL_CAPACITY * sizeof(Event)) { }
+  EventManager::EventManager(): firstEvent(nullptr), lastEvent(nullptr) { }
 
   EventHandlerId EventManager::addHandler(EventHandlerCallback handlerFunc, uint32 eventMask, void* context)
   {
@@ -32,20 +29,29 @@ namespace smol
 
   void EventManager::pushEvent(const Event& event)
   {
-    Event* e = (Event*) events.pushSize(sizeof(Event));
-    *e = event;
+    QueuedEvent* e = FrameAllocator::get().push<QueuedEvent>();
+    e->event = event;
+    e->next = nullptr;
+
+    if (lastEvent)
+      lastEvent->next = e;
+    else
+      firstEvent = e;
+    lastEvent = e;
   }
 
   void EventManager::dispatchEvents()
   {
     const uint32 numHandlers = handlers.count();
     const EventHandler* handlerList = handlers.getArray();
-    const Event* eventList = (const Event*) events.getData();
-    uint32 numEvents = (uint32) (events.getUsed() / sizeof(Event));
 
-    for(uint32 i = 0; i < numEvents; i++)
+    // Detach the queue first. Events pushed by handlers are dispatched on the next call.
+    const QueuedEvent* queuedEvent = firstEvent;
+    firstEvent = lastEvent = nullptr;
+
+    for(; queuedEvent; queuedEvent = queuedEvent->next)
     {
-      const Event& event = *eventList++;
+      const Event& event = queuedEvent->event;
       for (uint32 handlerIndex = 0; handlerIndex < numHandlers; handlerIndex++)
       {
         const EventHandler& handler = handlerList[handlerIndex];
@@ -57,6 +63,5 @@ namespace smol
         }
       }
     }
-    events.reset();
   }
 }
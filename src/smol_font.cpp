@@ -40,15 +40,19 @@ namespace smol
     return fontInfo->glyph;
   }
 
+  const Glyph* Font::findGlyph(uint16 id) const
+  {
+    const uint16* index = fontInfo->glyphMap.find(id);
+    return index ? &fontInfo->glyph[*index] : nullptr;
+  }
+
   Vector2 Font::computeString(const char* str,
       Color color,
       GlyphDrawData* drawData,
       float maxLineWidth,
       float lineHeightScale)
   {
-    int glyphCount = 0;
     uint16 kerningCount = 0;
-    const smol::Glyph* glyphList  = getGlyphs(&glyphCount);
     const smol::Kerning* kerning = nullptr;
     const smol::Kerning* kerningList = getKernings();
     const float lineHeight =  (float)getLineHeight();
@@ -62,114 +66,116 @@ namespace smol
 
     while (*str != 0)
     {
-      for (int i = 0; i < glyphCount; i++)
+      float glyphX = 0.0f;
+      float glyphY = 0.0f;
+      uint16 id = (uint16) *str;
+      const smol::Glyph* glyphPtr = findGlyph(id);
+
+      if (!glyphPtr)
       {
-        float glyphX = 0.0f;
-        float glyphY = 0.0f;
-        uint16 id = (uint16) *str;
-        const smol::Glyph& glyph = glyphList[i];
+        str++;
+        drawData++;
+        continue;
+      }
 
-        if (glyph.id != id)
-          continue;
+      const smol::Glyph& glyph = *glyphPtr;
 
-        if ((char)id == '\n')
+      if ((char)id == '\n')
+      {
+        advance = 0.0f;
+        y -= lineHeight * lineHeightScale;
+        bounds.y += lineHeight * lineHeightScale;
+        // We don't remember word breaks across lines
+        wordBreakStrPosition = nullptr;
+        wordBreakDrawDataPosition = nullptr;
+      }
+      else if ((char) id == ' ')
+      {
+        // Avoid getting stuck in a loop in case of trying to break long words.
+        if (wordBreakStrPosition == str)
         {
-          advance = 0.0f;
-          y -= lineHeight * lineHeightScale;
-          bounds.y += lineHeight * lineHeightScale;
-          // We don't remember word breaks across lines
           wordBreakStrPosition = nullptr;
           wordBreakDrawDataPosition = nullptr;
         }
-        else if ((char) id == ' ')
+        else 
         {
-          // Avoid getting stuck in a loop in case of trying to break long words.
-          if (wordBreakStrPosition == str)
-          {
-            wordBreakStrPosition = nullptr;
-            wordBreakDrawDataPosition = nullptr;
-          }
-          else 
-          {
-            // We save the position of white spaces so we can break the text at this position later it necessary.
-            wordBreakStrPosition = (char*) str;
-            wordBreakDrawDataPosition = drawData;
-          }
+          // We save the position of white spaces so we can break the text at this position later it necessary.
+          wordBreakStrPosition = (char*) str;
+          wordBreakDrawDataPosition = drawData;
         }
+      }
 
-        if (bounds.y == 0.0f)
-          bounds.y = lineHeight;
+      if (bounds.y == 0.0f)
+        bounds.y = lineHeight;
 
-        // Check for kerning
-        float glyphKerning = 0.0f;
-        for (int j = 0; j < kerningCount; j++)
+      // Check for kerning
+      float glyphKerning = 0.0f;
+      for (int j = 0; j < kerningCount; j++)
+      {
+        const smol::Kerning& k = kerning[j];
+        if(k.second == glyph.id)
         {
-          const smol::Kerning& k = kerning[j];
-          if(k.second == glyph.id)
-          {
-            glyphKerning = k.amount;
-            break;
-          }
+          glyphKerning = k.amount;
+          break;
         }
+      }
 
-        // Should we break the text if it's too long ?
-        float xBounds = (glyph.rect.w + advance);
-        if (breakTextIfTooLong && (xBounds / lineHeight) > maxLineWidth)
+      // Should we break the text if it's too long ?
+      float xBounds = (glyph.rect.w + advance);
+      if (breakTextIfTooLong && (xBounds / lineHeight) > maxLineWidth)
+      {
+        advance = 0.0f;
+        glyphX = 0.0f;
+        y -= lineHeight * lineHeightScale;
+        bounds.y += lineHeight * lineHeightScale;
+
+        // Can we break it from the previous white space ?
+        if(wordBreakStrPosition)
         {
-          advance = 0.0f;
-          glyphX = 0.0f;
-          y -= lineHeight * lineHeightScale;
-          bounds.y += lineHeight * lineHeightScale;
-
-          // Can we break it from the previous white space ?
-          if(wordBreakStrPosition)
-          {
-            str = wordBreakStrPosition;
-            drawData = wordBreakDrawDataPosition;
-            continue;
-          }
+          str = wordBreakStrPosition;
+          drawData = wordBreakDrawDataPosition;
+          continue;
         }
-        else
+      }
+      else
+      {
+        glyphX = advance + glyph.xOffset + glyphKerning;
+        if (xBounds > bounds.x)
         {
-          glyphX = advance + glyph.xOffset + glyphKerning;
-          if (xBounds > bounds.x)
-          {
-            bounds.x = xBounds;
-          }
+          bounds.x = xBounds;
         }
-
-        glyphY = y - glyph.yOffset;
-
-
-        // Negative Y because sprites are pushed with flipped Y
-        drawData->color = color;
-        drawData->position = smol::Vector3(glyphX, -glyphY, 0.0f);
-        drawData->size = Vector2(glyph.rect.w, glyph.rect.h);
-
-        /**
-         * We need a way to output text at the same scale regardless of the image
-         * size or space each glyph occupies in the image. We achieve this by
-         * dividing glyphs coordinates byt the font's lineHeight property which
-         * is measured in pixels. As no glyph is expected to exceed the
-         * lineHeight, this results in coordinates ranging from 0.0 to 1.0
-         */
-        drawData->position.div(lineHeight);
-        drawData->size.div(lineHeight);
-
-        // convert UVs from pixels to 0~1 range
-        Rectf uvRect;
-        uvRect.x = glyph.rect.x / (float) textureSize.x;
-        uvRect.y = 1 - (glyph.rect.y /(float) textureSize.y); 
-        uvRect.w = glyph.rect.w / (float) textureSize.x;
-        uvRect.h = glyph.rect.h / (float) textureSize.y;
-        advance += glyph.xAdvance + glyphKerning;
-        drawData->uv = uvRect;
-
-        // kerning information for the next character
-        kerning = &kerningList[glyph.kerningStart];
-        kerningCount = glyph.kerningCount;
-        break;
       }
+
+      glyphY = y - glyph.yOffset;
+
+
+      // Negative Y because sprites are pushed with flipped Y
+      drawData->color = color;
+      drawData->position = smol::Vector3(glyphX, -glyphY, 0.0f);
+      drawData->size = Vector2(glyph.rect.w, glyph.rect.h);
+
+      /**
+       * We need a way to output text at the same scale regardless of the image
+       * size or space each glyph occupies in the image. We achieve this by
+       * dividing glyphs coordinates byt the font's lineHeight property which
+       * is measured in pixels. As no glyph is expected to exceed the
+       * lineHeight, this results in coordinates ranging from 0.0 to 1.0
+       */
+      drawData->position.div(lineHeight);
+      drawData->size.div(lineHeight);
+
+      // convert UVs from pixels to 0~1 range
+      Rectf uvRect;
+      uvRect.x = glyph.rect.x / (float) textureSize.x;
+      uvRect.y = 1 - (glyph.rect.y /(float) textureSize.y); 
+      uvRect.w = glyph.rect.w / (float) textureSize.x;
+      uvRect.h = glyph.rect.h / (float) textureSize.y;
+      advance += glyph.xAdvance + glyphKerning;
+      drawData->uv = uvRect;
+
+      // kerning information for the next character
+      kerning = &kerningList[glyph.kerningStart];
+      kerningCount = glyph.kerningCount;
       str++;
       drawData++;
     }
@@ -0,0 +1,58 @@
+#include <smol/smol_frame_allocator.h>
+
+#ifndef SMOL_FRAME_ALLOCATOR_INITIAL_SIZE
+#define SMOL_FRAME_ALLOCATOR_INITIAL_SIZE KILOBYTE(256)
+#endif
+
+#ifndef SMOL_FRAME_ALLOCATOR_RESERVE_SIZE
+#define SMOL_FRAME_ALLOCATOR_RESERVE_SIZE MEGABYTE(256)
+#endif
+
+namespace smol
+{
+  FrameAllocator& FrameAllocator::get()
+  {
+    static FrameAllocator instance;
+    return instance;
+  }
+
+  // Both buffers are virtual so growing never moves memory handed out earlier in the frame.
+  FrameAllocator::FrameAllocator(): current(0), frameCount(0)
+  {
+    arenas[0].initialize(SMOL_FRAME_ALLOCATOR_INITIAL_SIZE, SMOL_FRAME_ALLOCATOR_RESERVE_SIZE, Arena::VIRTUAL_MEMORY, MemoryTag::FRAME);
+    arenas[1].initialize(SMOL_FRAME_ALLOCATOR_INITIAL_SIZE, SMOL_FRAME_ALLOCATOR_RESERVE_SIZE, Arena::VIRTUAL_MEMORY, MemoryTag::FRAME);
+  }
+
+  void FrameAllocator::beginFrame()
+  {
+    current ^= 1;
+    arenas[current].reset();
+    frameCount++;
+  }
+
+  char* FrameAllocator::pushSize(size_t size)
+  {
+    return arenas[current].pushSize(size);
+  }
+
+  char* FrameAllocator::pushAligned(size_t size, size_t alignment)
+  {
+    return arenas[current].pushAligned(size, alignment);
+  }
+
+  ArenaMarker FrameAllocator::mark() const
+  {
+    return arenas[current].mark();
+  }
+
+  void FrameAllocator::rewind(ArenaMarker marker)
+  {
+    arenas[current].rewind(marker);
+  }
+
+  inline uint64 FrameAllocator::getFrameCount() const { return frameCount; }
+
+  Arena& FrameAllocator::getCurrentArena() { return arenas[current]; }
+
+  const Arena& FrameAllocator::getPreviousArena() const { return arenas[current ^ 1]; }
+}
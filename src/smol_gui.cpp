@@ -5,6 +5,7 @@
 #include <smol/smol_input_manager.h>
 #include <smol/smol_event_manager.h>
 #include <smol/smol_platform.h>
+#include <smol/smol_frame_allocator.h>
 
 namespace smol
 {
@@ -127,12 +128,9 @@ namespace smol
     popupCount = 0;
     windowCount = 0;
 
-    if (glyphDrawDataArena.getCapacity() == 0)
-    {
-      glyphDrawDataArena.initialize(256 * sizeof(GlyphDrawData));
+    if (streamBuffer.format == StreamBuffer::UNINITIALIZED)
       Renderer::createStreamBuffer(&streamBuffer, 1024);
-    }
-    glyphDrawDataArena.reset();
+
     Renderer::begin(streamBuffer);
   }
 
@@ -304,8 +302,10 @@ namespace smol
     float posY          = y / screenH;
     const size_t textLen = strlen(text);
 
-    GlyphDrawData* drawData =
-      (GlyphDrawData*) glyphDrawDataArena.pushSize(textLen * sizeof(GlyphDrawData));
+    // Glyph data is only needed while drawing this text
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    const ArenaMarker marker = frameAllocator.mark();
+    GlyphDrawData* drawData = frameAllocator.push<GlyphDrawData>(textLen);
 
     GUISkin::ID textColor = enabled ?  GUISkin::TEXT : GUISkin::TEXT_DISABLED;
     Vector2 bounds = skin.font->computeString(text, skin.color[textColor], drawData, w / (float)fontSize, 1.0f + skin.lineHeightAdjust);
@@ -492,6 +492,8 @@ namespace smol
       GlyphDrawData& data = drawData[i];
       Renderer::pushSprite(streamBuffer, data.position, data.size, data.uv, data.color);
     }
+
+    frameAllocator.rewind(marker);
   }
 
   void GUI::label(GUIControlID id, const char* text, int32 x, int32 y, int32 w, Align align, Color bg)
@@ -0,0 +1,438 @@
+#include <smol/smol_job_system.h>
+#include <smol/smol_platform.h>
+#include <smol/smol_log.h>
+#include <new>
+
+// Build option: maximum number of jobs a thread can have in flight. Must be a
+// power of two. Job memory is recycled in a ring so a thread must not have
+// more than this many unfinished jobs scheduled at once.
+#ifndef SMOL_JOB_QUEUE_SIZE
+#define SMOL_JOB_QUEUE_SIZE 4096
+#endif
+
+static_assert((SMOL_JOB_QUEUE_SIZE & (SMOL_JOB_QUEUE_SIZE - 1)) == 0, "SMOL_JOB_QUEUE_SIZE must be a power of two");
+
+namespace smol
+{
+  struct Job
+  {
+    JobFunction function;
+    void* data;
+    JobCounter* counter;
+    Job* next;                      // next job waiting on the same dependency
+  };
+
+  // Chase-Lev work stealing deque. Only the owner thread calls push() and pop().
+  // Any thread can call steal().
+  struct JobQueue
+  {
+    alignas(64) std::atomic<int64> top;
+    alignas(64) std::atomic<int64> bottom;
+    alignas(64) std::atomic<Job*> jobs[SMOL_JOB_QUEUE_SIZE];
+    Job pool[SMOL_JOB_QUEUE_SIZE];  // ring of jobs allocated by the owner thread
+    uint32 poolNext;
+
+    JobQueue(): top(0), bottom(0), poolNext(0)
+    {
+      for (int i = 0; i < SMOL_JOB_QUEUE_SIZE; i++)
+        jobs[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool push(Job* job)
+    {
+      const int64 b = bottom.load(std::memory_order_relaxed);
+      const int64 t = top.load(std::memory_order_acquire);
+      if (b - t >= SMOL_JOB_QUEUE_SIZE)
+        return false;
+
+      jobs[b & (SMOL_JOB_QUEUE_SIZE - 1)].store(job, std::memory_order_relaxed);
+      bottom.store(b + 1, std::memory_order_release);
+      return true;
+    }
+
+    Job* pop()
+    {
+      const int64 b = bottom.load(std::memory_order_relaxed) - 1;
+      bottom.store(b, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      int64 t = top.load(std::memory_order_relaxed);
+
+      if (t > b)
+      {
+        // Empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+      }
+
+      Job* job = jobs[b & (SMOL_JOB_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+      if (t == b)
+      {
+        // Last job. Race against stealers for it.
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+          job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+      }
+      return job;
+    }
+
+    Job* steal()
+    {
+      int64 t = top.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      const int64 b = bottom.load(std::memory_order_acquire);
+
+      if (t >= b)
+        return nullptr;
+
+      Job* job = jobs[t & (SMOL_JOB_QUEUE_SIZE - 1)].load(std::memory_order_relaxed);
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+      return job;
+    }
+  };
+
+  // Index of the JobQueue owned by the current thread. -1 for threads the job system doesn't know about.
+  static thread_local int32 threadIndex = -1;
+
+  static void lockCounter(JobCounter* counter)
+  {
+    while (counter->lock.exchange(1, std::memory_order_acquire))
+      Platform::yieldThread();
+  }
+
+  static void unlockCounter(JobCounter* counter)
+  {
+    counter->lock.store(0, std::memory_order_release);
+  }
+
+  //
+  // JobCounter
+  //
+
+  JobCounter::JobCounter(): value(0), lock(0), waitingJobs(nullptr) { }
+
+  bool JobCounter::isDone() const
+  {
+    // Finished jobs decrement the counter while holding the lock, so the
+    // counter is not safe to release until the lock is free as well.
+    return value.load(std::memory_order_acquire) == 0 && lock.load(std::memory_order_acquire) == 0;
+  }
+
+  //
+  // JobSystem
+  //
+
+  struct WorkerStartInfo
+  {
+    JobSystem* jobSystem;
+    int32 index;
+  };
+
+  JobSystem::JobSystem():
+    threads(nullptr), queues(nullptr), wakeUp(nullptr), workerCount(0), sleepingWorkers(0), running(false) { }
+
+  JobSystem& JobSystem::get()
+  {
+    static JobSystem instance;
+    return instance;
+  }
+
+  bool JobSystem::initialize(int32 workerCount)
+  {
+    SMOL_ASSERT(queues == nullptr, "JobSystem is already initialized", 0);
+
+    if (workerCount < 0)
+    {
+      workerCount = (int32) Platform::getProcessorCount() - 1;
+      if (workerCount < 0)
+        workerCount = 0;
+    }
+
+    wakeUp = Platform::createSemaphore(0);
+    if (!wakeUp)
+      return false;
+
+    this->workerCount = workerCount;
+    queues = (JobQueue*) Platform::getMemory(sizeof(JobQueue) * (workerCount + 1), alignof(JobQueue));
+    for (int32 i = 0; i <= workerCount; i++)
+      new (&queues[i]) JobQueue();
+
+    threadIndex = 0;
+    running.store(true);
+    sleepingWorkers.store(0);
+
+    // Thread handles and the start info for each worker share one allocation
+    threads = (Thread**) Platform::getMemory((sizeof(Thread*) + sizeof(WorkerStartInfo)) * (workerCount + 1));
+    WorkerStartInfo* startInfo = (WorkerStartInfo*) (threads + workerCount + 1);
+    threads[0] = nullptr; // main thread
+
+    for (int32 i = 1; i <= workerCount; i++)
+    {
+      startInfo[i].jobSystem = this;
+      startInfo[i].index = i;
+      threads[i] = Platform::createThread(workerThreadEntryPoint, &startInfo[i]);
+      if (!threads[i])
+      {
+        // Run with the workers we already have
+        this->workerCount = i - 1;
+        break;
+      }
+    }
+
+    debugLogInfo("JobSystem started %d worker threads", this->workerCount);
+    return true;
+  }
+
+  void JobSystem::shutdown()
+  {
+    if (!queues)
+      return;
+
+    running.store(false);
+    Platform::signalSemaphore(wakeUp, workerCount);
+
+    for (int32 i = 1; i <= workerCount; i++)
+      Platform::waitThread(threads[i]);
+
+    // Run whatever is left on the calling thread
+    Job* job;
+    while ((job = getJob()))
+      execute(job);
+
+    Platform::destroySemaphore(wakeUp);
+    Platform::freeMemory(threads);
+    Platform::freeMemory(queues);
+    wakeUp = nullptr;
+    threads = nullptr;
+    queues = nullptr;
+    workerCount = 0;
+    threadIndex = -1;
+  }
+
+  bool JobSystem::isInitialized() const { return queues != nullptr; }
+
+  int32 JobSystem::getWorkerCount() const { return workerCount; }
+
+  uint32 JobSystem::workerThreadEntryPoint(void* data)
+  {
+    WorkerStartInfo* startInfo = (WorkerStartInfo*) data;
+    JobSystem* jobSystem = startInfo->jobSystem;
+    threadIndex = startInfo->index;
+
+    while (jobSystem->running.load(std::memory_order_acquire))
+    {
+      Job* job = jobSystem->getJob();
+      if (job)
+      {
+        jobSystem->execute(job);
+        continue;
+      }
+
+      // Let schedulers know we are about to sleep, then look again. Either we
+      // see their job or they see us sleeping and signal the semaphore.
+      jobSystem->sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+      job = jobSystem->getJob();
+      if (job)
+      {
+        jobSystem->sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        jobSystem->execute(job);
+        continue;
+      }
+
+      Platform::waitSemaphore(jobSystem->wakeUp);
+      jobSystem->sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    return 0;
+  }
+
+  Job* JobSystem::allocateJob()
+  {
+    JobQueue& queue = queues[threadIndex];
+    Job* job = &queue.pool[queue.poolNext & (SMOL_JOB_QUEUE_SIZE - 1)];
+    queue.poolNext++;
+    return job;
+  }
+
+  Job* JobSystem::getJob()
+  {
+    const int32 queueCount = workerCount + 1;
+    const int32 index = threadIndex;
+
+    if (index >= 0)
+    {
+      Job* job = queues[index].pop();
+      if (job)
+        return job;
+    }
+
+    // Steal starting from our neighbour so thieves don't all hit the same queue
+    for (int32 i = 1; i <= queueCount; i++)
+    {
+      const int32 victim = (index + i) % queueCount;
+      if (victim == index)
+        continue;
+
+      Job* job = queues[victim].steal();
+      if (job)
+        return job;
+    }
+
+    return nullptr;
+  }
+
+  void JobSystem::schedule(Job* job)
+  {
+    if (!queues[threadIndex].push(job))
+    {
+      // Queue is full. Don't wait for room, just do the work.
+      execute(job);
+      return;
+    }
+
+    wakeWorkers(1);
+  }
+
+  void JobSystem::execute(Job* job)
+  {
+    job->function(job->data);
+
+    JobCounter* counter = job->counter;
+    if (!counter)
+      return;
+
+    lockCounter(counter);
+    Job* waitingJobs = nullptr;
+    if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      waitingJobs = counter->waitingJobs;
+      counter->waitingJobs = nullptr;
+    }
+    unlockCounter(counter);
+
+    // The counter might be gone by now. Only touch the jobs we took from it.
+    while (waitingJobs)
+    {
+      Job* next = waitingJobs->next;
+      schedule(waitingJobs);
+      waitingJobs = next;
+    }
+  }
+
+  void JobSystem::wakeWorkers(int32 count)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int32 sleeping = sleepingWorkers.load(std::memory_order_relaxed);
+    if (sleeping > 0)
+      Platform::signalSemaphore(wakeUp, count < sleeping ? count : sleeping);
+  }
+
+  void JobSystem::run(JobFunction function, void* data, JobCounter* counter, JobCounter* dependency)
+  {
+    if (!queues)
+    {
+      function(data);
+      return;
+    }
+
+    SMOL_ASSERT(threadIndex >= 0, "Jobs can only be scheduled from the main thread or from other jobs", 0);
+
+    Job* job = allocateJob();
+    job->function = function;
+    job->data = data;
+    job->counter = counter;
+    job->next = nullptr;
+
+    if (counter)
+      counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    if (dependency)
+    {
+      lockCounter(dependency);
+      if (dependency->value.load(std::memory_order_acquire) > 0)
+      {
+        // Scheduled by whoever finishes the last job of the dependency
+        job->next = dependency->waitingJobs;
+        dependency->waitingJobs = job;
+        unlockCounter(dependency);
+        return;
+      }
+      unlockCounter(dependency);
+    }
+
+    schedule(job);
+  }
+
+  void JobSystem::wait(JobCounter* counter)
+  {
+    if (!counter)
+      return;
+
+    while (!counter->isDone())
+    {
+      Job* job = queues ? getJob() : nullptr;
+      if (job)
+        execute(job);
+      else
+        Platform::yieldThread();
+    }
+  }
+
+  // Every parallelFor job grabs batches from here until there are none left
+  struct ParallelForData
+  {
+    ParallelForFunction function;
+    void* data;
+    int32 count;
+    int32 batchSize;
+    int32 batchCount;
+    std::atomic<int32> nextBatch;
+  };
+
+  static void parallelForJob(void* data)
+  {
+    ParallelForData* parallelFor = (ParallelForData*) data;
+    int32 batch;
+    while ((batch = parallelFor->nextBatch.fetch_add(1, std::memory_order_relaxed)) < parallelFor->batchCount)
+    {
+      const int32 start = batch * parallelFor->batchSize;
+      const int32 end = start + parallelFor->batchSize < parallelFor->count ? start + parallelFor->batchSize : parallelFor->count;
+      parallelFor->function(start, end, parallelFor->data);
+    }
+  }
+
+  void JobSystem::parallelFor(int32 count, int32 batchSize, ParallelForFunction function, void* data)
+  {
+    if (count <= 0)
+      return;
+
+    if (batchSize < 1)
+      batchSize = 1;
+
+    const int32 batchCount = (count + batchSize - 1) / batchSize;
+    if (batchCount == 1 || !queues || workerCount == 0)
+    {
+      // Same ranges as the jobs would get, so callers can rely on them
+      for (int32 start = 0; start < count; start += batchSize)
+        function(start, start + batchSize < count ? start + batchSize : count, data);
+      return;
+    }
+
+    ParallelForData parallelFor;
+    parallelFor.function = function;
+    parallelFor.data = data;
+    parallelFor.count = count;
+    parallelFor.batchSize = batchSize;
+    parallelFor.batchCount = batchCount;
+    parallelFor.nextBatch.store(0, std::memory_order_relaxed);
+
+    // One job per thread is enough since jobs keep taking batches. The
+    // calling thread takes part through wait().
+    const int32 jobCount = batchCount < workerCount + 1 ? batchCount : workerCount + 1;
+    JobCounter counter;
+    for (int32 i = 0; i < jobCount; i++)
+      run(parallelForJob, &parallelFor, &counter);
+
+    wait(&counter);
+  }
+}
@@ -1,10 +1,33 @@
 #include <smol/smol.h>
 #include <smol/smol_log.h>
 #include <smol/smol_mat4.h>
+#include <smol/smol_quaternion.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
 #undef _USE_MATH_DEFINES
 
+// Build option: set SMOL_MAT4_SIMD to 0 to use the scalar code path.
+// When enabled, SSE2 is used for every kernel and AVX for mul() and mulBatch()
+// when the compiler targets it (/arch:AVX or -mavx).
+#ifndef SMOL_MAT4_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SMOL_MAT4_SIMD 1
+#else
+#define SMOL_MAT4_SIMD 0
+#endif
+#endif
+
+#if SMOL_MAT4_SIMD
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+#define SMOL_SHUFFLE_MASK(x, y, z, w) ((x) | ((y) << 2) | ((z) << 4) | ((w) << 6))
+#define SMOL_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps((v), (v), SMOL_SHUFFLE_MASK(x, y, z, w))
+#define SMOL_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), SMOL_SHUFFLE_MASK(x, y, z, w))
+#endif
+
 namespace smol
 {
   // class methods
@@ -41,46 +64,133 @@ namespace smol
 
   Mat4 Mat4::initRotation(float x, float y, float z)
   {
-    const double toRad = (M_PI/180.0);
-
-    const double angleX = x * toRad;
-    const double angleY = y * toRad;
-    const double angleZ = z * toRad;
-
-    const double cx = cos(angleX);
-    const double cy = cos(angleY);
-    const double cz = cos(angleZ);
-
-    const double sx = sin(angleX);
-    const double sy = sin(angleY);
-    const double sz = sin(angleZ);
-
-    // Right-hand rotation matrices
-    Mat4 xRot = Mat4::initIdentity();
-    xRot.e[1][1] = (float)(cx);
-    xRot.e[1][2] = (float)(sx);
-    xRot.e[2][1] = (float)(-sx);
-    xRot.e[2][2] = (float)(cx);
-
-    Mat4 yRot = Mat4::initIdentity();
-    yRot.e[0][0] = (float)(cy);
-    yRot.e[0][2] = (float)(-sy);
-    yRot.e[2][0] = (float)(sy);
-    yRot.e[2][2] = (float)(cy);
-
-    Mat4 zRot = Mat4::initIdentity();
-    zRot.e[0][0] = (float)(cz);
-    zRot.e[0][1] = (float)(sz);
-    zRot.e[1][0] = (float)(-sz);
-    zRot.e[1][1] = (float)(cz);
-
-    return Mat4::mul(zRot, Mat4::mul(yRot, xRot));
+    return Mat4::fromTRS(Vector3(0.0f), Vector3(x, y, z), Vector3(1.0f));
+  }
+
+  Mat4 Mat4::fromTRS(const Vector3& position, const Vector3& rotation, const Vector3& scale)
+  {
+    const float toRad = (float) (M_PI/180.0);
+
+    const float cx = cosf(rotation.x * toRad);
+    const float cy = cosf(rotation.y * toRad);
+    const float cz = cosf(rotation.z * toRad);
+
+    const float sx = sinf(rotation.x * toRad);
+    const float sy = sinf(rotation.y * toRad);
+    const float sz = sinf(rotation.z * toRad);
+
+    // Right-hand rotation Rz * Ry * Rx with each column multiplied by its scale
+    Mat4 m;
+    m.e[0][0] = cy * cz * scale.x;
+    m.e[0][1] = cy * sz * scale.x;
+    m.e[0][2] = -sy * scale.x;
+    m.e[0][3] = 0.0f;
+
+    m.e[1][0] = (cz * sy * sx - sz * cx) * scale.y;
+    m.e[1][1] = (sz * sy * sx + cz * cx) * scale.y;
+    m.e[1][2] = cy * sx * scale.y;
+    m.e[1][3] = 0.0f;
+
+    m.e[2][0] = (cz * sy * cx + sz * sx) * scale.z;
+    m.e[2][1] = (sz * sy * cx - cz * sx) * scale.z;
+    m.e[2][2] = cy * cx * scale.z;
+    m.e[2][3] = 0.0f;
+
+    m.e[3][0] = position.x;
+    m.e[3][1] = position.y;
+    m.e[3][2] = position.z;
+    m.e[3][3] = 1.0f;
+    return m;
+  }
+
+  Mat4 Mat4::fromTRS(const Vector3& position, const Quaternion& rotation, const Vector3& scale)
+  {
+    const float xx = rotation.x * rotation.x;
+    const float yy = rotation.y * rotation.y;
+    const float zz = rotation.z * rotation.z;
+    const float xy = rotation.x * rotation.y;
+    const float xz = rotation.x * rotation.z;
+    const float yz = rotation.y * rotation.z;
+    const float wx = rotation.w * rotation.x;
+    const float wy = rotation.w * rotation.y;
+    const float wz = rotation.w * rotation.z;
+
+    Mat4 m;
+    m.e[0][0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+    m.e[0][1] = 2.0f * (xy + wz) * scale.x;
+    m.e[0][2] = 2.0f * (xz - wy) * scale.x;
+    m.e[0][3] = 0.0f;
+
+    m.e[1][0] = 2.0f * (xy - wz) * scale.y;
+    m.e[1][1] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+    m.e[1][2] = 2.0f * (yz + wx) * scale.y;
+    m.e[1][3] = 0.0f;
+
+    m.e[2][0] = 2.0f * (xz + wy) * scale.z;
+    m.e[2][1] = 2.0f * (yz - wx) * scale.z;
+    m.e[2][2] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+    m.e[2][3] = 0.0f;
+
+    m.e[3][0] = position.x;
+    m.e[3][1] = position.y;
+    m.e[3][2] = position.z;
+    m.e[3][3] = 1.0f;
+    return m;
+  }
+
+  Mat4 Mat4::initRotation(const Quaternion& rotation)
+  {
+    return Mat4::fromTRS(Vector3(0.0f), rotation, Vector3(1.0f));
+  }
+
+#if SMOL_MAT4_SIMD
+  // Matrices are column major, so every e[column] is one SIMD register and
+  // each column of the result is a linear combination of the columns of a.
+  static inline void mulSIMD(const Mat4& a, const Mat4& b, Mat4& out)
+  {
+#ifdef __AVX__
+    // Two result columns per iteration
+    const __m256 a0 = _mm256_broadcast_ps((const __m128*) a.e[0]);
+    const __m256 a1 = _mm256_broadcast_ps((const __m128*) a.e[1]);
+    const __m256 a2 = _mm256_broadcast_ps((const __m128*) a.e[2]);
+    const __m256 a3 = _mm256_broadcast_ps((const __m128*) a.e[3]);
+
+    for (int column = 0; column < 4; column += 2)
+    {
+      const float* b0 = b.e[column];
+      const float* b1 = b.e[column + 1];
+      __m256 result = _mm256_mul_ps(a0, _mm256_setr_ps(b0[0], b0[0], b0[0], b0[0], b1[0], b1[0], b1[0], b1[0]));
+      result = _mm256_add_ps(result, _mm256_mul_ps(a1, _mm256_setr_ps(b0[1], b0[1], b0[1], b0[1], b1[1], b1[1], b1[1], b1[1])));
+      result = _mm256_add_ps(result, _mm256_mul_ps(a2, _mm256_setr_ps(b0[2], b0[2], b0[2], b0[2], b1[2], b1[2], b1[2], b1[2])));
+      result = _mm256_add_ps(result, _mm256_mul_ps(a3, _mm256_setr_ps(b0[3], b0[3], b0[3], b0[3], b1[3], b1[3], b1[3], b1[3])));
+      _mm256_storeu_ps(out.e[column], result);
+    }
+#else
+    const __m128 a0 = _mm_loadu_ps(a.e[0]);
+    const __m128 a1 = _mm_loadu_ps(a.e[1]);
+    const __m128 a2 = _mm_loadu_ps(a.e[2]);
+    const __m128 a3 = _mm_loadu_ps(a.e[3]);
+
+    for (int column = 0; column < 4; column++)
+    {
+      const __m128 bColumn = _mm_loadu_ps(b.e[column]);
+      __m128 result = _mm_mul_ps(a0, SMOL_SWIZZLE(bColumn, 0, 0, 0, 0));
+      result = _mm_add_ps(result, _mm_mul_ps(a1, SMOL_SWIZZLE(bColumn, 1, 1, 1, 1)));
+      result = _mm_add_ps(result, _mm_mul_ps(a2, SMOL_SWIZZLE(bColumn, 2, 2, 2, 2)));
+      result = _mm_add_ps(result, _mm_mul_ps(a3, SMOL_SWIZZLE(bColumn, 3, 3, 3, 3)));
+      _mm_storeu_ps(out.e[column], result);
+    }
+#endif
   }
+#endif
 
   Mat4 Mat4::mul(const Mat4& a, const Mat4& b)
   {
     Mat4 m; 
 
+#if SMOL_MAT4_SIMD
+    mulSIMD(a, b, m);
+#else
     for (int line = 0; line < 4; line++)
     {
       for (int column = 0; column < 4; column++)
@@ -92,10 +202,23 @@ namespace smol
           a.e[3][line] * b.e [column][3];
       }
     }
+#endif
 
     return m;
   }
 
+  void Mat4::mulBatch(const Mat4* a, const Mat4* b, Mat4* out, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+#if SMOL_MAT4_SIMD
+      mulSIMD(a[i], b[i], out[i]);
+#else
+      out[i] = Mat4::mul(a[i], b[i]);
+#endif
+    }
+  }
+
   Mat4 Mat4::perspective(float fov, float aspect, float zNear, float zFar)
   {
     SMOL_ASSERT(zNear >= 0.0f, "zNear must be positive.",0);
@@ -130,6 +253,17 @@ namespace smol
   Mat4 Mat4::transpose(const Mat4& m)
   {
     Mat4 t;
+#if SMOL_MAT4_SIMD
+    __m128 c0 = _mm_loadu_ps(m.e[0]);
+    __m128 c1 = _mm_loadu_ps(m.e[1]);
+    __m128 c2 = _mm_loadu_ps(m.e[2]);
+    __m128 c3 = _mm_loadu_ps(m.e[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(t.e[0], c0);
+    _mm_storeu_ps(t.e[1], c1);
+    _mm_storeu_ps(t.e[2], c2);
+    _mm_storeu_ps(t.e[3], c3);
+#else
     for(int line = 0; line < 4; line++)
     {
       for(int column = 0; column < 4; column++)
@@ -137,20 +271,117 @@ namespace smol
         t.e[column][line] = m.e[line][column];
       }
     }
+#endif
     return t;
   }
 
+  // Transforms the point b (w = 1) by a
   Vector3 Mat4::mul(const Mat4& a, const Vector3& b)
   {
+#if SMOL_MAT4_SIMD
+    __m128 result = _mm_loadu_ps(a.e[3]);
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(a.e[0]), _mm_set1_ps(b.x)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(a.e[1]), _mm_set1_ps(b.y)));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_loadu_ps(a.e[2]), _mm_set1_ps(b.z)));
+    float t[4];
+    _mm_storeu_ps(t, result);
+    return Vector3(t[0], t[1], t[2]);
+#else
     Vector3 t(
-        a.e[0][0] * b.x + a.e[0][1] * b.y + a.e[0][2] * b.z + a.e[0][3],
-        a.e[1][0] * b.x + a.e[1][1] * b.y + a.e[1][2] * b.z + a.e[1][3],
-        a.e[2][0] * b.x + a.e[2][1] * b.y + a.e[2][2] * b.z + a.e[2][3]);
+        a.e[0][0] * b.x + a.e[1][0] * b.y + a.e[2][0] * b.z + a.e[3][0],
+        a.e[0][1] * b.x + a.e[1][1] * b.y + a.e[2][1] * b.z + a.e[3][1],
+        a.e[0][2] * b.x + a.e[1][2] * b.y + a.e[2][2] * b.z + a.e[3][2]);
     return t;
+#endif
   }
 
+#if SMOL_MAT4_SIMD
+  // 2x2 matrices are stored in a register as (m00, m01, m10, m11)
+  static inline __m128 mat2Mul(__m128 a, __m128 b)
+  {
+    return _mm_add_ps(_mm_mul_ps(a, SMOL_SWIZZLE(b, 0, 3, 0, 3)),
+        _mm_mul_ps(SMOL_SWIZZLE(a, 1, 0, 3, 2), SMOL_SWIZZLE(b, 2, 1, 2, 1)));
+  }
+
+  // adjugate(a) * b
+  static inline __m128 mat2AdjMul(__m128 a, __m128 b)
+  {
+    return _mm_sub_ps(_mm_mul_ps(SMOL_SWIZZLE(a, 3, 3, 0, 0), b),
+        _mm_mul_ps(SMOL_SWIZZLE(a, 1, 1, 2, 2), SMOL_SWIZZLE(b, 2, 3, 0, 1)));
+  }
+
+  // a * adjugate(b)
+  static inline __m128 mat2MulAdj(__m128 a, __m128 b)
+  {
+    return _mm_sub_ps(_mm_mul_ps(a, SMOL_SWIZZLE(b, 3, 0, 3, 0)),
+        _mm_mul_ps(SMOL_SWIZZLE(a, 1, 0, 3, 2), SMOL_SWIZZLE(b, 2, 1, 2, 1)));
+  }
+
+  // Block matrix inverse. The 4x4 matrix is split in four 2x2 blocks
+  // | A B |
+  // | C D |
+  // and the inverse is built from their adjugates and determinants.
+  // It works the same way for row and column major matrices.
+  static inline bool invertSIMD(const Mat4& m, Mat4& out)
+  {
+    const __m128 c0 = _mm_loadu_ps(m.e[0]);
+    const __m128 c1 = _mm_loadu_ps(m.e[1]);
+    const __m128 c2 = _mm_loadu_ps(m.e[2]);
+    const __m128 c3 = _mm_loadu_ps(m.e[3]);
+
+    const __m128 A = _mm_movelh_ps(c0, c1);
+    const __m128 B = _mm_movehl_ps(c1, c0);
+    const __m128 C = _mm_movelh_ps(c2, c3);
+    const __m128 D = _mm_movehl_ps(c3, c2);
+
+    // (|A|, |B|, |C|, |D|)
+    const __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(SMOL_SHUFFLE(c0, c2, 0, 2, 0, 2), SMOL_SHUFFLE(c1, c3, 1, 3, 1, 3)),
+        _mm_mul_ps(SMOL_SHUFFLE(c0, c2, 1, 3, 1, 3), SMOL_SHUFFLE(c1, c3, 0, 2, 0, 2)));
+    const __m128 detA = SMOL_SWIZZLE(detSub, 0, 0, 0, 0);
+    const __m128 detB = SMOL_SWIZZLE(detSub, 1, 1, 1, 1);
+    const __m128 detC = SMOL_SWIZZLE(detSub, 2, 2, 2, 2);
+    const __m128 detD = SMOL_SWIZZLE(detSub, 3, 3, 3, 3);
+
+    const __m128 adjDC = mat2AdjMul(D, C);
+    const __m128 adjAB = mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, adjDC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, adjAB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, adjAB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, adjDC));
+
+    // |M| = |A|*|D| + |B|*|C| - tr((A#B)(D#C))
+    __m128 trace = _mm_mul_ps(adjAB, SMOL_SWIZZLE(adjDC, 0, 2, 1, 3));
+    trace = _mm_add_ps(trace, SMOL_SWIZZLE(trace, 2, 3, 0, 1));
+    trace = _mm_add_ps(trace, SMOL_SWIZZLE(trace, 1, 0, 3, 2));
+    const __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+    if (_mm_cvtss_f32(detM) == 0.0f)
+      return false;
+
+    const __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X = _mm_mul_ps(X, rDetM);
+    Y = _mm_mul_ps(Y, rDetM);
+    Z = _mm_mul_ps(Z, rDetM);
+    W = _mm_mul_ps(W, rDetM);
+
+    // Apply the adjugate while storing
+    _mm_storeu_ps(out.e[0], SMOL_SHUFFLE(X, Y, 3, 1, 3, 1));
+    _mm_storeu_ps(out.e[1], SMOL_SHUFFLE(X, Y, 2, 0, 2, 0));
+    _mm_storeu_ps(out.e[2], SMOL_SHUFFLE(Z, W, 3, 1, 3, 1));
+    _mm_storeu_ps(out.e[3], SMOL_SHUFFLE(Z, W, 2, 0, 2, 0));
+    return true;
+  }
+#endif
+
   Mat4 Mat4::invert(const Mat4& m)
   {
+#if SMOL_MAT4_SIMD
+    Mat4 inverseMatrix;
+    if (!invertSIMD(m, inverseMatrix))
+      return Mat4::initIdentity();
+    return inverseMatrix;
+#else
     double inv[16];
     float* me = (float*) m.e; // just access target matrix elements lineraly. 
 
@@ -281,6 +512,54 @@ namespace smol
       me[i] = (float) (inv[i] * det);
 
     return inverseMatrix;
+#endif
+  }
+
+  Mat4 Mat4::affineInvert(const Mat4& m)
+  {
+    // The upper 3x3 part is inverted with cross products of its columns and
+    // the translation is moved back through it. This works with non uniform
+    // scale and shear, not only rigid transforms.
+    const float* c0 = m.e[0];
+    const float* c1 = m.e[1];
+    const float* c2 = m.e[2];
+
+    // r0 = c1 x c2, r1 = c2 x c0, r2 = c0 x c1
+    const float r0[3] = {c1[1] * c2[2] - c1[2] * c2[1], c1[2] * c2[0] - c1[0] * c2[2], c1[0] * c2[1] - c1[1] * c2[0]};
+    const float r1[3] = {c2[1] * c0[2] - c2[2] * c0[1], c2[2] * c0[0] - c2[0] * c0[2], c2[0] * c0[1] - c2[1] * c0[0]};
+    const float r2[3] = {c0[1] * c1[2] - c0[2] * c1[1], c0[2] * c1[0] - c0[0] * c1[2], c0[0] * c1[1] - c0[1] * c1[0]};
+    const float det = c0[0] * r0[0] + c0[1] * r0[1] + c0[2] * r0[2];
+
+    if (det == 0.0f)
+      return Mat4::initIdentity();
+
+    const float invDet = 1.0f / det;
+    const float tx = m.e[3][0];
+    const float ty = m.e[3][1];
+    const float tz = m.e[3][2];
+
+    // r0, r1 and r2 are the rows of the inverse
+    Mat4 inverseMatrix;
+    inverseMatrix.e[0][0] = r0[0] * invDet;
+    inverseMatrix.e[0][1] = r1[0] * invDet;
+    inverseMatrix.e[0][2] = r2[0] * invDet;
+    inverseMatrix.e[0][3] = 0.0f;
+
+    inverseMatrix.e[1][0] = r0[1] * invDet;
+    inverseMatrix.e[1][1] = r1[1] * invDet;
+    inverseMatrix.e[1][2] = r2[1] * invDet;
+    inverseMatrix.e[1][3] = 0.0f;
+
+    inverseMatrix.e[2][0] = r0[2] * invDet;
+    inverseMatrix.e[2][1] = r1[2] * invDet;
+    inverseMatrix.e[2][2] = r2[2] * invDet;
+    inverseMatrix.e[2][3] = 0.0f;
+
+    inverseMatrix.e[3][0] = -(r0[0] * tx + r0[1] * ty + r0[2] * tz) * invDet;
+    inverseMatrix.e[3][1] = -(r1[0] * tx + r1[1] * ty + r1[2] * tz) * invDet;
+    inverseMatrix.e[3][2] = -(r2[0] * tx + r2[1] * ty + r2[2] * tz) * invDet;
+    inverseMatrix.e[3][3] = 1.0f;
+    return inverseMatrix;
   }
 
   // instance methods
@@ -301,4 +580,9 @@ namespace smol
     return Mat4::invert(*this);
   }
 
+  inline Mat4 Mat4::affineInverse() const
+  {
+    return Mat4::affineInvert(*this);
+  }
+
 }
@@ -1,15 +1,18 @@
 #include <smol/smol_material.h>
 #include <smol/smol_resource_manager.h>
+#include <smol/smol_string_hash.h>
 
 namespace smol
 {
   MaterialParameter* Material::getParameter(const char* name, ShaderParameter::Type type)
   {
-    //TODO(marcio): Hash these strings for faster search
+    // A material has at most SMOL_MAX_SHADER_PARAMETERS parameters, so comparing
+    // the precomputed hashes is cheaper than keeping a HashMap per material.
+    const uint64 hash = (uint64) stringToHash(name);
     for(int i=0; i < parameterCount; i++)
     {
       MaterialParameter& p = parameter[i];
-      if (p.type == type)
+      if (p.hash == hash && p.type == type)
       {
         if (strncmp(name, p.name, strlen(name)) == 0)
         {
@@ -8,7 +8,7 @@ namespace smol
   bool Packer::createPackage(const char* outputFileName, const char** inputFiles, int inputFileCount)
   {
     size_t totalHeadersSize = sizeof(PackageHeader) + inputFileCount * sizeof(PackageEntry);
-    char* memory = (char*) Platform::getMemory(totalHeadersSize);
+    char* memory = (char*) Platform::getMemory(totalHeadersSize, 0, MemoryTag::PACKAGE);
     memset(memory, 0, totalHeadersSize);
     PackageHeader* header = (PackageHeader*) memory; 
     PackageEntry* entryList = (PackageEntry*) (memory + sizeof(PackageHeader));
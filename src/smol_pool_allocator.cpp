@@ -0,0 +1,191 @@
+#include <smol/smol_pool_allocator.h>
+#include <smol/smol_platform.h>
+#include <smol/smol_log.h>
+#include <string.h>
+
+// Chunks start with a header padded to the block alignment so blocks stay aligned.
+#define SMOL_POOL_CHUNK_HEADER_SIZE SMOL_POOL_MIN_BLOCK_SIZE
+
+static_assert(SMOL_POOL_MAX_BLOCK_SIZE == (SMOL_POOL_MIN_BLOCK_SIZE << (SMOL_POOL_SIZE_CLASS_COUNT - 1)), "SMOL_POOL_SIZE_CLASS_COUNT does not match the block size range");
+static_assert(SMOL_POOL_CHUNK_SIZE >= SMOL_POOL_MAX_BLOCK_SIZE, "SMOL_POOL_CHUNK_SIZE must fit at least one block of the largest size class");
+
+namespace smol
+{
+  static uint32 getSizeClassIndex(size_t size)
+  {
+    uint32 index = 0;
+    size_t blockSize = SMOL_POOL_MIN_BLOCK_SIZE;
+    while (blockSize < size)
+    {
+      blockSize <<= 1;
+      index++;
+    }
+    return index;
+  }
+
+  PoolAllocator& PoolAllocator::get()
+  {
+    static PoolAllocator instance;
+    return instance;
+  }
+
+  PoolAllocator::PoolAllocator(): chunks(nullptr)
+  {
+    memset(freeList, 0, sizeof(freeList));
+    memset(&stats, 0, sizeof(stats));
+    for (uint32 i = 0; i < SMOL_POOL_SIZE_CLASS_COUNT; i++)
+      stats.sizeClass[i].blockSize = SMOL_POOL_MIN_BLOCK_SIZE << i;
+  }
+
+  PoolAllocator::~PoolAllocator()
+  {
+    if (stats.allocationCount)
+      debugLogWarning("PoolAllocator destroyed with %d live allocations", stats.allocationCount);
+
+    Chunk* chunk = chunks;
+    while (chunk)
+    {
+      Chunk* next = chunk->next;
+      Platform::freeMemory(chunk);
+      chunk = next;
+    }
+  }
+
+  bool PoolAllocator::addChunk(uint32 sizeClassIndex)
+  {
+    Chunk* chunk = (Chunk*) Platform::getMemory(SMOL_POOL_CHUNK_HEADER_SIZE + SMOL_POOL_CHUNK_SIZE, SMOL_POOL_MIN_BLOCK_SIZE, MemoryTag::POOL);
+    if (!chunk)
+    {
+      Log::error("PoolAllocator failed to allocate a %zu bytes chunk", (size_t) SMOL_POOL_CHUNK_SIZE);
+      return false;
+    }
+
+    chunk->next = chunks;
+    chunks = chunk;
+
+    // Split the whole chunk into blocks of this size class
+    PoolAllocatorStats::SizeClass& sizeClass = stats.sizeClass[sizeClassIndex];
+    const uint32 blockCount = (uint32) (SMOL_POOL_CHUNK_SIZE / sizeClass.blockSize);
+    char* block = ((char*) chunk) + SMOL_POOL_CHUNK_HEADER_SIZE;
+    for (uint32 i = 0; i < blockCount; i++)
+    {
+      FreeBlock* freeBlock = (FreeBlock*) block;
+      freeBlock->next = freeList[sizeClassIndex];
+      freeList[sizeClassIndex] = freeBlock;
+      block += sizeClass.blockSize;
+    }
+
+    sizeClass.blocksFree += blockCount;
+    stats.chunkCount++;
+    stats.reservedBytes += SMOL_POOL_CHUNK_SIZE;
+    if (stats.reservedBytes > stats.peakReservedBytes)
+      stats.peakReservedBytes = stats.reservedBytes;
+    return true;
+  }
+
+  void* PoolAllocator::getMemory(size_t size)
+  {
+    if (size == 0)
+      size = 1;
+
+    if (size > SMOL_POOL_MAX_BLOCK_SIZE)
+    {
+      void* memory = Platform::getMemory(size, SMOL_POOL_MIN_BLOCK_SIZE, MemoryTag::POOL);
+      if (memory)
+      {
+        stats.allocationCount++;
+        stats.largeBytes += size;
+        if (stats.largeBytes > stats.peakLargeBytes)
+          stats.peakLargeBytes = stats.largeBytes;
+      }
+      return memory;
+    }
+
+    const uint32 sizeClassIndex = getSizeClassIndex(size);
+    if (!freeList[sizeClassIndex] && !addChunk(sizeClassIndex))
+      return nullptr;
+
+    FreeBlock* block = freeList[sizeClassIndex];
+    freeList[sizeClassIndex] = block->next;
+
+    PoolAllocatorStats::SizeClass& sizeClass = stats.sizeClass[sizeClassIndex];
+    sizeClass.blocksFree--;
+    sizeClass.blocksInUse++;
+    if (sizeClass.blocksInUse > sizeClass.peakBlocksInUse)
+      sizeClass.peakBlocksInUse = sizeClass.blocksInUse;
+
+    stats.allocationCount++;
+    stats.requestedBytes += size;
+    stats.usedBytes += sizeClass.blockSize;
+    if (stats.usedBytes > stats.peakUsedBytes)
+      stats.peakUsedBytes = stats.usedBytes;
+
+    return block;
+  }
+
+  void PoolAllocator::freeMemory(void* memory, size_t size)
+  {
+    if (!memory)
+      return;
+
+    if (size == 0)
+      size = 1;
+
+    SMOL_ASSERT(stats.allocationCount > 0, "PoolAllocator::freeMemory() called with no live allocations", 0);
+    stats.allocationCount--;
+
+    if (size > SMOL_POOL_MAX_BLOCK_SIZE)
+    {
+      stats.largeBytes -= size;
+      Platform::freeMemory(memory);
+      return;
+    }
+
+    const uint32 sizeClassIndex = getSizeClassIndex(size);
+    FreeBlock* block = (FreeBlock*) memory;
+    block->next = freeList[sizeClassIndex];
+    freeList[sizeClassIndex] = block;
+
+    PoolAllocatorStats::SizeClass& sizeClass = stats.sizeClass[sizeClassIndex];
+    sizeClass.blocksFree++;
+    sizeClass.blocksInUse--;
+    stats.requestedBytes -= size;
+    stats.usedBytes -= sizeClass.blockSize;
+  }
+
+  size_t PoolAllocator::getBlockSize(size_t size)
+  {
+    if (size > SMOL_POOL_MAX_BLOCK_SIZE)
+      return size;
+    return ((size_t) SMOL_POOL_MIN_BLOCK_SIZE) << getSizeClassIndex(size);
+  }
+
+  PoolAllocatorStats PoolAllocator::getStats() const
+  {
+    PoolAllocatorStats result = stats;
+    result.internalFragmentation = stats.usedBytes ?
+      1.0f - (stats.requestedBytes / (float) stats.usedBytes) : 0.0f;
+    result.externalFragmentation = stats.reservedBytes ?
+      1.0f - (stats.usedBytes / (float) stats.reservedBytes) : 0.0f;
+    return result;
+  }
+
+  void PoolAllocator::logStats() const
+  {
+    PoolAllocatorStats s = getStats();
+    Log::info("PoolAllocator: %d allocations, %zu/%zu bytes used (peak %zu), %zu bytes large (peak %zu), %d chunks",
+        s.allocationCount, s.usedBytes, s.reservedBytes, s.peakUsedBytes, s.largeBytes, s.peakLargeBytes, s.chunkCount);
+    Log::info("PoolAllocator: internal fragmentation %.2f%%, external fragmentation %.2f%%",
+        s.internalFragmentation * 100.0f, s.externalFragmentation * 100.0f);
+
+    for (uint32 i = 0; i < SMOL_POOL_SIZE_CLASS_COUNT; i++)
+    {
+      const PoolAllocatorStats::SizeClass& sizeClass = s.sizeClass[i];
+      if (sizeClass.blocksInUse == 0 && sizeClass.blocksFree == 0)
+        continue;
+
+      Log::info("  %6zu bytes: %d in use, %d free, peak %d",
+          sizeClass.blockSize, sizeClass.blocksInUse, sizeClass.blocksFree, sizeClass.peakBlocksInUse);
+    }
+  }
+}
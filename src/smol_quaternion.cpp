@@ -0,0 +1,161 @@
+#include <smol/smol.h>
+#include <smol/smol_quaternion.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#undef _USE_MATH_DEFINES
+
+namespace smol
+{
+  Quaternion::Quaternion() {}
+
+  Quaternion::Quaternion(float x, float y, float z, float w):
+    x(x), y(y), z(z), w(w) {}
+
+  Quaternion Quaternion::identity()
+  {
+    return Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+  }
+
+  Quaternion Quaternion::fromEuler(float x, float y, float z)
+  {
+    const float toHalfRad = (float) (M_PI/360.0);
+
+    const float cx = cosf(x * toHalfRad);
+    const float cy = cosf(y * toHalfRad);
+    const float cz = cosf(z * toHalfRad);
+
+    const float sx = sinf(x * toHalfRad);
+    const float sy = sinf(y * toHalfRad);
+    const float sz = sinf(z * toHalfRad);
+
+    // qz * qy * qx
+    return Quaternion(
+        sx * cy * cz - cx * sy * sz,
+        cx * sy * cz + sx * cy * sz,
+        cx * cy * sz - sx * sy * cz,
+        cx * cy * cz + sx * sy * sz);
+  }
+
+  Quaternion Quaternion::fromEuler(const Vector3& degrees)
+  {
+    return fromEuler(degrees.x, degrees.y, degrees.z);
+  }
+
+  Quaternion Quaternion::fromAxisAngle(const Vector3& axis, float degrees)
+  {
+    const float halfAngle = degrees * (float) (M_PI/360.0);
+    float len = sqrtf(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+    if (len == 0.0f)
+      return identity();
+
+    const float s = sinf(halfAngle) / len;
+    return Quaternion(axis.x * s, axis.y * s, axis.z * s, cosf(halfAngle));
+  }
+
+  Quaternion Quaternion::mul(const Quaternion& a, const Quaternion& b)
+  {
+    return Quaternion(
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+  }
+
+  float Quaternion::dot(const Quaternion& a, const Quaternion& b)
+  {
+    return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+  }
+
+  Quaternion Quaternion::nlerp(const Quaternion& a, const Quaternion& b, float t)
+  {
+    // q and -q are the same rotation. Flip b so we take the shortest path.
+    const float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+    const float ta = 1.0f - t;
+    const float tb = t * sign;
+
+    Quaternion result(
+        a.x * ta + b.x * tb,
+        a.y * ta + b.y * tb,
+        a.z * ta + b.z * tb,
+        a.w * ta + b.w * tb);
+    return result.normalize();
+  }
+
+  Quaternion Quaternion::slerp(const Quaternion& a, const Quaternion& b, float t)
+  {
+    float cosTheta = dot(a, b);
+    float sign = 1.0f;
+    if (cosTheta < 0.0f)
+    {
+      cosTheta = -cosTheta;
+      sign = -1.0f;
+    }
+
+    // Almost the same rotation. sin(theta) is too small to divide by.
+    if (cosTheta > 0.9995f)
+      return nlerp(a, b, t);
+
+    const float theta = acosf(cosTheta);
+    const float invSinTheta = 1.0f / sinf(theta);
+    const float ta = sinf((1.0f - t) * theta) * invSinTheta;
+    const float tb = sinf(t * theta) * invSinTheta * sign;
+
+    return Quaternion(
+        a.x * ta + b.x * tb,
+        a.y * ta + b.y * tb,
+        a.z * ta + b.z * tb,
+        a.w * ta + b.w * tb);
+  }
+
+  Vector3 Quaternion::rotate(const Vector3& v) const
+  {
+    // t = 2 * cross(q.xyz, v)
+    const float tx = 2.0f * (y * v.z - z * v.y);
+    const float ty = 2.0f * (z * v.x - x * v.z);
+    const float tz = 2.0f * (x * v.y - y * v.x);
+
+    // v + w * t + cross(q.xyz, t)
+    return Vector3(
+        v.x + w * tx + (y * tz - z * ty),
+        v.y + w * ty + (z * tx - x * tz),
+        v.z + w * tz + (x * ty - y * tx));
+  }
+
+  Vector3 Quaternion::toEuler() const
+  {
+    const float toDeg = (float) (180.0/M_PI);
+
+    float sinPitch = 2.0f * (w * y - z * x);
+    if (sinPitch > 1.0f) sinPitch = 1.0f;
+    if (sinPitch < -1.0f) sinPitch = -1.0f;
+
+    return Vector3(
+        atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y)) * toDeg,
+        asinf(sinPitch) * toDeg,
+        atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) * toDeg);
+  }
+
+  Quaternion Quaternion::conjugated() const
+  {
+    return Quaternion(-x, -y, -z, w);
+  }
+
+  Quaternion& Quaternion::normalize()
+  {
+    float len = length();
+    if (len > 0.0f)
+    {
+      const float invLen = 1.0f / len;
+      x *= invLen;
+      y *= invLen;
+      z *= invLen;
+      w *= invLen;
+    }
+    return *this;
+  }
+
+  float Quaternion::length() const
+  {
+    return sqrtf(x * x + y * y + z * z + w * w);
+  }
+}
@@ -0,0 +1,247 @@
+#include <smol/smol_radix_sort.h>
+#include <smol/smol_job_system.h>
+#include <string.h>
+
+#ifndef SMOL_RADIX_SORT_PARALLEL_THRESHOLD
+#define SMOL_RADIX_SORT_PARALLEL_THRESHOLD 65536
+#endif
+
+#ifndef SMOL_RADIX_SORT_MAX_BLOCKS
+#define SMOL_RADIX_SORT_MAX_BLOCKS 32
+#endif
+
+// Build option: adaptiveSort() insertion sorts when at most 1 in this many
+// keys is smaller than the key before it.
+#ifndef SMOL_ADAPTIVE_SORT_MAX_DESCENT_RATIO
+#define SMOL_ADAPTIVE_SORT_MAX_DESCENT_RATIO 64
+#endif
+
+namespace smol
+{
+  const uint32 RADIX_BITS = 8;
+  const uint32 RADIX_BUCKET_COUNT = 1 << RADIX_BITS;
+  const uint32 RADIX_MAX_PASSES = 64 / RADIX_BITS;
+
+  // The last pass might look at fewer than 8 bits when keyBits is not a multiple of 8
+  static uint64 getDigitMask(uint32 keyBits, uint32 pass)
+  {
+    const uint32 bits = keyBits - pass * RADIX_BITS;
+    return bits >= RADIX_BITS ? RADIX_BUCKET_COUNT - 1 : (1ULL << bits) - 1;
+  }
+
+  uint64* radixSort(uint64* keys, uint64* temp, uint32 count, uint32 keyBits)
+  {
+    if (keyBits > 64)
+      keyBits = 64;
+
+    const uint32 passCount = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+    if (count < 2 || passCount == 0)
+      return keys;
+
+    uint64 masks[RADIX_MAX_PASSES];
+    for (uint32 pass = 0; pass < passCount; pass++)
+      masks[pass] = getDigitMask(keyBits, pass);
+
+    // Digit counts don't depend on key order so all histograms are built at once
+    uint32 histograms[RADIX_MAX_PASSES][RADIX_BUCKET_COUNT] = {};
+    for (uint32 i = 0; i < count; i++)
+    {
+      const uint64 key = keys[i];
+      for (uint32 pass = 0; pass < passCount; pass++)
+        histograms[pass][(key >> (pass * RADIX_BITS)) & masks[pass]]++;
+    }
+
+    uint64* src = keys;
+    uint64* dest = temp;
+    for (uint32 pass = 0; pass < passCount; pass++)
+    {
+      const uint32 shift = pass * RADIX_BITS;
+      const uint64 mask = masks[pass];
+      uint32* offsets = histograms[pass];
+
+      // Every key has the same digit. This pass would not move anything.
+      if (offsets[(src[0] >> shift) & mask] == count)
+        continue;
+
+      uint32 startIndex = 0;
+      for (uint32 bucket = 0; bucket < RADIX_BUCKET_COUNT; bucket++)
+      {
+        const uint32 keyCount = offsets[bucket];
+        offsets[bucket] = startIndex;
+        startIndex += keyCount;
+      }
+
+      for (uint32 i = 0; i < count; i++)
+      {
+        const uint64 key = src[i];
+        dest[offsets[(key >> shift) & mask]++] = key;
+      }
+
+      uint64* swap = src;
+      src = dest;
+      dest = swap;
+    }
+
+    return src;
+  }
+
+  //
+  // Parallel sort
+  //
+
+  struct RadixSortJobData
+  {
+    const uint64* src;
+    uint64* dest;
+    uint32 count;
+    uint32 blockSize;
+    uint32 shift;
+    uint64 mask;
+    uint32 (*blockHistograms)[RADIX_BUCKET_COUNT];  // per block digit count, then per block offsets
+  };
+
+  static void countDigitsRange(int32 start, int32 end, void* data)
+  {
+    RadixSortJobData* job = (RadixSortJobData*) data;
+    for (int32 block = start; block < end; block++)
+    {
+      uint32* histogram = job->blockHistograms[block];
+      memset(histogram, 0, RADIX_BUCKET_COUNT * sizeof(uint32));
+
+      const uint32 first = block * job->blockSize;
+      const uint32 last = first + job->blockSize < job->count ? first + job->blockSize : job->count;
+      for (uint32 i = first; i < last; i++)
+        histogram[(job->src[i] >> job->shift) & job->mask]++;
+    }
+  }
+
+  static void scatterRange(int32 start, int32 end, void* data)
+  {
+    RadixSortJobData* job = (RadixSortJobData*) data;
+    for (int32 block = start; block < end; block++)
+    {
+      uint32* offsets = job->blockHistograms[block];
+      const uint32 first = block * job->blockSize;
+      const uint32 last = first + job->blockSize < job->count ? first + job->blockSize : job->count;
+      for (uint32 i = first; i < last; i++)
+      {
+        const uint64 key = job->src[i];
+        job->dest[offsets[(key >> job->shift) & job->mask]++] = key;
+      }
+    }
+  }
+
+  uint64* radixSortParallel(uint64* keys, uint64* temp, uint32 count, uint32 keyBits)
+  {
+    JobSystem& jobSystem = JobSystem::get();
+    if (count < SMOL_RADIX_SORT_PARALLEL_THRESHOLD || !jobSystem.isInitialized() || jobSystem.getWorkerCount() == 0)
+      return radixSort(keys, temp, count, keyBits);
+
+    if (keyBits > 64)
+      keyBits = 64;
+
+    // One block per thread. Blocks are scattered in order so the sort stays stable.
+    uint32 blockCount = jobSystem.getWorkerCount() + 1;
+    if (blockCount > SMOL_RADIX_SORT_MAX_BLOCKS)
+      blockCount = SMOL_RADIX_SORT_MAX_BLOCKS;
+
+    uint32 blockHistograms[SMOL_RADIX_SORT_MAX_BLOCKS][RADIX_BUCKET_COUNT];
+    RadixSortJobData job;
+    job.count = count;
+    job.blockSize = (count + blockCount - 1) / blockCount;
+    job.blockHistograms = blockHistograms;
+
+    uint64* src = keys;
+    uint64* dest = temp;
+    const uint32 passCount = (keyBits + RADIX_BITS - 1) / RADIX_BITS;
+    for (uint32 pass = 0; pass < passCount; pass++)
+    {
+      job.src = src;
+      job.dest = dest;
+      job.shift = pass * RADIX_BITS;
+      job.mask = getDigitMask(keyBits, pass);
+
+      // Block histograms must be rebuilt every pass because keys move between blocks
+      jobSystem.parallelFor(blockCount, 1, countDigitsRange, &job);
+
+      uint32 startIndex = 0;
+      for (uint32 bucket = 0; bucket < RADIX_BUCKET_COUNT; bucket++)
+      {
+        for (uint32 block = 0; block < blockCount; block++)
+        {
+          const uint32 keyCount = blockHistograms[block][bucket];
+          blockHistograms[block][bucket] = startIndex;
+          startIndex += keyCount;
+        }
+      }
+
+      // Every key has the same digit when a single bucket starts at 0 and ends at count
+      const uint64 firstDigit = (src[0] >> job.shift) & job.mask;
+      const uint32 bucketEnd = firstDigit + 1 < RADIX_BUCKET_COUNT ?
+        blockHistograms[0][firstDigit + 1] : count;
+      if (blockHistograms[0][firstDigit] == 0 && bucketEnd == count)
+        continue;
+
+      jobSystem.parallelFor(blockCount, 1, scatterRange, &job);
+
+      uint64* swap = src;
+      src = dest;
+      dest = swap;
+    }
+
+    return src;
+  }
+
+  //
+  // Adaptive sort
+  //
+
+  uint64* adaptiveSort(uint64* keys, uint64* temp, uint32 count, uint32 keyBits)
+  {
+    if (keyBits > 64)
+      keyBits = 64;
+
+    if (count < 2 || keyBits == 0)
+      return keys;
+
+    const uint64 mask = keyBits == 64 ? ~0ULL : (1ULL << keyBits) - 1;
+    const uint32 maxDescents = count / SMOL_ADAPTIVE_SORT_MAX_DESCENT_RATIO;
+
+    uint32 descents = 0;
+    for (uint32 i = 1; i < count && descents <= maxDescents; i++)
+    {
+      if ((keys[i] & mask) < (keys[i - 1] & mask))
+        descents++;
+    }
+
+    if (descents == 0)
+      return keys;
+
+    if (descents > maxDescents)
+      return radixSortParallel(keys, temp, count, keyBits);
+
+    // Few descents do not mean keys are close to where they belong. Give up on
+    // insertion sort if it moves too many keys. Keys are still valid input for
+    // the radix sort.
+    uint64 movesLeft = (uint64) count * 8;
+    for (uint32 i = 1; i < count; i++)
+    {
+      const uint64 key = keys[i];
+      const uint64 value = key & mask;
+      uint32 j = i;
+      while (j > 0 && (keys[j - 1] & mask) > value)
+      {
+        keys[j] = keys[j - 1];
+        j--;
+      }
+      keys[j] = key;
+
+      const uint32 moves = i - j;
+      if (moves > movesLeft)
+        return radixSortParallel(keys, temp, count, keyBits);
+      movesLeft -= moves;
+    }
+
+    return keys;
+  }
+}
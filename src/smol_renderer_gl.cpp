@@ -13,6 +13,8 @@
 #include <smol/smol_render_target.h>
 #include <smol/smol_platform.h>
 #include <smol/smol_config_manager.h>
+#include <smol/smol_string_hash.h>
+#include <string.h>
 
 #ifndef SMOL_RELEASE
 #define checkGlError() _checkNoGlError(__FILE__, __LINE__)
@@ -54,6 +56,13 @@ static int32 _checkNoGlError(const char* file, uint32 line)
 #define checkGlError() 
 #endif
 
+// Build option: keep a CPU copy of the positions and indices of triangle
+// meshes so Scene::raycast() can test triangles. Set it to 0 to save memory.
+// Raycasts then only test mesh bounds.
+#ifndef SMOL_MESH_KEEP_TRIANGLES
+#define SMOL_MESH_KEEP_TRIANGLES 1
+#endif
+
 namespace smol
 {
   ShaderProgram Renderer::defaultShader = {};
@@ -64,9 +73,15 @@ namespace smol
   const size_t SMOL_UBO_FLOAT_DELTA_TIME      = (3 * sizeof(Mat4));
   const size_t SMOL_UBO_FLOAT_RANDOM_01       = (3 * sizeof(Mat4) + sizeof(float));
   const size_t SMOL_UBO_FLOAT_ELAPSED_SECONDS = (3 * sizeof(Mat4) + sizeof(float) * 2);
-  const size_t SMOL_UBO_SIZE                  = 4 * sizeof(Mat4) + 3 * sizeof(float);
+  const size_t SMOL_UBO_MAT4_VIEW_PROJ        = (3 * sizeof(Mat4) + sizeof(float) * 4); // std140 aligns mat4 to 16 bytes
+  const size_t SMOL_UBO_INT_INSTANCED         = SMOL_UBO_MAT4_VIEW_PROJ + sizeof(Mat4);
+  const size_t SMOL_UBO_SIZE                  = SMOL_UBO_INT_INSTANCED + sizeof(float) * 4; // std140 rounds the block size to 16 bytes
   const GLuint SMOL_GLOBALUBO_BINDING_POINT = 0;
 
+  // Model matrices of instanced draws. Shared by every mesh and orphaned on each upload.
+  static GLuint instanceVbo = 0;
+  static size_t instanceVboSize = 0;
+
   void Renderer::setMaterial(const Material* material)
   {
     GLuint shaderProgramId = 0; 
@@ -286,6 +301,95 @@ namespace smol
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
   }
 
+  void Renderer::updateCameraShaderParams(const Mat4& proj, const Mat4& view, const Mat4& viewProj, float deltaTime)
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, globalUbo);
+
+    // proj
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_MAT4_PROJ,
+        sizeof(Mat4), proj.e);
+    // view
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_MAT4_VIEW,
+        sizeof(Mat4), view.e);
+    // delta time, random01 and elapsed time are contiguous
+    float values[3];
+    values[0] = deltaTime;
+    values[1] = (float) smol::random01();
+    values[2] = Platform::getSecondsSinceStartup();
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_FLOAT_DELTA_TIME,
+        sizeof(values), values);
+    // viewProj
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_MAT4_VIEW_PROJ,
+        sizeof(Mat4), viewProj.e);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void Renderer::updateModelMatrix(const Mat4& model)
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, globalUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_MAT4_MODEL,
+        sizeof(Mat4), model.e);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  bool Renderer::isInstancingSupported(const Material* material)
+  {
+    ShaderProgram& shader = ResourceManager::get().getShader(material->shader);
+    if (shader.valid)
+      return shader.instancing;
+
+    return Renderer::getDefaultShaderProgram().instancing;
+  }
+
+  static void setInstancedFlag(GLint instanced)
+  {
+    glBindBuffer(GL_UNIFORM_BUFFER, globalUbo);
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_INT_INSTANCED,
+        sizeof(GLint), &instanced);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  }
+
+  void Renderer::drawMeshInstanced(const Mesh& mesh, const Mat4* modelMatrices, uint32 count)
+  {
+    const size_t size = count * sizeof(Mat4);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    while (instanceVboSize < size)
+      instanceVboSize = instanceVboSize ? instanceVboSize * 2 : 64 * sizeof(Mat4);
+
+    // Orphan the buffer so we don't wait for draws still reading the last upload
+    glBufferData(GL_ARRAY_BUFFER, instanceVboSize, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, modelMatrices);
+
+    // A mat4 attribute is fed as 4 column vectors
+    glBindVertexArray(mesh.vao);
+    for (GLuint column = 0; column < 4; column++)
+    {
+      const GLuint location = Mesh::INSTANCE_MODEL + column;
+      glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Mat4), (void*) (column * 4 * sizeof(float)));
+      glVertexAttribDivisor(location, 1);
+      glEnableVertexAttribArray(location);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    setInstancedFlag(1);
+    if (mesh.ibo != 0)
+    {
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+      glDrawElementsInstanced(mesh.glPrimitive, mesh.numIndices, GL_UNSIGNED_INT, nullptr, (GLsizei) count);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    else
+    {
+      glDrawArraysInstanced(mesh.glPrimitive, 0, mesh.numVertices, (GLsizei) count);
+    }
+    setInstancedFlag(0);
+
+    // Leave the vao as regular draws expect it
+    for (GLuint column = 0; column < 4; column++)
+      glDisableVertexAttribArray(Mesh::INSTANCE_MODEL + column);
+    glBindVertexArray(0);
+  }
+
   bool Renderer::createTextureRenderTarget(RenderTarget* out, int32 width, int32 height)
   {
     out->type = RenderTarget::TEXTURE;
@@ -349,8 +453,13 @@ namespace smol
     glGenBuffers(1, &globalUbo);
     glBindBuffer(GL_UNIFORM_BUFFER, globalUbo);
     glBufferData(GL_UNIFORM_BUFFER, SMOL_UBO_SIZE, (void*) SMOL_GLOBALUBO_BINDING_POINT, GL_STATIC_DRAW);
+    GLint instanced = 0;
+    glBufferSubData(GL_UNIFORM_BUFFER, SMOL_UBO_INT_INSTANCED, sizeof(GLint), &instanced);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+    glGenBuffers(1, &instanceVbo);
+    instanceVboSize = 0;
+
     if (config.enableGammaCorrection)
     {
       glEnable(GL_FRAMEBUFFER_SRGB); 
@@ -495,6 +604,7 @@ namespace smol
   bool Renderer::createShaderProgram(ShaderProgram* outShader, const char* vsSource, const char* fsSource, const char* gsSource)
   {
     outShader->valid = false;
+    outShader->instancing = false;
     outShader->glProgramId = 0;
 
     GLint status;
@@ -620,6 +730,7 @@ namespace smol
           break;
       }
 
+      parameter.hash = (uint64) stringToHash(parameter.name);
       parameter.glUniformLocation = glGetUniformLocation(program, parameter.name);
       outShader->parameterCount++;
     }
@@ -629,6 +740,8 @@ namespace smol
     glDeleteShader(fShader);
     if (gShader) glDeleteShader(gShader);
 
+    // Shaders opt into instancing by declaring the per instance model matrix
+    outShader->instancing = glGetAttribLocation(program, "smolInstanceModel") == Mesh::INSTANCE_MODEL;
     outShader->glProgramId = program;
     outShader->valid = true;
     return true;
@@ -649,11 +762,16 @@ namespace smol
           mat4 view;\n\
           mat4 model;\n\
           float deltaTime;\n\
+          float random01;\n\
+          float elapsedSeconds;\n\
+          mat4 viewProj;\n\
+          int instanced;\n\
       };\n\
     layout (location = 0) in vec3 vertPos;\n\
       layout (location = 1) in vec2 vertUVIn;\n\
+      layout (location = 5) in mat4 smolInstanceModel;\n\
       out vec2 uv;\n\
-      void main() { gl_Position = proj * view * model * vec4(vertPos, 1.0); uv = vertUVIn; }";
+      void main() { gl_Position = proj * view * (instanced != 0 ? smolInstanceModel : model) * vec4(vertPos, 1.0); uv = vertUVIn; }";
 
     const char* defaultFShader =
       "#version 330 core\n\
@@ -678,6 +796,14 @@ namespace smol
   // Mesh resources
   //
 
+  template <typename T>
+  static T* copyToCpu(T* copy, const T* source, int count)
+  {
+    copy = (T*) Platform::resizeMemory(copy, count * sizeof(T));
+    memcpy(copy, source, count * sizeof(T));
+    return copy;
+  }
+
   bool Renderer::createMesh(Mesh* outMesh,
       bool dynamic, Primitive primitive,
       const Vector3* vertices, int numVertices,
@@ -729,6 +855,20 @@ namespace smol
       glEnableVertexAttribArray(Mesh::POSITION);
     }
 
+    mesh->boundingBox = AABB::fromPoints(vertices, numVertices);
+    mesh->boundingSphere = BoundingSphere::fromPoints(vertices, numVertices);
+
+    mesh->positions = nullptr;
+    mesh->indices = nullptr;
+#if SMOL_MESH_KEEP_TRIANGLES
+    if (mesh->glPrimitive == GL_TRIANGLES && numVertices)
+    {
+      mesh->positions = copyToCpu(mesh->positions, vertices, numVertices);
+      if (numIndices)
+        mesh->indices = copyToCpu(mesh->indices, indices, numIndices);
+    }
+#endif
+
     mesh->ibo = 0;
     if (numIndices)
     {
@@ -808,6 +948,11 @@ namespace smol
 
       glBindBuffer(GL_ARRAY_BUFFER, 0);
       mesh->numVertices = (unsigned int) (verticesArraySize / sizeof(Vector3));
+      mesh->boundingBox = AABB::fromPoints(meshData->positions, meshData->numPositions);
+      mesh->boundingSphere = BoundingSphere::fromPoints(meshData->positions, meshData->numPositions);
+
+      if (mesh->positions)
+        mesh->positions = copyToCpu(mesh->positions, meshData->positions, meshData->numPositions);
     }
 
     if (meshData->indices)
@@ -832,6 +977,9 @@ namespace smol
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
         mesh->numIndices = (unsigned int) (indicesArraySize / sizeof(unsigned int));
+
+        if (mesh->indices)
+          mesh->indices = copyToCpu(mesh->indices, meshData->indices, meshData->numIndices);
       }
     }
 
@@ -915,6 +1063,11 @@ namespace smol
 
     glDeleteBuffers(numBuffers, (const GLuint*) buffers);
     glDeleteVertexArrays(1, (const GLuint*) &mesh->vao);
+
+    Platform::freeMemory(mesh->positions);
+    Platform::freeMemory(mesh->indices);
+    mesh->positions = nullptr;
+    mesh->indices = nullptr;
   }
 
 
@@ -7,6 +7,12 @@
 #include <smol/smol_image.h>
 #include <smol/smol_render_target.h>
 #include <smol/smol_renderer.h>
+#include <smol/smol_scene_manager.h>
+#include <smol/smol_pool_allocator.h>
+
+#ifndef SMOL_RESOURCE_MANAGER_MAX_MATERIALS
+#define SMOL_RESOURCE_MANAGER_MAX_MATERIALS (1 << 14)
+#endif
 
 namespace smol
 {
@@ -481,6 +487,11 @@ namespace smol
   {
     Mesh* mesh = meshes.lookup(handle);
     Renderer::updateMesh(mesh, meshData);
+
+    // New positions mean new bounds. The scene keeps the world bounds of mesh
+    // nodes on its spatial index and culls camera render keys with them.
+    if (mesh && meshData->positions)
+      SceneManager::get().getCurrentScene().invalidateRenderQueue();
   }
 
   void ResourceManager::destroyMesh(Handle<Mesh> handle)
@@ -508,7 +519,7 @@ namespace smol
     const int texHeight = height;
     const int squareSize = texWidth / squareCount;
     const int sizeInBytes = texWidth * texHeight * 3;
-    unsigned char *buffer = new unsigned char[sizeInBytes + sizeof(Image)];//TODO(marcio): Use our own memory manager here
+    unsigned char *buffer = (unsigned char*) Platform::getMemory(sizeInBytes + sizeof(Image), 0, MemoryTag::IMAGE);
     unsigned char *texData = buffer + sizeof(Image);
     unsigned char *pixel = texData;
 
@@ -548,7 +559,7 @@ namespace smol
   Image* ResourceManager::loadImageBitmap(const char* fileName)
   {
     const size_t imageHeaderSize = sizeof(Image);
-    char* buffer = Platform::loadFileToBuffer(fileName, nullptr, imageHeaderSize, imageHeaderSize);
+    char* buffer = Platform::loadFileToBuffer(fileName, nullptr, imageHeaderSize, imageHeaderSize, MemoryTag::IMAGE);
 
     if (buffer == nullptr)
     {
@@ -638,6 +649,22 @@ namespace smol
     Platform::unloadFileBuffer((const char*)image);
   }
 
+  // Fonts are stored in a single block. See the memory layout in loadFont().
+  static size_t getFontGlyphMapOffset(uint16 glyphCount, uint16 kerningCount)
+  {
+    const size_t offset = sizeof(FontInfo)
+      + kerningCount * sizeof(Kerning)
+      + glyphCount * sizeof(Glyph);
+    return (offset + 7) & ~((size_t) 7);
+  }
+
+  static size_t getFontMemorySize(uint16 glyphCount, uint16 kerningCount, size_t fontNameLen)
+  {
+    return getFontGlyphMapOffset(glyphCount, kerningCount)
+      + HashMap<uint16>::getMemorySize(glyphCount)
+      + fontNameLen + 1; // +1 for fontName null termiator
+  }
+
   Handle<Font> ResourceManager::loadFont(const char* fileName)
   {
     Config config(fileName);
@@ -652,12 +679,9 @@ namespace smol
 
     // reserve space for the font and the font name
     size_t fontNameLen = strlen(fontName);
-    size_t totalMemory = sizeof(FontInfo)
-      + glyphCount * sizeof(Glyph) 
-      + kerningCount * sizeof(Kerning)
-      + fontNameLen + 1; // +1 for fontName null termiator
+    size_t totalMemory = getFontMemorySize(glyphCount, kerningCount, fontNameLen);
 
-    char* memory = (char*) Platform::getMemory(totalMemory);
+    char* memory = (char*) PoolAllocator::get().getMemory(totalMemory);
     if (!memory)
       return INVALID_HANDLE(Font);
 
@@ -668,12 +692,14 @@ namespace smol
     info->lineHeight    = lineHeight;
     info->base          = base;
     // Memory layout
-    // ---------------------------------------------
-    //| FONT  | KERNINGS | GLYPHS | "Font Name"| 0 |
-    // ---------------------------------------------
+    // -----------------------------------------------------------
+    //| FONT  | KERNINGS | GLYPHS | GLYPH MAP | "Font Name"| 0 |
+    // -----------------------------------------------------------
+    const size_t glyphMapOffset = getFontGlyphMapOffset(glyphCount, kerningCount);
     info->kerning       = (Kerning*) (memory + sizeof(FontInfo));
     info->glyph         = (Glyph*) (memory + sizeof(FontInfo) + sizeof(Kerning) * kerningCount);
-    info->name          = (memory + sizeof(FontInfo) + sizeof(Kerning) * kerningCount + sizeof(Glyph) * glyphCount);
+    info->glyphMap.initialize(memory + glyphMapOffset, glyphCount);
+    info->name          = (memory + glyphMapOffset + HashMap<uint16>::getMemorySize(glyphCount));
 
     // copy the font name after the Font structure and null terminate it
     strncpy((char*)info->name, fontName, fontNameLen + 1);
@@ -727,6 +753,7 @@ namespace smol
 
       glyph.kerningCount   = count;
       glyph.kerningStart   = startIndex;
+      info->glyphMap.insert(id, (uint16) i);
       last = (ConfigEntry*) entry;
     }
 
@@ -748,13 +775,13 @@ namespace smol
     {
       const FontInfo* info = font->getFontInfo();
       destroyTexture(info->texture);
-      Platform::freeMemory((void*)info);
+      PoolAllocator::get().freeMemory((void*)info, getFontMemorySize(info->glyphCount, info->kerningCount, strlen(info->name)));
       fonts.remove(handle);
     }
   }
 
   ResourceManager::ResourceManager():
-    initialized(false), textures(16), shaders(16), materials(16), meshes(16 * sizeof(Mesh)), fonts(4)
+    initialized(false), textures(16), shaders(16), materials(16, SMOL_RESOURCE_MANAGER_MAX_MATERIALS), meshes(16 * sizeof(Mesh)), fonts(4)
   { }
 
   ResourceManager& ResourceManager::get()
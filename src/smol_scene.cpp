@@ -8,24 +8,136 @@
 #include <smol/smol_vector3.h>
 #include <smol/smol_vector2.h>
 #include <smol/smol_cfg_parser.h>
+#include <smol/smol_frame_allocator.h>
+#include <smol/smol_job_system.h>
+#include <smol/smol_radix_sort.h>
+#include <smol/smol_render_key.h>
+#include <smol/smol_bounds.h>
+#include <smol/smol_aabb_tree.h>
+#include <smol/smol_spatial_hash.h>
 #include <string.h>
+#include <math.h>
 #include <utility>
+#include <new>
+
+// Nodes and renderables never move when the scene grows, so pointers to them
+// can be held while new nodes are created.
+#ifndef SMOL_SCENE_MAX_NODES
+#define SMOL_SCENE_MAX_NODES (1 << 20)
+#endif
+
+#ifndef SMOL_SCENE_MAX_RENDERABLES
+#define SMOL_SCENE_MAX_RENDERABLES (1 << 16)
+#endif
+
+// Build option: number of nodes each job handles when updating transforms and
+// generating render keys.
+#ifndef SMOL_SCENE_JOB_BATCH_SIZE
+#define SMOL_SCENE_JOB_BATCH_SIZE 1024
+#endif
+
+// Build option: shortest run of consecutive meshes sharing a renderable drawn
+// as instances. Shorter runs draw one node at a time.
+#ifndef SMOL_SCENE_MIN_INSTANCES
+#define SMOL_SCENE_MIN_INSTANCES 2
+#endif
 
 #define warnInvalidHandle(typeName) debugLogWarning("Attempting to reference a '%s' resource from an invalid handle", (typeName))
 namespace smol
 {
+  static bool onEventForwarder(const Event& event, void* ptrScene)
+  {
+    Scene* scene = (Scene*) ptrScene;
+    return scene->onEvent(event);
+  }
+
+  // Sorted render keys of a camera from the last frame. They are reused while
+  // neither the camera nor any mesh moves.
+  struct CameraRenderQueue
+  {
+    uint64* keys;                 // two halves of capacity keys. Sorting ping-pongs between them.
+    uint64* sortedKeys;           // the half holding the sorted keys
+    int32 capacity;
+    int32 count;                  // -1 when keys must be built from scratch
+    uint32 nodeIndex;
+  };
+
+  // Render keys kept between frames. New nodes append their keys, anything else
+  // that changes which nodes draw or with which material rebuilds the queue.
+  struct SceneRenderQueue
+  {
+    uint64* keys;                 // active nodes that draw, in node order
+    uint64* cameraKeys;           // active cameras, in priority order
+    CameraRenderQueue* cameras;   // one per camera key
+    uint64* materialKeys;         // materials sorted by render queue, shader and texture
+    uint16* materialRank;         // position of each material on materialKeys
+    uint16* rankToMaterial;
+    int32 count;
+    int32 capacity;
+    int32 cameraCount;
+    int32 cameraCapacity;
+    int32 materialCount;
+    int32 materialCapacity;
+    int32 nodeCount;              // nodes below this index have their keys on the queue
+    bool dirty;                   // must be rebuilt from scratch
+  };
+
+  // Mesh nodes on the AABB tree, sprite and text nodes on the spatial hash.
+  // Proxies are kept per handle slot because slots, unlike node indices, don't
+  // change when other nodes are destroyed.
+  struct SceneSpatialIndex
+  {
+    AABBTree tree;
+    SpatialHash spriteHash;
+    int32* slotProxy;             // -1 when the node of the slot is not indexed
+    int32 slotCapacity;
+    int32 nodeCount;              // node count on the last update
+    bool dirty;                   // every node must be visited on the next update
+  };
+
+  static int32 growCapacity(int32 capacity, int32 count)
+  {
+    if (capacity <= 0)
+      capacity = 64;
+    while (capacity < count)
+      capacity *= 2;
+    return capacity;
+  }
+
   Scene::Scene():
-    renderables(32),
-    nodes(32), 
-    batchers(8),
-    renderKeys(1024 * sizeof(uint64)),
-    renderKeysSorted(1024 * sizeof(uint64))
+    renderables(32, SMOL_SCENE_MAX_RENDERABLES),
+    nodes(32, SMOL_SCENE_MAX_NODES),
+    batchers(8)
   {
     viewMatrix = Mat4::initIdentity();
+    eventHandler = EventManager::get().addHandler(onEventForwarder, Event::DISPLAY, this);
+    renderQueue = (SceneRenderQueue*) Platform::getMemory(sizeof(SceneRenderQueue));
+    memset(renderQueue, 0, sizeof(SceneRenderQueue));
+    renderQueue->dirty = true;
+    spatialIndex = new (Platform::getMemory(sizeof(SceneSpatialIndex))) SceneSpatialIndex();
+    spatialIndex->slotProxy = nullptr;
+    spatialIndex->slotCapacity = 0;
+    spatialIndex->nodeCount = 0;
+    spatialIndex->dirty = true;
   }
 
   Scene::~Scene()
   {
+    EventManager::get().removeHandler(eventHandler);
+
+    for (int32 i = 0; i < renderQueue->cameraCapacity; i++)
+      Platform::freeMemory(renderQueue->cameras[i].keys);
+    Platform::freeMemory(renderQueue->keys);
+    Platform::freeMemory(renderQueue->cameraKeys);
+    Platform::freeMemory(renderQueue->cameras);
+    Platform::freeMemory(renderQueue->materialKeys);
+    Platform::freeMemory(renderQueue->materialRank);
+    Platform::freeMemory(renderQueue->rankToMaterial);
+    Platform::freeMemory(renderQueue);
+    Platform::freeMemory(spatialIndex->slotProxy);
+    spatialIndex->~SceneSpatialIndex();
+    Platform::freeMemory(spatialIndex);
+
     debugLogInfo("Scene Released Renderable x%d, SpriteBatcher x%d, SceneNode x%d.", 
         renderables.count(),
         batchers.count(),
@@ -60,6 +172,19 @@ namespace smol
     }
   }
 
+  void Scene::setRenderableMaterial(Handle<Renderable> handle, Handle<Material> material)
+  {
+    Renderable* renderable = renderables.lookup(handle);
+    if(!renderable)
+    {
+      warnInvalidHandle("Renderable");
+      return;
+    }
+
+    renderable->material = material;
+    invalidateRenderQueue();
+  }
+
   Handle<SpriteBatcher> Scene::createSpriteBatcher(Handle<Material> material, int capacity)
   {
     return batchers.add(SpriteBatcher(material, capacity));
@@ -78,6 +203,341 @@ namespace smol
     }
   }
 
+  //
+  // Spatial index
+  //
+
+  static inline uint64 encodeSpatialUserData(Handle<SceneNode> handle)
+  {
+    return ((uint64) (uint32) handle.version) << 32 | (uint32) handle.slotIndex;
+  }
+
+  static inline Handle<SceneNode> decodeSpatialUserData(uint64 userData)
+  {
+    Handle<SceneNode> handle;
+    handle.slotIndex = (int32) (uint32) userData;
+    handle.version = (int32) (uint32) (userData >> 32);
+    return handle;
+  }
+
+  static void removeNodeProxy(SceneSpatialIndex* index, const SceneNode& node, int32 slot)
+  {
+    if (slot < 0 || slot >= index->slotCapacity || index->slotProxy[slot] < 0)
+      return;
+
+    if (node.typeIs(SceneNode::MESH))
+      index->tree.remove(index->slotProxy[slot]);
+    else
+      index->spriteHash.remove(index->slotProxy[slot]);
+    index->slotProxy[slot] = -1;
+  }
+
+  static inline Rectf toRect(const AABB& box)
+  {
+    return Rectf(box.min.x, box.min.y, box.max.x - box.min.x, box.max.y - box.min.y);
+  }
+
+  // Sprites and glyphs are pushed with flipped Y, so a quad at position p
+  // covers y from -p.y - size.y to -p.y.
+  static bool getNodeWorldBounds(const SceneNode& node, HandleList<Renderable>* renderables, AABB* box)
+  {
+    AABB localBox;
+    if (node.typeIs(SceneNode::MESH))
+    {
+      const Renderable* renderable = renderables->lookup(node.mesh.renderable);
+      const Mesh* mesh = renderable ? renderable->mesh.operator->() : nullptr;
+      if (!mesh)
+        return false;
+      localBox = mesh->boundingBox;
+    }
+    else if (node.typeIs(SceneNode::SPRITE))
+    {
+      const Vector3 corners[] = { Vector3(0.0f), Vector3(node.sprite.width, -node.sprite.height, 0.0f) };
+      localBox = AABB::fromPoints(corners, 2);
+    }
+    else if (node.typeIs(SceneNode::TEXT))
+    {
+      const TextNode& text = node.text;
+      if (!text.drawData || text.textLen == 0)
+        return false;
+
+      for (size_t i = 0; i < text.textLen; i++)
+      {
+        const GlyphDrawData& glyph = text.drawData[i];
+        const Vector3 corners[] =
+        {
+          Vector3(glyph.position.x, -glyph.position.y, glyph.position.z),
+          Vector3(glyph.position.x + glyph.size.x, -glyph.position.y - glyph.size.y, glyph.position.z)
+        };
+        const AABB glyphBox = AABB::fromPoints(corners, 2);
+        localBox = i == 0 ? glyphBox : AABB::merge(localBox, glyphBox);
+      }
+    }
+    else
+    {
+      return false;
+    }
+
+    *box = localBox.transformed(node.transform.getMatrix());
+    return true;
+  }
+
+  // What updateSpatialIndex() does with each node
+  enum SpatialUpdate : uint8
+  {
+    SPATIAL_SKIP    = 0,
+    SPATIAL_INDEX   = 1,          // insert or move the node
+    SPATIAL_REMOVE  = 2           // remove the node if it's on the tree
+  };
+
+  struct SpatialBoundsJobData
+  {
+    const SceneNode* allNodes;
+    HandleList<Renderable>* renderables;
+    const uint8* nodeState;
+    AABB* worldBounds;
+    uint8* update;
+    bool fullUpdate;
+  };
+
+  // Reading nodes and transforming bounds is the expensive part of the
+  // update, so it runs on the job system. The tree and the hash are updated
+  // serially.
+  static void computeWorldBoundsRange(int32 start, int32 end, void* data)
+  {
+    SpatialBoundsJobData* job = (SpatialBoundsJobData*) data;
+    for (int32 i = start; i < end; i++)
+    {
+      const SceneNode& node = job->allNodes[i];
+      job->update[i] = SPATIAL_SKIP;
+
+      // Nodes never change their type so cameras are never indexed
+      if (node.typeIs(SceneNode::CAMERA)
+          || (!job->fullUpdate && !(job->nodeState[i] & Scene::NODE_TRANSFORM_CHANGED)))
+        continue;
+
+      if ((job->nodeState[i] & Scene::NODE_ACTIVE) && getNodeWorldBounds(node, job->renderables, &job->worldBounds[i]))
+        job->update[i] = SPATIAL_INDEX;
+      else if (job->fullUpdate)
+        job->update[i] = SPATIAL_REMOVE;   // nodes only leave the tree on full updates
+    }
+  }
+
+  // Only nodes whose transform changed are visited unless fullUpdate is set.
+  // Node creation, destruction and activation need a full update.
+  static void updateSpatialIndex(SceneSpatialIndex* index, HandleList<SceneNode>* nodes,
+      HandleList<Renderable>* renderables, const uint8* nodeState, bool fullUpdate)
+  {
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    ArenaMarker marker = frameAllocator.mark();
+    const int32 numNodes = nodes->count();
+
+    SpatialBoundsJobData jobData;
+    jobData.allNodes = nodes->getArray();
+    jobData.renderables = renderables;
+    jobData.nodeState = nodeState;
+    jobData.worldBounds = frameAllocator.push<AABB>(numNodes);
+    jobData.update = frameAllocator.push<uint8>(numNodes);
+    jobData.fullUpdate = fullUpdate;
+    JobSystem::get().parallelFor(numNodes, SMOL_SCENE_JOB_BATCH_SIZE, computeWorldBoundsRange, &jobData);
+
+    for (int32 i = 0; i < numNodes; i++)
+    {
+      if (jobData.update[i] == SPATIAL_SKIP)
+        continue;
+
+      const Handle<SceneNode> handle = nodes->getHandle(i);
+      if (handle.slotIndex >= index->slotCapacity)
+      {
+        const int32 oldCapacity = index->slotCapacity;
+        index->slotCapacity = growCapacity(index->slotCapacity, handle.slotIndex + 1);
+        index->slotProxy = (int32*) Platform::resizeMemory(index->slotProxy, index->slotCapacity * sizeof(int32));
+        for (int32 slot = oldCapacity; slot < index->slotCapacity; slot++)
+          index->slotProxy[slot] = -1;
+      }
+
+      int32& proxy = index->slotProxy[handle.slotIndex];
+      if (jobData.update[i] == SPATIAL_REMOVE)
+      {
+        removeNodeProxy(index, jobData.allNodes[i], handle.slotIndex);
+      }
+      else if (jobData.allNodes[i].typeIs(SceneNode::MESH))
+      {
+        if (proxy < 0)
+          proxy = index->tree.insert(jobData.worldBounds[i], encodeSpatialUserData(handle));
+        else
+          index->tree.update(proxy, jobData.worldBounds[i]);
+      }
+      else
+      {
+        const Rectf rect = toRect(jobData.worldBounds[i]);
+        if (proxy < 0)
+          proxy = index->spriteHash.insert(rect, encodeSpatialUserData(handle));
+        else
+          index->spriteHash.update(proxy, rect);
+      }
+    }
+
+    index->nodeCount = numNodes;
+    index->dirty = false;
+    frameAllocator.rewind(marker);
+  }
+
+  struct NodeQueryContext
+  {
+    Handle<SceneNode>* results;
+    int32 count;
+    int32 maxResults;
+  };
+
+  static bool collectNodeHandle(uint64 userData, void* context)
+  {
+    NodeQueryContext* query = (NodeQueryContext*) context;
+    query->results[query->count++] = decodeSpatialUserData(userData);
+    return query->count < query->maxResults;
+  }
+
+  int32 Scene::queryNodes(const AABB& box, Handle<SceneNode>* results, int32 maxResults) const
+  {
+    if (maxResults <= 0)
+      return 0;
+
+    NodeQueryContext query = { results, 0, maxResults };
+    spatialIndex->tree.query(box, collectNodeHandle, &query);
+    return query.count;
+  }
+
+  int32 Scene::queryNodes(const Frustum& frustum, Handle<SceneNode>* results, int32 maxResults) const
+  {
+    if (maxResults <= 0)
+      return 0;
+
+    NodeQueryContext query = { results, 0, maxResults };
+    spatialIndex->tree.query(frustum, collectNodeHandle, &query);
+    return query.count;
+  }
+
+  int32 Scene::queryNodes(const Rectf& rect, Handle<SceneNode>* results, int32 maxResults) const
+  {
+    if (maxResults <= 0)
+      return 0;
+
+    NodeQueryContext query = { results, 0, maxResults };
+    spatialIndex->spriteHash.query(rect, collectNodeHandle, &query);
+    return query.count;
+  }
+
+  int32 Scene::queryNearestNodes(const Vector3& point, int32 k, Handle<SceneNode>* results) const
+  {
+    if (k <= 0)
+      return 0;
+
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    ArenaMarker marker = frameAllocator.mark();
+    uint64* userData = frameAllocator.push<uint64>(k);
+    float* distances = frameAllocator.push<float>(k);
+
+    const int32 count = spatialIndex->tree.queryNearest(point, k, userData, distances);
+    for (int32 i = 0; i < count; i++)
+      results[i] = decodeSpatialUserData(userData[i]);
+
+    frameAllocator.rewind(marker);
+    return count;
+  }
+
+  struct SceneRaycastContext
+  {
+    const HandleList<SceneNode>* nodes;
+    const HandleList<Renderable>* renderables;
+    uint32 layerMask;
+    bool exact;
+    RaycastHit* hits;
+    int32 count;
+    int32 maxHits;
+  };
+
+  // Tests the node behind a tree leaf and keeps the closest hits sorted.
+  // Once maxHits were found the ray is clipped to the farthest of them.
+  static float raycastNode(uint64 userData, const Ray& ray, float maxDistance, void* context)
+  {
+    SceneRaycastContext* raycast = (SceneRaycastContext*) context;
+    const Handle<SceneNode> handle = decodeSpatialUserData(userData);
+    const SceneNode* node = raycast->nodes->lookup(handle);
+    if (!node || !(raycast->layerMask & node->getLayer()))
+      return maxDistance;
+
+    const Renderable* renderable = raycast->renderables->lookup(node->mesh.renderable);
+    const Mesh* mesh = renderable ? renderable->mesh.operator->() : nullptr;
+    if (!mesh)
+      return maxDistance;
+
+    // Ray in mesh space. The direction is transformed but not normalized so
+    // distances along both rays are the same.
+    const Mat4 toLocal = Mat4::affineInvert(node->transform.getMatrix());
+    const Vector3 localOrigin = Mat4::mul(toLocal, ray.origin);
+    const Vector3 localTarget = Mat4::mul(toLocal, ray.getPoint(1.0f));
+    const Ray localRay(localOrigin, Vector3(localTarget.x - localOrigin.x, localTarget.y - localOrigin.y, localTarget.z - localOrigin.z));
+
+    float distance;
+    if (!mesh->boundingBox.intersects(localRay, maxDistance, &distance))
+      return maxDistance;
+
+    int32 triangle = -1;
+    if (raycast->exact && mesh->positions)
+    {
+      const int32 numTriangles = mesh->indices ? mesh->numIndices / 3 : mesh->numVertices / 3;
+      triangle = localRay.intersectTriangles(mesh->positions, mesh->indices, numTriangles, maxDistance, &distance);
+      if (triangle < 0)
+        return maxDistance;
+    }
+
+    // Insertion sort. The farthest hit falls off when the list is full.
+    int32 i = raycast->count < raycast->maxHits ? raycast->count++ : raycast->maxHits - 1;
+    while (i > 0 && raycast->hits[i - 1].distance > distance)
+    {
+      raycast->hits[i] = raycast->hits[i - 1];
+      i--;
+    }
+
+    RaycastHit& hit = raycast->hits[i];
+    hit.node = handle;
+    hit.point = ray.getPoint(distance);
+    hit.distance = distance;
+    hit.triangle = triangle;
+
+    return raycast->count == raycast->maxHits ? raycast->hits[raycast->maxHits - 1].distance : maxDistance;
+  }
+
+  int32 Scene::raycast(const Ray& ray, uint32 layerMask, RaycastHit* hits, int32 maxHits, float maxDistance, bool exact) const
+  {
+    if (maxHits <= 0)
+      return 0;
+
+    SceneRaycastContext context = { &nodes, &renderables, layerMask, exact, hits, 0, maxHits };
+    spatialIndex->tree.raycast(ray, maxDistance, raycastNode, &context);
+    return context.count;
+  }
+
+  Handle<SceneNode> Scene::pick(const Point2& screenPoint, Handle<SceneNode> camera, RaycastHit* hit) const
+  {
+    const SceneNode* cameraNode = nodes.lookup(camera);
+    if (!cameraNode || !cameraNode->typeIs(SceneNode::CAMERA))
+    {
+      debugLogWarning("Scene::pick() needs a valid CAMERA node");
+      return INVALID_HANDLE(SceneNode);
+    }
+
+    // Hits past distance 1 are behind the far plane
+    const Ray ray = cameraNode->camera.screenPointToRay(screenPoint, Renderer::getViewport());
+    RaycastHit closest;
+    if (raycast(ray, cameraNode->camera.getLayerMask(), &closest, 1, 1.0f) == 0)
+      return INVALID_HANDLE(SceneNode);
+
+    if (hit)
+      *hit = closest;
+    return closest.node;
+  }
+
 #ifndef SMOL_MODULE_GAME
   Handle<SceneNode> Scene::createNode(SceneNode::Type type, const Transform& transform)
   {
@@ -87,10 +547,51 @@ namespace smol
   }
 #endif
 
+#ifndef SMOL_MODULE_GAME
+  void Scene::createNodes(int count, SceneNode::Type type, const Transform* transforms, Handle<SceneNode>* handles)
+  {
+    if (count <= 0)
+      return;
+
+    // Nodes reserved together are contiguous, so build them in place.
+    nodes.reserveMany(count, handles);
+    SceneNode* node = nodes.lookup(handles[0]);
+    for (int i = 0; i < count; i++)
+    {
+      new (node++) SceneNode(this, type, transforms[i]);
+    }
+  }
+
+  void Scene::destroyNodes(const Handle<SceneNode>* handles, int count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      SceneNode* node = nodes.lookup(handles[i]);
+      if (!node)
+        continue;
+
+      if (node->typeIs(SceneNode::Type::TEXT))
+        node->text.freeText();
+      removeNodeProxy(spatialIndex, *node, handles[i].slotIndex);
+    }
+
+    nodes.removeMany(handles, count);
+    invalidateRenderQueue();
+  }
+#endif
+
 #ifndef SMOL_MODULE_GAME
   void Scene::destroyNode(Handle<SceneNode> handle)
   {
+    SceneNode* node = nodes.lookup(handle);
+    if (node && node->typeIs(SceneNode::Type::TEXT))
+      node->text.freeText();
+
+    if (node)
+      removeNodeProxy(spatialIndex, *node, handle.slotIndex);
+
     nodes.remove(handle);
+    invalidateRenderQueue();
   }
 #endif
 
@@ -110,54 +611,6 @@ namespace smol
   // Internal rendering utility functions
   //
 
-  /**
-   * param elements - pointer to 64bit integers to be sorted.
-   * param elementCount - number of elements on elements array.
-   * param dest - destination buffer where to put the sorted list. This buffer
-   * must be large enough for storing elementCount elements.
-   */
-  static void radixSort(uint64* elements, uint32 elementCount,  uint64* dest)
-  {
-    for(int shiftIndex = 0; shiftIndex < 32; shiftIndex+=8)
-    {
-      const uint32 bucketCount = 255;
-      uint32 buckets[bucketCount] = {};
-
-      // count key parts
-      for(uint32 i = 0; i < elementCount; i++)
-      {
-        /// note we ignore the UPPER 32bit of the key
-        uint32 element = (uint32) elements[i];
-        int32 keySlice = (element >> shiftIndex) & 0xFF; // get lower part
-        buckets[keySlice]++;
-      }
-
-      // calculate sorted positions
-      uint32 startIndex = 0;
-      for(uint32 i = 0; i < bucketCount; i++)
-      {
-        uint32 keyCount = buckets[i];
-        buckets[i] = startIndex;
-        startIndex += keyCount;
-      }
-
-      // move elements to their correct position
-      for(uint32 i = 0; i < elementCount; i++)
-      {
-        uint64 element = elements[i];
-        int32 keySlice = (element >> shiftIndex) & 0xFF; 
-        uint32 destLocation = buckets[keySlice]++;
-        // move the WHOLE 64bit key
-        dest[destLocation] = element;
-      }
-
-      // swap buffers
-      uint64* temp = elements;
-      elements = dest;
-      dest = temp;
-    }
-  }
-
   static inline uint64 encodeRenderKey(SceneNode::Type nodeType, uint16 materialIndex, uint8 queue, uint32 nodeIndex)
   {
     // Render key format
@@ -177,10 +630,8 @@ namespace smol
     return ((uint32) key) >> 16;
   }
 
-  static inline uint32 getNodeTypeFromRenderKey(uint64 key)
-  {
-    return (uint32) key >> 8;
-  }
+  // Camera render keys are described in smol_render_key.h
+  static_assert(SMOL_SCENE_MAX_NODES <= (1 << 23), "Camera render keys have 23 bits for the node index");
 
   static void drawRenderable(const Renderable* renderable)
   {
@@ -201,55 +652,145 @@ namespace smol
     glBindVertexArray(0);
   }
 
-  static int drawSpriteNodes(Scene* scene, SpriteBatcher* batcher, uint64* renderKeyList, uint32 cameraLayers)
+  // Returns the end of the run of consecutive keys, starting at first, of
+  // meshes sharing the renderable of the first one.
+  static int32 findInstanceRunEnd(const SceneNode* allNodes, const uint64* renderKeys, int32 first, int32 numKeys)
+  {
+    const Handle<Renderable> renderable = allNodes[getNodeIndexFromCameraRenderKey(renderKeys[first])].mesh.renderable;
+    int32 end = first + 1;
+    while (end < numKeys && !(renderKeys[end] & CAMERA_RENDER_KEY_CULLED))
+    {
+      const SceneNode& node = allNodes[getNodeIndexFromCameraRenderKey(renderKeys[end])];
+      if (!node.typeIs(SceneNode::MESH) || node.mesh.renderable != renderable)
+        break;
+      end++;
+    }
+    return end;
+  }
+
+  // visibleNodes flags the sprites inside the camera view rect. When null
+  // every sprite on the camera layers is pushed.
+  static int drawSpriteNodes(Scene* scene, SpriteBatcher* batcher, const uint64* renderKeyList, uint32 cameraLayers, const uint8* visibleNodes)
   {
     const SceneNode* allNodes = scene->getNodes();
 
     batcher->begin();
     for (int i = 0; i < batcher->spriteNodeCount; i++)
     {
-      uint64 key = ((uint64*)renderKeyList)[i];
-      SceneNode* sceneNode = (SceneNode*) &allNodes[getNodeIndexFromRenderKey(key)];
+      uint64 key = renderKeyList[i];
+      const uint32 nodeIndex = getNodeIndexFromCameraRenderKey(key);
+      SceneNode* sceneNode = (SceneNode*) &allNodes[nodeIndex];
 
       // ignore sprites the current camera can't see
       if(!(cameraLayers & sceneNode->getLayer()))
         continue;
+      if (visibleNodes && !visibleNodes[nodeIndex])
+        continue;
       batcher->pushSpriteNode(sceneNode);
     }
     batcher->end();
     return batcher->spriteNodeCount - 1;
   }
 
-  void Scene::render(float deltaTime)
+  // Parent indices used by updateTransforms()
+  static const int32 NO_PARENT = -1;
+  static const int32 INVALID_PARENT = -2;
+
+  struct TransformJobData
   {
-    ResourceManager& resourceManager = ResourceManager::get();
-    const GLuint defaultShaderProgramId = resourceManager.getDefaultShader()->glProgramId;
-    const Material& defaultMaterial = resourceManager.getDefaultMaterial();
+    HandleList<SceneNode>* nodes;
+    SceneNode* allNodes;
+    int32* parentIndex;
+    const int32* order;       // nodes of the depth level being updated
+    uint8* nodeState;
+  };
 
-    const SceneNode* allNodes = nodes.getArray();
-    int numNodes = nodes.count();
+  static void resolveParentRange(int32 start, int32 end, void* data)
+  {
+    TransformJobData* job = (TransformJobData*) data;
+    for (int32 i = start; i < end; i++)
+    {
+      Handle<SceneNode> parent = job->allNodes[i].transform.getParent();
+      if (parent == INVALID_HANDLE(SceneNode))
+      {
+        job->parentIndex[i] = NO_PARENT;
+      }
+      else
+      {
+        SceneNode* parentNode = job->nodes->lookup(parent);
+        job->parentIndex[i] = (parentNode && parentNode->isValid()) ? (int32) (parentNode - job->allNodes) : INVALID_PARENT;
+      }
+    }
+  }
 
-    renderKeys.reset();
-    renderKeysSorted.reset();
+  // Nodes on the same depth level don't depend on each other, so any range of
+  // a level can be updated in parallel once the previous level is done.
+  static void updateTransformRange(int32 start, int32 end, void* data)
+  {
+    TransformJobData* job = (TransformJobData*) data;
+    SceneNode* allNodes = job->allNodes;
+    uint8* nodeState = job->nodeState;
+    const Mat4 identity = Mat4::initIdentity();
 
-    // ----------------------------------------------------------------------
-    // Update sceneNodes and generate render keys
-    int numCameras = 0;
+    for (int32 orderIndex = start; orderIndex < end; orderIndex++)
+    {
+      const int32 i = job->order[orderIndex];
+      const int32 p = job->parentIndex[i];
+      SceneNode& node = allNodes[i];
+      uint8 state = 0;
+
+      const bool parentActive = (p == NO_PARENT) || (p >= 0 && (nodeState[p] & Scene::NODE_ACTIVE));
+      const bool parentChanged = (p >= 0) && (nodeState[p] & Scene::NODE_TRANSFORM_CHANGED);
+
+      if (node.isValid() && node.isActive() && parentActive)
+      {
+        state = Scene::NODE_ACTIVE;
+        if (node.transform.isLocalDirty() || parentChanged)
+        {
+          node.transform.updateMatrix(p >= 0 ? allNodes[p].transform.getMatrix() : identity);
+          node.transform.setDirty(false);
+          state |= Scene::NODE_TRANSFORM_CHANGED;
+        }
+      }
+      else if (parentChanged)
+      {
+        // Inactive nodes are not updated. Remember to do it when they become active.
+        node.transform.setDirty(true);
+      }
 
-    for(int i = 0; i < numNodes; i++)
+      nodeState[i] = state;
+    }
+  }
+
+  struct RenderKeyJobData
+  {
+    const SceneNode* allNodes;
+    const uint8* nodeState;
+    HandleList<Renderable>* renderables;
+    int32 firstNode;            // node of the first element of the range
+    uint64* renderKeys;         // each batch writes its keys starting at its first element
+    int32* batchKeyCount;
+    int32* batchCameraCount;
+  };
+
+  static void generateRenderKeyBatch(RenderKeyJobData* job, int32 batch, int32 start, int32 end)
+  {
+    uint64* renderKeys = job->renderKeys + start;
+    int32 numKeys = 0;
+    int32 numCameras = 0;
+
+    for (int32 i = job->firstNode + start; i < job->firstNode + end; i++)
     {
-      SceneNode* node = (SceneNode*) &allNodes[i];
-      Renderable* renderable = nullptr;
+      const SceneNode* node = &job->allNodes[i];
       uint64 key = 0;
 
-      if (!node->isActiveInHierarchy())
+      if (!(job->nodeState[i] & Scene::NODE_ACTIVE))
         continue;
 
       switch(node->getType())
       {
         case SceneNode::CAMERA:
           {
-            node->transform.update(*this);
             key = encodeRenderKey(node->getType(), 0, node->camera.getPriority(), i);
             numCameras++;
           }
@@ -257,8 +798,7 @@ namespace smol
 
         case SceneNode::MESH:
           {
-            node->transform.update(*this);
-            renderable = renderables.lookup(node->mesh.renderable);
+            Renderable* renderable = job->renderables->lookup(node->mesh.renderable);
             Handle<Material> material = renderable->material;
             key = encodeRenderKey(node->getType(), (uint16)(material.slotIndex), material->renderQueue, i);
           }
@@ -266,24 +806,13 @@ namespace smol
 
         case SceneNode::TEXT:
           {
-            node->transform.update(*this);
-            if (node->transform.isDirty(*this) || node->isDirty())
-            {
-              SpriteBatcher* batcher = batchers.lookup(node->text.batcher);
-              batcher->dirty = true;
-            }
             Handle<Material> material = node->text.batcher->material;
             key = encodeRenderKey(node->getType(), (uint16)(material.slotIndex), material->renderQueue, i);
           }
           break;
+
         case SceneNode::SPRITE:
           {
-            node->transform.update(*this);
-            if (node->transform.isDirty(*this) || node->isDirty())
-            {
-              SpriteBatcher* batcher = batchers.lookup(node->sprite.batcher);
-              batcher->dirty = true;
-            }
             Handle<Material> material = node->sprite.batcher->material;
             key = encodeRenderKey(node->getType(), (uint16)(material.slotIndex), material->renderQueue, i);
           }
@@ -295,20 +824,386 @@ namespace smol
       }
 
       // save the key if the node is active
-      node->transform.update(*this);
-      uint64* keyPtr = (uint64*) renderKeys.pushSize(sizeof(uint64));
-      *keyPtr = key;
+      renderKeys[numKeys++] = key;
+    }
+
+    job->batchKeyCount[batch] = numKeys;
+    job->batchCameraCount[batch] = numCameras;
+  }
+
+  static void generateRenderKeyRange(int32 start, int32 end, void* data)
+  {
+    // Every batch gets its own counts no matter how many batches a range spans
+    RenderKeyJobData* job = (RenderKeyJobData*) data;
+    while (start < end)
+    {
+      const int32 batch = start / SMOL_SCENE_JOB_BATCH_SIZE;
+      const int32 batchEnd = (batch + 1) * SMOL_SCENE_JOB_BATCH_SIZE;
+      generateRenderKeyBatch(job, batch, start, batchEnd < end ? batchEnd : end);
+      start = batchEnd;
+    }
+  }
+
+  struct CameraRenderKeyJobData
+  {
+    const SceneNode* allNodes;
+    const uint64* renderKeys;   // render queue keys, or last frame camera keys when updating them
+    uint64* cameraKeys;
+    const uint16* materialRank;
+    const uint8* visibleNodes;  // nonzero for meshes on the camera frustum
+    const Mat4* viewMatrix;
+    float zNear;
+    float depthScale;
+    bool logarithmicDepth;
+  };
+
+  static uint32 quantizeViewDepth(float depth, const CameraRenderKeyJobData* job)
+  {
+    // Perspective cameras get more precision close to the camera where it matters
+    float t;
+    if (job->logarithmicDepth)
+      t = depth > job->zNear ? logf(depth / job->zNear) * job->depthScale : 0.0f;
+    else
+      t = (depth - job->zNear) * job->depthScale;
+
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (uint32) (t * RENDER_KEY_MAX_DEPTH);
+  }
+
+  static uint32 getMeshViewDepth(const SceneNode* node, const CameraRenderKeyJobData* job)
+  {
+    const Mat4& view = *job->viewMatrix;
+    const Mat4& world = node->transform.getMatrix();
+    const float x = world.e[3][0];
+    const float y = world.e[3][1];
+    const float z = world.e[3][2];
+    // Cameras look down -Z
+    const float viewDepth = -(view.e[0][2] * x + view.e[1][2] * y + view.e[2][2] * z + view.e[3][2]);
+    return quantizeViewDepth(viewDepth, job);
+  }
+
+  // Culled meshes keep their queue and material so the key can be updated next frame
+  static uint64 encodeMeshCameraRenderKey(const SceneNode* node, uint32 nodeIndex, uint8 queue, uint16 materialRank,
+      const CameraRenderKeyJobData* job)
+  {
+    if (!job->visibleNodes[nodeIndex])
+      return encodeCameraRenderKey(nodeIndex, queue, materialRank, 0) | CAMERA_RENDER_KEY_CULLED;
+    return encodeCameraRenderKey(nodeIndex, queue, materialRank, getMeshViewDepth(node, job));
+  }
+
+  static void generateCameraRenderKeyRange(int32 start, int32 end, void* data)
+  {
+    CameraRenderKeyJobData* job = (CameraRenderKeyJobData*) data;
+    for (int32 i = start; i < end; i++)
+    {
+      const uint64 key = job->renderKeys[i];
+      const uint32 nodeIndex = getNodeIndexFromRenderKey(key);
+      const SceneNode* node = &job->allNodes[nodeIndex];
+
+      const uint8 queue = (uint8) key;
+      const uint16 materialRank = job->materialRank[getMaterialIndexFromRenderKey(key)];
+
+      // Sprites and text are drawn by their batcher all at once so depth and culling do not apply
+      if (node->typeIs(SceneNode::MESH))
+        job->cameraKeys[i] = encodeMeshCameraRenderKey(node, nodeIndex, queue, materialRank, job);
+      else
+        job->cameraKeys[i] = encodeBatchedCameraRenderKey(node->getType(), nodeIndex, queue, materialRank);
     }
+  }
+
+  // Same as generateCameraRenderKeyRange() but starts from the camera keys of
+  // the last frame. Only depth and visibility change, so keys stay close to
+  // sorted order.
+  static void updateCameraRenderKeyRange(int32 start, int32 end, void* data)
+  {
+    CameraRenderKeyJobData* job = (CameraRenderKeyJobData*) data;
+    for (int32 i = start; i < end; i++)
+    {
+      const uint64 key = job->renderKeys[i];
+      const uint32 nodeIndex = getNodeIndexFromCameraRenderKey(key);
+      const SceneNode* node = &job->allNodes[nodeIndex];
+
+      if (!node->typeIs(SceneNode::MESH))
+      {
+        job->cameraKeys[i] = key;
+        continue;
+      }
+
+      job->cameraKeys[i] = encodeMeshCameraRenderKey(node, nodeIndex, (uint8) (key >> 32),
+          (uint16) getMaterialRankFromCameraRenderKey(key), job);
+    }
+  }
+
+  const uint8* Scene::updateTransforms()
+  {
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    SceneNode* allNodes = (SceneNode*) nodes.getArray();
+    const int32 numNodes = nodes.count();
+    uint8* nodeState = frameAllocator.push<uint8>(numNodes);
+
+    if (numNodes == 0)
+      return nodeState;
+
+    // Everything below is scratch memory for this function only
+    ArenaMarker marker = frameAllocator.mark();
+    int32* parentIndex = frameAllocator.push<int32>(numNodes);
+    int32* depth = frameAllocator.push<int32>(numNodes);
+    int32* order = frameAllocator.push<int32>(numNodes);
+    int32 maxDepth = 0;
+
+    JobSystem& jobSystem = JobSystem::get();
+    TransformJobData jobData;
+    jobData.nodes = &nodes;
+    jobData.allNodes = allNodes;
+    jobData.parentIndex = parentIndex;
+    jobData.order = order;
+    jobData.nodeState = nodeState;
+    jobSystem.parallelFor(numNodes, SMOL_SCENE_JOB_BATCH_SIZE, resolveParentRange, &jobData);
+
+    for (int32 i = 0; i < numNodes; i++)
+      depth[i] = -1;
+
+    // Find the depth of each node. Each node is visited once: we walk up until
+    // we reach a node with a known depth and then assign depths on the way back.
+    int32* chain = order; // order is not in use yet
+    for (int32 i = 0; i < numNodes; i++)
+    {
+      int32 chainLength = 0;
+      int32 nodeIndex = i;
+      while (nodeIndex >= 0 && depth[nodeIndex] < 0)
+      {
+        SMOL_ASSERT(chainLength < numNodes, "Cycle found in the scene node hierarchy", 0);
+        chain[chainLength++] = nodeIndex;
+        nodeIndex = parentIndex[nodeIndex];
+      }
+
+      int32 nodeDepth = nodeIndex >= 0 ? depth[nodeIndex] : -1;
+      while (chainLength > 0)
+      {
+        depth[chain[--chainLength]] = ++nodeDepth;
+      }
+
+      if (nodeDepth > maxDepth)
+        maxDepth = nodeDepth;
+    }
+
+    // Counting sort by depth so parents always come before their children
+    int32* depthStart = frameAllocator.push<int32>(maxDepth + 1);
+    memset(depthStart, 0, (maxDepth + 1) * sizeof(int32));
+    for (int32 i = 0; i < numNodes; i++)
+      depthStart[depth[i]]++;
+
+    int32 start = 0;
+    for (int32 d = 0; d <= maxDepth; d++)
+    {
+      int32 count = depthStart[d];
+      depthStart[d] = start;
+      start += count;
+    }
+
+    for (int32 i = 0; i < numNodes; i++)
+      order[depthStart[depth[i]]++] = i;
+
+    // Update world matrices one depth level at a time. Changes propagate down
+    // through NODE_TRANSFORM_CHANGED. depthStart[d] is now the end of level d.
+    int32 levelStart = 0;
+    for (int32 d = 0; d <= maxDepth; d++)
+    {
+      jobData.order = order + levelStart;
+      jobSystem.parallelFor(depthStart[d] - levelStart, SMOL_SCENE_JOB_BATCH_SIZE, updateTransformRange, &jobData);
+      levelStart = depthStart[d];
+    }
+
+    frameAllocator.rewind(marker);
+
+    const bool nodesChanged = spatialIndex->dirty || numNodes != spatialIndex->nodeCount;
+    updateSpatialIndex(spatialIndex, &nodes, &renderables, nodeState, nodesChanged);
+    return nodeState;
+  }
+
+  struct VisibleNodeQuery
+  {
+    HandleList<SceneNode>* nodes;
+    const SceneNode* allNodes;
+    uint8* visibleNodes;
+  };
+
+  static bool markVisibleNode(uint64 userData, void* context)
+  {
+    VisibleNodeQuery* query = (VisibleNodeQuery*) context;
+    const SceneNode* node = query->nodes->lookup(decodeSpatialUserData(userData));
+    query->visibleNodes[node - query->allNodes] = 1;
+    return true;
+  }
+
+  // World XY rect seen by an orthographic camera. The corners of the view
+  // volume are taken back to world space, so cameras that are rotated get a
+  // larger rect that still contains everything they see.
+  static Rectf getOrthographicViewRect(const Camera& camera)
+  {
+    const Mat4 inverseViewProjection = Mat4::invert(camera.getViewProjectionMatrix());
+    Vector3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+      const Vector3 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+      corners[i] = Mat4::mul(inverseViewProjection, ndc);
+    }
+    return toRect(AABB::fromPoints(corners, 8));
+  }
+
+  // Ranks materials by render queue, shader and texture. Returns true if any
+  // material changed since the last call.
+  static bool updateMaterialRanks(SceneRenderQueue* queue, const Material* allMaterials, int32 materialCount)
+  {
+    SMOL_ASSERT(materialCount <= 0xFFFF, "Too many materials for a camera render key", 0);
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    uint64* materialKeys = frameAllocator.push<uint64>(materialCount);
+    uint64* materialKeysTemp = frameAllocator.push<uint64>(materialCount);
+    for (int32 m = 0; m < materialCount; m++)
+    {
+      const Material& material = allMaterials[m];
+      const uint8 renderQueue = (uint8) material.renderQueue;
+      const uint16 shader = (uint16) material.shader.slotIndex;
+      const uint16 texture = material.diffuseTextureCount > 0 ? (uint16) material.textureDiffuse[0].slotIndex : 0;
+      materialKeys[m] = ((uint64) renderQueue) << 48 | ((uint64) shader) << 32 | ((uint64) texture) << 16 | (uint16) m;
+    }
+
+    uint64* sortedMaterials = radixSort(materialKeys, materialKeysTemp, materialCount, 56);
+    if (materialCount == queue->materialCount
+        && (materialCount == 0 || memcmp(sortedMaterials, queue->materialKeys, materialCount * sizeof(uint64)) == 0))
+      return false;
+
+    if (materialCount > queue->materialCapacity)
+    {
+      queue->materialCapacity = growCapacity(queue->materialCapacity, materialCount);
+      queue->materialKeys = (uint64*) Platform::resizeMemory(queue->materialKeys, queue->materialCapacity * sizeof(uint64));
+      queue->materialRank = (uint16*) Platform::resizeMemory(queue->materialRank, queue->materialCapacity * sizeof(uint16));
+      queue->rankToMaterial = (uint16*) Platform::resizeMemory(queue->rankToMaterial, queue->materialCapacity * sizeof(uint16));
+    }
+
+    memcpy(queue->materialKeys, sortedMaterials, materialCount * sizeof(uint64));
+    queue->materialCount = materialCount;
+    for (int32 rank = 0; rank < materialCount; rank++)
+    {
+      const uint16 m = (uint16) sortedMaterials[rank];
+      queue->materialRank[m] = (uint16) rank;
+      queue->rankToMaterial[rank] = m;
+    }
+    return true;
+  }
+
+  // Generates render keys for nodes in [firstNode, lastNode) and appends them to the queue
+  static void appendRenderKeys(SceneRenderQueue* queue, const SceneNode* allNodes, const uint8* nodeState,
+      HandleList<Renderable>* renderables, int32 firstNode, int32 lastNode)
+  {
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    const int32 nodeCount = lastNode - firstNode;
+    const int32 numBatches = (nodeCount + SMOL_SCENE_JOB_BATCH_SIZE - 1) / SMOL_SCENE_JOB_BATCH_SIZE;
+
+    RenderKeyJobData keyJobData;
+    keyJobData.allNodes = allNodes;
+    keyJobData.nodeState = nodeState;
+    keyJobData.renderables = renderables;
+    keyJobData.firstNode = firstNode;
+    keyJobData.renderKeys = frameAllocator.push<uint64>(nodeCount);
+    keyJobData.batchKeyCount = frameAllocator.push<int32>(numBatches);
+    keyJobData.batchCameraCount = frameAllocator.push<int32>(numBatches);
+    JobSystem::get().parallelFor(nodeCount, SMOL_SCENE_JOB_BATCH_SIZE, generateRenderKeyRange, &keyJobData);
+
+    int32 numCameras = 0;
+    for (int32 batch = 0; batch < numBatches; batch++)
+      numCameras += keyJobData.batchCameraCount[batch];
+
+    if (queue->count + nodeCount > queue->capacity)
+    {
+      queue->capacity = growCapacity(queue->capacity, queue->count + nodeCount);
+      queue->keys = (uint64*) Platform::resizeMemory(queue->keys, queue->capacity * sizeof(uint64));
+    }
+
+    if (queue->cameraCount + numCameras > queue->cameraCapacity)
+    {
+      const int32 oldCapacity = queue->cameraCapacity;
+      queue->cameraCapacity = growCapacity(queue->cameraCapacity, queue->cameraCount + numCameras);
+      queue->cameraKeys = (uint64*) Platform::resizeMemory(queue->cameraKeys, queue->cameraCapacity * sizeof(uint64));
+      queue->cameras = (CameraRenderQueue*) Platform::resizeMemory(queue->cameras, queue->cameraCapacity * sizeof(CameraRenderQueue));
+      memset(queue->cameras + oldCapacity, 0, (queue->cameraCapacity - oldCapacity) * sizeof(CameraRenderQueue));
+    }
+
+    // Merge the keys of every batch. Keys keep the same order as the nodes.
+    for (int32 batch = 0; batch < numBatches; batch++)
+    {
+      const uint64* batchKeys = keyJobData.renderKeys + batch * SMOL_SCENE_JOB_BATCH_SIZE;
+      for (int32 k = 0; k < keyJobData.batchKeyCount[batch]; k++)
+      {
+        const uint64 key = batchKeys[k];
+        if (allNodes[getNodeIndexFromRenderKey(key)].typeIs(SceneNode::CAMERA))
+          queue->cameraKeys[queue->cameraCount++] = key;
+        else
+          queue->keys[queue->count++] = key;
+      }
+    }
+
+    queue->nodeCount = lastNode;
+  }
+
+  void Scene::render(float deltaTime)
+  {
+    ResourceManager& resourceManager = ResourceManager::get();
+    const GLuint defaultShaderProgramId = resourceManager.getDefaultShader()->glProgramId;
+    const Material& defaultMaterial = resourceManager.getDefaultMaterial();
+
+    const SceneNode* allNodes = nodes.getArray();
+    int numNodes = nodes.count();
+    FrameAllocator& frameAllocator = FrameAllocator::get();
+    SceneRenderQueue* queue = renderQueue;
 
     // ----------------------------------------------------------------------
-    // Sort keys
-    const int32 numKeysToSort = (int32) (renderKeys.getUsed() / sizeof(uint64));
-    radixSort((uint64*) renderKeys.getData(), numKeysToSort, (uint64*) renderKeysSorted.pushSize(renderKeys.getUsed()));
+    // Update sceneNodes and the render queue
+    const uint8* nodeState = updateTransforms();
 
-    // Cameras will be the first nodes on the sorted list. We use that to iterate all cameras
-    uint64* allCameraKeys = (uint64*) renderKeysSorted.getData();
-    uint64* allRenderKeys = allCameraKeys + numCameras;
-    const int32 numKeys = numKeysToSort - numCameras; // don't count with camera nodes;
+    int materialCount = 0;
+    const Material* allMaterials = resourceManager.getMaterials(&materialCount);
+    if (updateMaterialRanks(queue, allMaterials, materialCount))
+      queue->dirty = true;
+
+    const bool queueChanged = updateRenderQueue(nodeState);
+
+    // Batchers are shared between nodes so they are flagged here instead of
+    // inside the jobs. Nodes are only marked dirty when they are created or
+    // activated, and both change the queue.
+    const uint64* allRenderKeys = queue->keys;
+    const int32 numKeys = queue->count;
+    bool meshMoved = false;
+    for (int32 keyIndex = 0; keyIndex < numKeys; keyIndex++)
+    {
+      const int32 i = getNodeIndexFromRenderKey(allRenderKeys[keyIndex]);
+      if (!queueChanged && !(nodeState[i] & NODE_TRANSFORM_CHANGED))
+        continue;
+
+      SceneNode* node = (SceneNode*) &allNodes[i];
+      if (node->typeIs(SceneNode::MESH))
+      {
+        meshMoved |= (nodeState[i] & NODE_TRANSFORM_CHANGED) != 0;
+      }
+      else if ((nodeState[i] & NODE_TRANSFORM_CHANGED) || node->isDirty())
+      {
+        Handle<SpriteBatcher> batcher = node->typeIs(SceneNode::TEXT) ? node->text.batcher : node->sprite.batcher;
+        batchers.lookup(batcher)->dirty = true;
+      }
+      node->setDirty(false);
+    }
+
+    // Cameras render in priority order. Priorities can change at any time so
+    // they are sorted every frame. Their key is the priority on the lowest 8 bits.
+    const int32 numCameras = queue->cameraCount;
+    for (int32 cameraIndex = 0; cameraIndex < numCameras; cameraIndex++)
+    {
+      const uint32 i = getNodeIndexFromRenderKey(queue->cameraKeys[cameraIndex]);
+      queue->cameraKeys[cameraIndex] = encodeRenderKey(SceneNode::CAMERA, 0, allNodes[i].camera.getPriority(), i);
+    }
+    uint64* cameraKeysTemp = frameAllocator.push<uint64>(numCameras);
+    const uint64* allCameraKeys = radixSort(queue->cameraKeys, cameraKeysTemp, numCameras, 8);
 
     for(int cameraIndex = 0; cameraIndex < numCameras; cameraIndex++)
     {
@@ -316,8 +1211,82 @@ namespace smol
       SceneNode* cameraNode = (SceneNode*) &allNodes[getNodeIndexFromRenderKey(cameraKey)];
       SMOL_ASSERT(cameraNode->typeIs(SceneNode::Type::CAMERA), "SceneNode is CAMERA", cameraNode->getType());
 
-      //TODO(marcio): When we have an event system, linsten for display resized event and only update camera matrices in case of an event.
-      cameraNode->camera.update();
+      // Camera matrices are cached. Projection only changes when the display is
+      // resized and the view only when the camera transform changes.
+      const uint32 cameraNodeIndex = getNodeIndexFromRenderKey(cameraKey);
+      const bool cameraMoved = (nodeState[cameraNodeIndex] & NODE_TRANSFORM_CHANGED) != 0;
+      const bool viewChanged = cameraNode->camera.updateView(cameraNode->transform.getMatrix(), cameraMoved);
+
+      // ----------------------------------------------------------------------
+      // Sort render keys by queue, view depth and material for this camera.
+      // Keys sorted last frame are reused until the camera or a mesh moves.
+      CameraRenderQueue& cameraQueue = queue->cameras[cameraIndex];
+      if (cameraQueue.capacity < numKeys)
+      {
+        cameraQueue.capacity = growCapacity(cameraQueue.capacity, numKeys);
+        cameraQueue.keys = (uint64*) Platform::resizeMemory(cameraQueue.keys, 2 * cameraQueue.capacity * sizeof(uint64));
+        cameraQueue.count = -1;
+      }
+
+      const Camera& camera = cameraNode->camera;
+      const float zNear = camera.getNearClipDistance();
+      const float zFar = camera.getFarClipDistance();
+      CameraRenderKeyJobData cameraKeyJobData;
+      cameraKeyJobData.allNodes = allNodes;
+      cameraKeyJobData.materialRank = queue->materialRank;
+      cameraKeyJobData.visibleNodes = nullptr;
+      cameraKeyJobData.viewMatrix = &camera.getViewMatrix();
+      cameraKeyJobData.zNear = zNear;
+      cameraKeyJobData.logarithmicDepth = camera.getCameraType() == Camera::PERSPECTIVE && zNear > 0.0f && zFar > zNear;
+      if (cameraKeyJobData.logarithmicDepth)
+        cameraKeyJobData.depthScale = 1.0f / logf(zFar / zNear);
+      else
+        cameraKeyJobData.depthScale = zFar > zNear ? 1.0f / (zFar - zNear) : 0.0f;
+
+      uint64* keysA = cameraQueue.keys;
+      uint64* keysB = cameraQueue.keys + cameraQueue.capacity;
+      const bool rebuildKeys = cameraQueue.count != numKeys || cameraQueue.nodeIndex != cameraNodeIndex;
+      if (rebuildKeys || viewChanged || meshMoved)
+      {
+        // Meshes on the camera frustum, straight from the spatial index
+        uint8* visibleNodes = frameAllocator.push<uint8>(numNodes);
+        memset(visibleNodes, 0, numNodes * sizeof(uint8));
+        VisibleNodeQuery visibleQuery = { &nodes, allNodes, visibleNodes };
+        spatialIndex->tree.query(Frustum::fromMatrix(camera.getViewProjectionMatrix()), markVisibleNode, &visibleQuery);
+        cameraKeyJobData.visibleNodes = visibleNodes;
+      }
+
+      if (rebuildKeys)
+      {
+        cameraKeyJobData.renderKeys = allRenderKeys;
+        cameraKeyJobData.cameraKeys = keysA;
+        JobSystem::get().parallelFor(numKeys, SMOL_SCENE_JOB_BATCH_SIZE, generateCameraRenderKeyRange, &cameraKeyJobData);
+        cameraQueue.sortedKeys = radixSortParallel(keysA, keysB, numKeys, CAMERA_RENDER_KEY_BITS);
+        cameraQueue.count = numKeys;
+        cameraQueue.nodeIndex = cameraNodeIndex;
+      }
+      else if (viewChanged || meshMoved)
+      {
+        // Depth changes little between frames so last frame order is close to the new one
+        uint64* lastKeys = cameraQueue.sortedKeys;
+        uint64* newKeys = lastKeys == keysA ? keysB : keysA;
+        cameraKeyJobData.renderKeys = lastKeys;
+        cameraKeyJobData.cameraKeys = newKeys;
+        JobSystem::get().parallelFor(numKeys, SMOL_SCENE_JOB_BATCH_SIZE, updateCameraRenderKeyRange, &cameraKeyJobData);
+        cameraQueue.sortedKeys = adaptiveSort(newKeys, lastKeys, numKeys, CAMERA_RENDER_KEY_BITS);
+      }
+      const uint64* sortedRenderKeys = cameraQueue.sortedKeys;
+
+      // Sprites and text inside the view rect, straight from the spatial hash.
+      // Sprites move freely without touching the keys, so this runs every frame.
+      uint8* visibleSprites = nullptr;
+      if (camera.getCameraType() == Camera::ORTHOGRAPHIC && spatialIndex->spriteHash.getProxyCount() > 0)
+      {
+        visibleSprites = frameAllocator.push<uint8>(numNodes);
+        memset(visibleSprites, 0, numNodes * sizeof(uint8));
+        VisibleNodeQuery visibleQuery = { &nodes, allNodes, visibleSprites };
+        spatialIndex->spriteHash.query(getOrthographicViewRect(camera), markVisibleNode, &visibleQuery);
+      }
 
       // ----------------------------------------------------------------------
       // VIEWPORT
@@ -346,27 +1315,29 @@ namespace smol
       // ----------------------------------------------------------------------
       // set uniform buffer matrices based on current camera
 
-      Renderer::updateGlobalShaderParams(
+      Renderer::updateCameraShaderParams(
           cameraNode->camera.getProjectionMatrix(),
-          cameraNode->transform.getMatrix().inverse(),
-          Mat4::initIdentity(),
+          cameraNode->camera.getViewMatrix(),
+          cameraNode->camera.getViewProjectionMatrix(),
           deltaTime);
+      Renderer::updateModelMatrix(Mat4::initIdentity());
 
       // ----------------------------------------------------------------------
       // Draw render keys
       int currentMaterialIndex = -1;
+      bool currentMaterialInstancing = false;
       uint32 cameraLayers = cameraNode->camera.getLayerMask();
 
       for(int i = 0; i < numKeys; i++)
       {
-        uint64 key = allRenderKeys[i];
-        SceneNode* node = (SceneNode*) &allNodes[getNodeIndexFromRenderKey(key)];
-        SceneNode::Type nodeType = (SceneNode::Type) getNodeTypeFromRenderKey(key);
-        int materialIndex = getMaterialIndexFromRenderKey(key);
-        SMOL_ASSERT(node->typeIs(nodeType), "Node Type does not match the render key node type");
+        uint64 key = sortedRenderKeys[i];
+
+        // Culled meshes sort after everything else
+        if (key & CAMERA_RENDER_KEY_CULLED)
+          break;
 
-        node->setDirty(false);
-        node->transform.setDirty(false); // reset transform dirty flag
+        SceneNode* node = (SceneNode*) &allNodes[getNodeIndexFromCameraRenderKey(key)];
+        int materialIndex = queue->rankToMaterial[getMaterialRankFromCameraRenderKey(key)];
 
         // Change material *if* necessary
         if (currentMaterialIndex != materialIndex)
@@ -374,6 +1345,7 @@ namespace smol
           currentMaterialIndex = materialIndex;
           Material& material = (resourceManager.getMaterials(nullptr))[materialIndex];
           Renderer::setMaterial(&material);
+          currentMaterialInstancing = Renderer::isInstancingSupported(&material);
         }
 
         if (node->typeIs(SceneNode::MESH)) 
@@ -381,25 +1353,38 @@ namespace smol
           if(!(cameraLayers & node->getLayer()))
             continue;
 
-          Renderer::updateGlobalShaderParams(
-              cameraNode->camera.getProjectionMatrix(),
-              cameraNode->transform.getMatrix().inverse(),
-              node->transform.getMatrix(),
-              deltaTime);
-
           Renderable* renderable = renderables.lookup(node->mesh.renderable);
+          const int32 runEnd = currentMaterialInstancing ? findInstanceRunEnd(allNodes, sortedRenderKeys, i, numKeys) : i + 1;
+          if (runEnd - i >= SMOL_SCENE_MIN_INSTANCES)
+          {
+            // Meshes sharing the renderable also share mesh and material. Draw them all at once.
+            ArenaMarker marker = frameAllocator.mark();
+            Mat4* modelMatrices = frameAllocator.push<Mat4>(runEnd - i);
+            uint32 instanceCount = 0;
+            for (int32 runIndex = i; runIndex < runEnd; runIndex++)
+            {
+              const SceneNode& instance = allNodes[getNodeIndexFromCameraRenderKey(sortedRenderKeys[runIndex])];
+              if (cameraLayers & instance.getLayer())
+                modelMatrices[instanceCount++] = instance.transform.getMatrix();
+            }
+
+            Renderer::drawMeshInstanced(*renderable->mesh.operator->(), modelMatrices, instanceCount);
+            frameAllocator.rewind(marker);
+            i = runEnd - 1;
+            continue;
+          }
+
+          Renderer::updateModelMatrix(node->transform.getMatrix());
           drawRenderable(renderable);
         }
         else if (node->typeIs(SceneNode::TEXT))
         {
           if(!(cameraLayers & node->getLayer()))
             continue;
+          if (visibleSprites && !visibleSprites[getNodeIndexFromCameraRenderKey(key)])
+            continue;
 
-          Renderer::updateGlobalShaderParams(
-              cameraNode->camera.getProjectionMatrix(),
-              cameraNode->transform.getMatrix().inverse(),
-              node->transform.getMatrix(),
-              deltaTime);
+          Renderer::updateModelMatrix(node->transform.getMatrix());
 
           SpriteBatcher* batcher = batchers.lookup(node->text.batcher);
           batcher->begin();
@@ -409,14 +1394,10 @@ namespace smol
         else if (node->typeIs(SceneNode::SPRITE))
         {
 
-          Renderer::updateGlobalShaderParams(
-              cameraNode->camera.getProjectionMatrix(),
-              cameraNode->transform.getMatrix().inverse(),
-              node->transform.getMatrix(),
-              deltaTime);
+          Renderer::updateModelMatrix(node->transform.getMatrix());
 
           SpriteBatcher* batcher = batchers.lookup(node->sprite.batcher);
-          drawSpriteNodes(this, batcher, allRenderKeys + i, cameraLayers);
+          drawSpriteNodes(this, batcher, sortedRenderKeys + i, cameraLayers, visibleSprites);
           i+= (batcher->spriteNodeCount - 1);
         }
         else
@@ -437,6 +1418,61 @@ namespace smol
     }
   }
 
+  bool Scene::updateRenderQueue(const uint8* nodeState)
+  {
+    SceneRenderQueue* queue = renderQueue;
+    const int32 numNodes = nodes.count();
+
+    // Nodes that were not destroyed keep their index so new ones can just be appended
+    if (numNodes < queue->nodeCount)
+      queue->dirty = true;
+
+    const bool queueChanged = queue->dirty || numNodes > queue->nodeCount;
+    if (queue->dirty)
+    {
+      queue->count = 0;
+      queue->cameraCount = 0;
+      queue->nodeCount = 0;
+      queue->dirty = false;
+    }
+
+    if (queueChanged)
+    {
+      appendRenderKeys(queue, nodes.getArray(), nodeState, &renderables, queue->nodeCount, numNodes);
+      for (int32 i = 0; i < queue->cameraCapacity; i++)
+        queue->cameras[i].count = -1;
+    }
+
+    return queueChanged;
+  }
+
+  const uint64* Scene::getRenderKeys(int32* count) const
+  {
+    *count = renderQueue->count;
+    return renderQueue->keys;
+  }
+
+  const uint64* Scene::getCameraRenderKeys(int32* count) const
+  {
+    *count = renderQueue->cameraCount;
+    return renderQueue->cameraKeys;
+  }
+
+  void Scene::invalidateRenderQueue()
+  {
+    renderQueue->dirty = true;
+    spatialIndex->dirty = true;
+  }
+
+  bool Scene::onEvent(const Event& event)
+  {
+    if (event.type == Event::DISPLAY && event.displayEvent.type == DisplayEvent::RESIZED)
+      Camera::displayResized();
+
+    // Other handlers might also need to know about it
+    return false;
+  }
+
 }
 
 #undef INVALID_HANDLE
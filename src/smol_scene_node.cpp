@@ -23,6 +23,7 @@ namespace smol
 
     active = status;
     dirty = true;
+    scene.invalidateRenderQueue();
   }
 
   void SceneNode::setDirty(bool value) { dirty = value; }
@@ -66,6 +67,7 @@ namespace smol
       return;
     }
     transform.setParent(parent);
+    scene.invalidateRenderQueue();
   }
 
   void SceneNode::setLayer(smol::Layer l) { layer = l; }
@@ -0,0 +1,388 @@
+#include <smol/smol_spatial_hash.h>
+#include <smol/smol_platform.h>
+#include <smol/smol_log.h>
+#include <math.h>
+
+// Build option: size of the grid cells, in world units. Cells should be a
+// little larger than the typical object so most objects touch few cells.
+#ifndef SMOL_SPATIAL_HASH_CELL_SIZE
+#define SMOL_SPATIAL_HASH_CELL_SIZE 4.0f
+#endif
+
+// Build option: proxies covering more cells than this go to the large list.
+#ifndef SMOL_SPATIAL_HASH_MAX_PROXY_CELLS
+#define SMOL_SPATIAL_HASH_MAX_PROXY_CELLS 16
+#endif
+
+namespace smol
+{
+  const int32 SPATIAL_HASH_NULL = -1;
+  const int32 SPATIAL_HASH_MIN_BUCKETS = 256;
+  const float SPATIAL_HASH_MAX_CELL = 1073741824.0f;    // 2^30, keeps cell math away from overflows
+
+  struct SpatialHashProxy
+  {
+    Rectf rect;
+    uint64 userData;
+    int32 minX, minY, maxX, maxY; // cells the rect touches
+    int32 firstEntry;             // first cell entry of the proxy
+    int32 largeIndex;             // position on the large list or SPATIAL_HASH_NULL
+    int32 next;                   // next free proxy when on the free list
+    bool used;
+  };
+
+  struct SpatialHashEntry
+  {
+    int32 cellX;
+    int32 cellY;
+    int32 proxy;                  // SPATIAL_HASH_NULL for free entries
+    int32 prev;                   // bucket chain
+    int32 next;                   // bucket chain or next free entry
+    int32 nextOfProxy;            // next cell entry of the same proxy
+  };
+
+  static inline int32 toCell(float value, float inverseCellSize)
+  {
+    float cell = floorf(value * inverseCellSize);
+    if (!(cell > -SPATIAL_HASH_MAX_CELL))         // also catches NaN
+      cell = -SPATIAL_HASH_MAX_CELL;
+    else if (cell > SPATIAL_HASH_MAX_CELL)
+      cell = SPATIAL_HASH_MAX_CELL;
+    return (int32) cell;
+  }
+
+  static inline uint32 hashCell(int32 x, int32 y, int32 bucketCount)
+  {
+    return (((uint32) x * 73856093u) ^ ((uint32) y * 19349663u)) & (uint32) (bucketCount - 1);
+  }
+
+  static inline bool overlaps(const Rectf& a, const Rectf& b)
+  {
+    return a.x <= b.x + b.w && b.x <= a.x + a.w
+      && a.y <= b.y + b.h && b.y <= a.y + a.h;
+  }
+
+  static inline int64 cellCount(int32 minX, int32 minY, int32 maxX, int32 maxY)
+  {
+    return ((int64) maxX - minX + 1) * ((int64) maxY - minY + 1);
+  }
+
+  SpatialHash::SpatialHash(): SpatialHash(SMOL_SPATIAL_HASH_CELL_SIZE) { }
+
+  SpatialHash::SpatialHash(float cellSize):
+    proxies(nullptr), entries(nullptr), buckets(nullptr), largeProxies(nullptr),
+    proxyCapacity(0), entryCapacity(0), bucketCount(0), largeCapacity(0), largeCount(0),
+    freeProxy(SPATIAL_HASH_NULL), freeEntry(SPATIAL_HASH_NULL), proxyCount(0), entryCount(0),
+    cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+  {
+    SMOL_ASSERT(cellSize > 0.0f, "SpatialHash cell size must be positive but %f was passed", cellSize);
+  }
+
+  SpatialHash::~SpatialHash()
+  {
+    Platform::freeMemory(proxies);
+    Platform::freeMemory(entries);
+    Platform::freeMemory(buckets);
+    Platform::freeMemory(largeProxies);
+  }
+
+  int32 SpatialHash::allocateEntry()
+  {
+    if (freeEntry == SPATIAL_HASH_NULL)
+    {
+      const int32 oldCapacity = entryCapacity;
+      entryCapacity = entryCapacity > 0 ? entryCapacity * 2 : 64;
+      entries = (SpatialHashEntry*) Platform::resizeMemory(entries, entryCapacity * sizeof(SpatialHashEntry));
+
+      for (int32 i = oldCapacity; i < entryCapacity; i++)
+      {
+        entries[i].next = i + 1;
+        entries[i].proxy = SPATIAL_HASH_NULL;
+      }
+      entries[entryCapacity - 1].next = SPATIAL_HASH_NULL;
+      freeEntry = oldCapacity;
+    }
+
+    const int32 entry = freeEntry;
+    freeEntry = entries[entry].next;
+    entryCount++;
+    return entry;
+  }
+
+  void SpatialHash::rehash(int32 newBucketCount)
+  {
+    bucketCount = newBucketCount;
+    buckets = (int32*) Platform::resizeMemory(buckets, bucketCount * sizeof(int32));
+    for (int32 i = 0; i < bucketCount; i++)
+      buckets[i] = SPATIAL_HASH_NULL;
+
+    for (int32 i = 0; i < entryCapacity; i++)
+    {
+      SpatialHashEntry& entry = entries[i];
+      if (entry.proxy == SPATIAL_HASH_NULL)
+        continue;
+
+      const uint32 bucket = hashCell(entry.cellX, entry.cellY, bucketCount);
+      entry.prev = SPATIAL_HASH_NULL;
+      entry.next = buckets[bucket];
+      if (entry.next != SPATIAL_HASH_NULL)
+        entries[entry.next].prev = i;
+      buckets[bucket] = i;
+    }
+  }
+
+  void SpatialHash::link(int32 proxy)
+  {
+    SpatialHashProxy& p = proxies[proxy];
+    p.firstEntry = SPATIAL_HASH_NULL;
+    p.largeIndex = SPATIAL_HASH_NULL;
+
+    const int64 numCells = cellCount(p.minX, p.minY, p.maxX, p.maxY);
+    if (numCells > SMOL_SPATIAL_HASH_MAX_PROXY_CELLS)
+    {
+      if (largeCount == largeCapacity)
+      {
+        largeCapacity = largeCapacity > 0 ? largeCapacity * 2 : 16;
+        largeProxies = (int32*) Platform::resizeMemory(largeProxies, largeCapacity * sizeof(int32));
+      }
+      p.largeIndex = largeCount;
+      largeProxies[largeCount++] = proxy;
+      return;
+    }
+
+    // Keep about one entry per bucket
+    if (entryCount + numCells > bucketCount)
+    {
+      int32 newBucketCount = bucketCount > 0 ? bucketCount : SPATIAL_HASH_MIN_BUCKETS;
+      while (entryCount + numCells > newBucketCount)
+        newBucketCount *= 2;
+      rehash(newBucketCount);
+    }
+
+    for (int32 y = p.minY; y <= p.maxY; y++)
+    {
+      for (int32 x = p.minX; x <= p.maxX; x++)
+      {
+        const int32 e = allocateEntry();
+        const uint32 bucket = hashCell(x, y, bucketCount);
+        SpatialHashEntry& entry = entries[e];
+        entry.cellX = x;
+        entry.cellY = y;
+        entry.proxy = proxy;
+        entry.prev = SPATIAL_HASH_NULL;
+        entry.next = buckets[bucket];
+        if (entry.next != SPATIAL_HASH_NULL)
+          entries[entry.next].prev = e;
+        buckets[bucket] = e;
+        entry.nextOfProxy = proxies[proxy].firstEntry;
+        proxies[proxy].firstEntry = e;
+      }
+    }
+  }
+
+  void SpatialHash::unlink(int32 proxy)
+  {
+    SpatialHashProxy& p = proxies[proxy];
+    if (p.largeIndex != SPATIAL_HASH_NULL)
+    {
+      const int32 last = largeProxies[--largeCount];
+      largeProxies[p.largeIndex] = last;
+      proxies[last].largeIndex = p.largeIndex;
+      p.largeIndex = SPATIAL_HASH_NULL;
+      return;
+    }
+
+    int32 e = p.firstEntry;
+    while (e != SPATIAL_HASH_NULL)
+    {
+      SpatialHashEntry& entry = entries[e];
+      const int32 nextOfProxy = entry.nextOfProxy;
+
+      if (entry.prev != SPATIAL_HASH_NULL)
+        entries[entry.prev].next = entry.next;
+      else
+        buckets[hashCell(entry.cellX, entry.cellY, bucketCount)] = entry.next;
+      if (entry.next != SPATIAL_HASH_NULL)
+        entries[entry.next].prev = entry.prev;
+
+      entry.proxy = SPATIAL_HASH_NULL;
+      entry.next = freeEntry;
+      freeEntry = e;
+      entryCount--;
+      e = nextOfProxy;
+    }
+    p.firstEntry = SPATIAL_HASH_NULL;
+  }
+
+  int32 SpatialHash::insert(const Rectf& rect, uint64 userData)
+  {
+    if (freeProxy == SPATIAL_HASH_NULL)
+    {
+      const int32 oldCapacity = proxyCapacity;
+      proxyCapacity = proxyCapacity > 0 ? proxyCapacity * 2 : 64;
+      proxies = (SpatialHashProxy*) Platform::resizeMemory(proxies, proxyCapacity * sizeof(SpatialHashProxy));
+
+      for (int32 i = oldCapacity; i < proxyCapacity; i++)
+      {
+        proxies[i].next = i + 1;
+        proxies[i].used = false;
+      }
+      proxies[proxyCapacity - 1].next = SPATIAL_HASH_NULL;
+      freeProxy = oldCapacity;
+    }
+
+    const int32 proxy = freeProxy;
+    SpatialHashProxy& p = proxies[proxy];
+    freeProxy = p.next;
+    p.rect = rect;
+    p.userData = userData;
+    p.minX = toCell(rect.x, inverseCellSize);
+    p.minY = toCell(rect.y, inverseCellSize);
+    p.maxX = toCell(rect.x + rect.w, inverseCellSize);
+    p.maxY = toCell(rect.y + rect.h, inverseCellSize);
+    p.used = true;
+    link(proxy);
+    proxyCount++;
+    return proxy;
+  }
+
+  void SpatialHash::remove(int32 proxy)
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < proxyCapacity && proxies[proxy].used, "Invalid SpatialHash proxy %d", proxy);
+    unlink(proxy);
+    proxies[proxy].used = false;
+    proxies[proxy].next = freeProxy;
+    freeProxy = proxy;
+    proxyCount--;
+  }
+
+  bool SpatialHash::update(int32 proxy, const Rectf& rect)
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < proxyCapacity && proxies[proxy].used, "Invalid SpatialHash proxy %d", proxy);
+
+    SpatialHashProxy& p = proxies[proxy];
+    const int32 minX = toCell(rect.x, inverseCellSize);
+    const int32 minY = toCell(rect.y, inverseCellSize);
+    const int32 maxX = toCell(rect.x + rect.w, inverseCellSize);
+    const int32 maxY = toCell(rect.y + rect.h, inverseCellSize);
+    p.rect = rect;
+
+    // Still on the same cells
+    if (minX == p.minX && minY == p.minY && maxX == p.maxX && maxY == p.maxY)
+      return false;
+
+    // Large proxies are not linked to cells
+    const bool isLarge = cellCount(minX, minY, maxX, maxY) > SMOL_SPATIAL_HASH_MAX_PROXY_CELLS;
+    if (isLarge && p.largeIndex != SPATIAL_HASH_NULL)
+    {
+      p.minX = minX; p.minY = minY; p.maxX = maxX; p.maxY = maxY;
+      return false;
+    }
+
+    unlink(proxy);
+    p.minX = minX; p.minY = minY; p.maxX = maxX; p.maxY = maxY;
+    link(proxy);
+    return true;
+  }
+
+  uint64 SpatialHash::getUserData(int32 proxy) const
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < proxyCapacity && proxies[proxy].used, "Invalid SpatialHash proxy %d", proxy);
+    return proxies[proxy].userData;
+  }
+
+  const Rectf& SpatialHash::getRect(int32 proxy) const
+  {
+    SMOL_ASSERT(proxy >= 0 && proxy < proxyCapacity && proxies[proxy].used, "Invalid SpatialHash proxy %d", proxy);
+    return proxies[proxy].rect;
+  }
+
+  int32 SpatialHash::getProxyCount() const
+  {
+    return proxyCount;
+  }
+
+  float SpatialHash::getCellSize() const
+  {
+    return cellSize;
+  }
+
+  void SpatialHash::reset()
+  {
+    for (int32 i = 0; i < proxyCapacity; i++)
+    {
+      proxies[i].next = i + 1 < proxyCapacity ? i + 1 : SPATIAL_HASH_NULL;
+      proxies[i].used = false;
+    }
+    for (int32 i = 0; i < entryCapacity; i++)
+    {
+      entries[i].next = i + 1 < entryCapacity ? i + 1 : SPATIAL_HASH_NULL;
+      entries[i].proxy = SPATIAL_HASH_NULL;
+    }
+    for (int32 i = 0; i < bucketCount; i++)
+      buckets[i] = SPATIAL_HASH_NULL;
+
+    freeProxy = proxyCapacity > 0 ? 0 : SPATIAL_HASH_NULL;
+    freeEntry = entryCapacity > 0 ? 0 : SPATIAL_HASH_NULL;
+    proxyCount = 0;
+    entryCount = 0;
+    largeCount = 0;
+  }
+
+  void SpatialHash::query(const Rectf& rect, SpatialHashQueryCallback callback, void* context) const
+  {
+    if (proxyCount == 0)
+      return;
+
+    const int32 minX = toCell(rect.x, inverseCellSize);
+    const int32 minY = toCell(rect.y, inverseCellSize);
+    const int32 maxX = toCell(rect.x + rect.w, inverseCellSize);
+    const int32 maxY = toCell(rect.y + rect.h, inverseCellSize);
+
+    // Walking the cells of a huge rect costs more than testing every proxy
+    if (cellCount(minX, minY, maxX, maxY) >= proxyCapacity)
+    {
+      for (int32 i = 0; i < proxyCapacity; i++)
+      {
+        const SpatialHashProxy& p = proxies[i];
+        if (p.used && overlaps(p.rect, rect) && !callback(p.userData, context))
+          return;
+      }
+      return;
+    }
+
+    if (bucketCount > 0)
+    {
+      for (int32 y = minY; y <= maxY; y++)
+      {
+        for (int32 x = minX; x <= maxX; x++)
+        {
+          int32 e = buckets[hashCell(x, y, bucketCount)];
+          while (e != SPATIAL_HASH_NULL)
+          {
+            const SpatialHashEntry& entry = entries[e];
+            e = entry.next;
+            if (entry.cellX != x || entry.cellY != y)
+              continue;
+
+            // A proxy on many cells is only reported from the first cell it
+            // shares with the query.
+            const SpatialHashProxy& p = proxies[entry.proxy];
+            if (x != (p.minX > minX ? p.minX : minX) || y != (p.minY > minY ? p.minY : minY))
+              continue;
+
+            if (overlaps(p.rect, rect) && !callback(p.userData, context))
+              return;
+          }
+        }
+      }
+    }
+
+    for (int32 i = 0; i < largeCount; i++)
+    {
+      const SpatialHashProxy& p = proxies[largeProxies[i]];
+      if (overlaps(p.rect, rect) && !callback(p.userData, context))
+        return;
+    }
+  }
+}
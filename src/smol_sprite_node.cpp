@@ -19,6 +19,7 @@ namespace smol
     Scene& scene = SceneManager::get().getCurrentScene();
     Handle<SceneNode> handle = scene.createNode(SceneNode::Type::SPRITE, transform);
 
+    handle->sprite.node = handle;
     handle->sprite.rect = rect;
     handle->sprite.batcher = batcher;
     handle->sprite.width = width;
@@ -38,4 +39,14 @@ namespace smol
     SceneManager::get().getCurrentScene().destroyNode(handle);
     handle->sprite.batcher->spriteNodeCount--;
   }
+
+  void SpriteNode::setSize(float width, float height)
+  {
+    this->width = width;
+    this->height = height;
+
+    SceneNode* sceneNode = node.operator->();
+    if (sceneNode)
+      sceneNode->transform.setDirty(true);
+  }
 }
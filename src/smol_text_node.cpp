@@ -5,6 +5,7 @@
 #include <smol/smol_scene_manager.h>
 #include <smol/smol_scene.h>
 #include <smol/smol_font.h>
+#include <smol/smol_pool_allocator.h>
 #include <string.h>
 
 namespace smol
@@ -26,7 +27,9 @@ namespace smol
     textNode.color = color;
     textNode.bgColor = Color(0.0f, 0.0f, 0.0f, 0.0f);
     textNode.drawBackground = false;
-    textNode.arena.initialize(0); // let setText() decide how much to allocate
+    textNode.text = nullptr;
+    textNode.drawData = nullptr;
+    textNode.memorySize = 0; // let setText() decide how much to allocate
     textNode.batcher->textNodeCount++;
     textNode.batcher->dirty = true;
     textNode.lineHeightScale = 1.0f;
@@ -37,19 +40,21 @@ namespace smol
   void TextNode::setText(const char* text)
   {
     textLen = strlen(text) + 1;
-    size_t memSize = textLen + 1 + textLen * sizeof(GlyphDrawData);
-    if (arena.getCapacity() == 0)
+    // Memory layout
+    // -----------------------------
+    //| GlyphDrawData x textLen | text |
+    // -----------------------------
+    size_t memSize = textLen * sizeof(GlyphDrawData) + textLen + 1;
+
+    // Only go back to the pool when the current block is too small
+    if (memSize > PoolAllocator::getBlockSize(memorySize) || !drawData)
     {
-      arena.initialize(memSize);
-    }
-    else
-    {
-      arena.reset();
+      freeText();
+      memorySize = memSize;
+      this->drawData = (GlyphDrawData*) PoolAllocator::get().getMemory(memorySize);
     }
 
-    char* memory =  (char*) arena.pushSize(memSize);
-    this->drawData = (GlyphDrawData*) memory;
-    this->text = memory + (sizeof(GlyphDrawData) * textLen);
+    this->text = (char*) (this->drawData + textLen);
 
     // Copy the source text
     strncpy(this->text, text, textLen + 1);
@@ -65,6 +70,11 @@ namespace smol
       background->size = this->textBounds;
     else
       background->size = Vector2(0.0f);
+
+    // New text has new bounds. Let the scene index the node again.
+    SceneNode* sceneNode = node.operator->();
+    if (sceneNode)
+      sceneNode->transform.setDirty(true);
   }
 
   const char* TextNode::getText() const
@@ -72,6 +82,14 @@ namespace smol
     return text;
   }
 
+  void TextNode::freeText()
+  {
+    PoolAllocator::get().freeMemory(drawData, memorySize);
+    drawData = nullptr;
+    text = nullptr;
+    memorySize = 0;
+  }
+
   void TextNode::setBackgroundColor(Color color) 
   {
     this->bgColor = color; 
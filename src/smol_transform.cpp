@@ -6,11 +6,13 @@ namespace smol
 {
 
   Transform::Transform(Handle<SceneNode> parent)
-    : position(Vector3(0.0f)), rotation(Vector3(0.0f)), scale(Vector3(1.0f)), dirty(true), parent(parent)
+    : position(Vector3(0.0f)), rotation(Quaternion::identity()), scale(Vector3(1.0f)),
+    eulerRotation(Vector3(0.0f)), eulerDirty(false), dirty(true), parent(parent)
   {}
 
   Transform::Transform(Vector3 position, Vector3 rotation, Vector3 scale, Handle<SceneNode> parent)
-    : position(position), rotation(rotation), scale(scale), dirty(true), parent(parent)
+    : position(position), rotation(Quaternion::fromEuler(rotation)), scale(scale),
+    eulerRotation(rotation), eulerDirty(false), dirty(true), parent(parent)
   {
   }
 
@@ -50,16 +52,25 @@ namespace smol
 
   Transform& Transform::setRotation(float x, float y, float z) 
   {
-    rotation.x = x;
-    rotation.y = y;
-    rotation.z = z;
+    eulerRotation.x = x;
+    eulerRotation.y = y;
+    eulerRotation.z = z;
+    eulerDirty = false;
+    rotation = Quaternion::fromEuler(x, y, z);
     dirty = true;
     return *this;
   };
 
   Transform& Transform::setRotation(const Vector3& rotation) 
+  {
+    return setRotation(rotation.x, rotation.y, rotation.z);
+  }
+
+  Transform& Transform::setRotation(const Quaternion& rotation) 
   {
     this->rotation = rotation;
+    this->rotation.normalize();
+    eulerDirty = true;
     dirty = true;
     return *this;
   }
@@ -82,7 +93,17 @@ namespace smol
 
   inline const Vector3& Transform::getScale() const { return scale; }
 
-  inline const Vector3& Transform::getRotation() const { return rotation; }
+  const Vector3& Transform::getRotation() const
+  {
+    if (eulerDirty)
+    {
+      eulerRotation = rotation.toEuler();
+      eulerDirty = false;
+    }
+    return eulerRotation;
+  }
+
+  inline const Quaternion& Transform::getRotationQuaternion() const { return rotation; }
 
   inline Handle<SceneNode> Transform::getParent() const { return parent; }
 
@@ -96,11 +117,18 @@ namespace smol
   }
 
 
+  bool Transform::isLocalDirty() const { return dirty; }
+
   void Transform::setDirty(bool value)
   {
     dirty = value;
   }
 
+  void Transform::updateMatrix(const Mat4& parentMatrix)
+  {
+    model = Mat4::mul(parentMatrix, Mat4::fromTRS(position, rotation, scale));
+  }
+
   bool Transform::update(const Scene& scene)
   {
     SceneNode& parentNode = *(parent.operator->());
@@ -119,13 +147,7 @@ namespace smol
         parentMatrix = Mat4::initIdentity();
       }
 
-      Mat4 scaleMatrix = Mat4::initScale(scale.x, scale.y, scale.z);
-      Mat4 rotationMatrix = Mat4::initRotation(rotation.x, rotation.y, rotation.z);
-      Mat4 translationMatrix = Mat4::initTranslation(position.x, position.y, position.z);
-
-      Mat4 transformed = Mat4::mul(rotationMatrix, scaleMatrix);
-      transformed = Mat4::mul(translationMatrix, transformed);
-      model = Mat4::mul(parentMatrix, transformed);
+      updateMatrix(parentMatrix);
       return true; // changed this frame
     }
 
@@ -26,6 +26,8 @@
 #define SMOL_VARIABLES_FILE ((const char*) "smol_settings.txt")
 #include <smol/smol_event_manager.h>
 #include <smol/smol_event.h>
+#include <smol/smol_frame_allocator.h>
+#include <smol/smol_job_system.h>
 
 namespace smol
 {
@@ -116,6 +118,7 @@ namespace smol
       Platform::getWindowSize(window, &displayConfig.width, &displayConfig.height);
 
       // Initialize systems
+      JobSystem::get().initialize(systemConfig.workerThreads);
       ResourceManager::get().initialize();
       Renderer::initialize(ConfigManager::get().rendererConfig());
       ResourceManager& resourceManager = ResourceManager::get();
@@ -142,6 +145,8 @@ namespace smol
         float deltaTime = Platform::getMillisecondsBetweenTicks(startTime, endTime);
 
         startTime = Platform::getTicks();
+        FrameAllocator::get().beginFrame();
+        Platform::beginMemoryFrame();
         Platform::updateWindowEvents(window);
         InputManager::get().update();
         EventManager::get().dispatchEvents();
@@ -177,6 +182,7 @@ namespace smol
       }
 
       onStop();
+      JobSystem::get().shutdown();
       Platform::destroyWindow(window);
       return 0;
     }
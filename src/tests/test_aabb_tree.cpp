@@ -0,0 +1,279 @@
+#include "smol_test.h"
+#include <smol/smol_aabb_tree.h>
+#include <smol/smol_mat4.h>
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+using smol::AABB;
+using smol::AABBTree;
+using smol::Frustum;
+using smol::Mat4;
+using smol::Ray;
+using smol::Vector3;
+
+static uint64 nextRandom(uint64& state)
+{
+  // xorshift64
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+static float randomFloat(uint64& state, float min, float max)
+{
+  return min + (max - min) * (float) (nextRandom(state) % 100000) / 100000.0f;
+}
+
+static AABB randomBox(uint64& state, float worldSize)
+{
+  const Vector3 center(randomFloat(state, -worldSize, worldSize), randomFloat(state, -worldSize, worldSize),
+      randomFloat(state, -worldSize, worldSize));
+  const float size = randomFloat(state, 0.1f, 2.0f);
+  return AABB(Vector3(center.x - size, center.y - size, center.z - size), Vector3(center.x + size, center.y + size, center.z + size));
+}
+
+// Objects of the tests. Index is the proxy user data.
+struct TestObjects
+{
+  std::vector<AABB> boxes;
+  std::vector<int32> proxies;     // -1 when not on the tree
+};
+
+static bool collect(uint64 userData, void* context)
+{
+  ((std::vector<uint64>*) context)->push_back(userData);
+  return true;
+}
+
+static std::vector<uint64> sorted(std::vector<uint64> values)
+{
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+// Populates the tree, moves some objects and removes others
+static void buildTestTree(AABBTree& tree, TestObjects& objects, int count, uint64 seed)
+{
+  objects.boxes.resize(count);
+  objects.proxies.resize(count);
+  for (int i = 0; i < count; i++)
+  {
+    objects.boxes[i] = randomBox(seed, 100.0f);
+    objects.proxies[i] = tree.insert(objects.boxes[i], (uint64) i);
+  }
+
+  for (int i = 0; i < count; i += 3)
+  {
+    // Small moves stay inside the fat box, large ones don't
+    const float offset = (i % 2) ? 0.05f : randomFloat(seed, -20.0f, 20.0f);
+    AABB& box = objects.boxes[i];
+    box = AABB(Vector3(box.min.x + offset, box.min.y, box.min.z - offset), Vector3(box.max.x + offset, box.max.y, box.max.z - offset));
+    tree.update(objects.proxies[i], box);
+  }
+
+  for (int i = 0; i < count; i += 7)
+  {
+    tree.remove(objects.proxies[i]);
+    objects.proxies[i] = -1;
+  }
+}
+
+SMOL_TEST(insert_update_remove)
+{
+  AABBTree tree;
+  SMOL_TEST_EXPECT_EQ(tree.getHeight(), 0);
+
+  AABB box(Vector3(0.0f), Vector3(1.0f));
+  int32 proxy = tree.insert(box, 42);
+  SMOL_TEST_EXPECT_EQ(tree.getProxyCount(), 1);
+  SMOL_TEST_EXPECT_EQ(tree.getUserData(proxy), (uint64) 42);
+  SMOL_TEST_EXPECT_TRUE(tree.getFatBox(proxy).contains(box));
+
+  // Moving inside the fat box doesn't touch the tree
+  SMOL_TEST_EXPECT_FALSE(tree.update(proxy, AABB(Vector3(0.05f), Vector3(1.05f))));
+  SMOL_TEST_EXPECT_TRUE(tree.update(proxy, AABB(Vector3(10.0f), Vector3(11.0f))));
+  SMOL_TEST_EXPECT_TRUE(tree.getFatBox(proxy).contains(AABB(Vector3(10.0f), Vector3(11.0f))));
+
+  // A box that shrank a lot gets a tighter fat box
+  SMOL_TEST_EXPECT_TRUE(tree.update(proxy, AABB(Vector3(10.4f), Vector3(10.6f))));
+
+  tree.remove(proxy);
+  SMOL_TEST_EXPECT_EQ(tree.getProxyCount(), 0);
+  SMOL_TEST_EXPECT_EQ(tree.getHeight(), 0);
+
+  // Freed nodes are reused
+  SMOL_TEST_EXPECT_EQ(tree.insert(box, 7), proxy);
+  tree.reset();
+  SMOL_TEST_EXPECT_EQ(tree.getProxyCount(), 0);
+}
+
+SMOL_TEST(tree_stays_balanced)
+{
+  AABBTree tree;
+  const int count = 20000;
+
+  // Sorted insertion is the worst case for trees without rotations
+  for (int i = 0; i < count; i++)
+    tree.insert(AABB(Vector3((float) i * 3.0f, 0.0f, 0.0f), Vector3((float) i * 3.0f + 1.0f, 1.0f, 1.0f)), (uint64) i);
+
+  const float log2Count = logf((float) count) / logf(2.0f);
+  SMOL_TEST_EXPECT_TRUE(tree.getHeight() <= (int32) (2.0f * log2Count));
+  SMOL_TEST_EXPECT_EQ(tree.getProxyCount(), count);
+}
+
+SMOL_TEST(query_box)
+{
+  AABBTree tree;
+  TestObjects objects;
+  buildTestTree(tree, objects, 5000, 1);
+
+  uint64 seed = 2;
+  for (int q = 0; q < 50; q++)
+  {
+    const AABB queryBox = randomBox(seed, 100.0f);
+    const AABB largeBox(Vector3(queryBox.min.x - 10.0f, queryBox.min.y - 10.0f, queryBox.min.z - 10.0f), queryBox.max);
+
+    std::vector<uint64> found;
+    tree.query(largeBox, collect, &found);
+
+    // Fat boxes might report a few more objects but never miss one
+    for (int i = 0; i < (int) objects.boxes.size(); i++)
+    {
+      const bool onTree = objects.proxies[i] >= 0;
+      const bool reported = std::find(found.begin(), found.end(), (uint64) i) != found.end();
+      if (onTree && objects.boxes[i].overlaps(largeBox))
+      {
+        SMOL_TEST_EXPECT_TRUE(reported);
+      }
+
+      if (!onTree)
+      {
+        SMOL_TEST_EXPECT_FALSE(reported);
+      }
+    }
+  }
+}
+
+SMOL_TEST(query_frustum)
+{
+  AABBTree tree;
+  TestObjects objects;
+  buildTestTree(tree, objects, 5000, 3);
+
+  const Mat4 view = Mat4::initTranslation(0.0f, 0.0f, -50.0f);
+  const Frustum frustum = Frustum::fromMatrix(Mat4::mul(Mat4::perspective(60.0f, 1.0f, 1.0f, 80.0f), view));
+
+  std::vector<uint64> found;
+  tree.query(frustum, collect, &found);
+  found = sorted(found);
+
+  // Same result as testing the fat box of every object
+  std::vector<uint64> expected;
+  for (int i = 0; i < (int) objects.boxes.size(); i++)
+  {
+    if (objects.proxies[i] >= 0 && frustum.intersects(tree.getFatBox(objects.proxies[i])))
+      expected.push_back((uint64) i);
+  }
+
+  SMOL_TEST_EXPECT_TRUE(expected.size() > 0);
+  SMOL_TEST_EXPECT_TRUE(found == expected);
+}
+
+struct ClosestHit
+{
+  const TestObjects* objects;
+  float distance;
+  uint64 userData;
+};
+
+static float closestHitCallback(uint64 userData, const Ray& ray, float maxDistance, void* context)
+{
+  ClosestHit* hit = (ClosestHit*) context;
+  float distance;
+  if (!hit->objects->boxes[userData].intersects(ray, maxDistance, &distance))
+    return maxDistance;
+
+  hit->distance = distance;
+  hit->userData = userData;
+  return distance;
+}
+
+SMOL_TEST(raycast_closest)
+{
+  AABBTree tree;
+  TestObjects objects;
+  buildTestTree(tree, objects, 5000, 5);
+
+  uint64 seed = 6;
+  int hits = 0;
+  for (int q = 0; q < 200; q++)
+  {
+    Vector3 direction(randomFloat(seed, -1.0f, 1.0f), randomFloat(seed, -1.0f, 1.0f), randomFloat(seed, -1.0f, 1.0f));
+    direction.normalized();
+    const Ray ray(Vector3(randomFloat(seed, -100.0f, 100.0f), randomFloat(seed, -100.0f, 100.0f), 150.0f), direction);
+
+    ClosestHit hit = { &objects, 0.0f, ~0ULL };
+    tree.raycast(ray, 1000.0f, closestHitCallback, &hit);
+
+    // Brute force
+    float expectedDistance = 1000.0f;
+    uint64 expected = ~0ULL;
+    for (int i = 0; i < (int) objects.boxes.size(); i++)
+    {
+      float distance;
+      if (objects.proxies[i] >= 0 && objects.boxes[i].intersects(ray, expectedDistance, &distance) && distance < expectedDistance)
+      {
+        expectedDistance = distance;
+        expected = (uint64) i;
+      }
+    }
+
+    SMOL_TEST_EXPECT_EQ(hit.userData, expected);
+    if (expected != ~0ULL)
+      hits++;
+  }
+
+  SMOL_TEST_EXPECT_TRUE(hits > 0);
+}
+
+SMOL_TEST(query_nearest)
+{
+  AABBTree tree;
+  TestObjects objects;
+  buildTestTree(tree, objects, 5000, 7);
+
+  const int32 k = 8;
+  uint64 results[k];
+  float distances[k];
+  uint64 seed = 8;
+  for (int q = 0; q < 50; q++)
+  {
+    const Vector3 point(randomFloat(seed, -100.0f, 100.0f), randomFloat(seed, -100.0f, 100.0f), randomFloat(seed, -100.0f, 100.0f));
+    SMOL_TEST_EXPECT_EQ(tree.queryNearest(point, k, results, distances), k);
+
+    // Same distances as sorting the fat boxes of every object by distance
+    std::vector<float> expected;
+    for (int i = 0; i < (int) objects.boxes.size(); i++)
+    {
+      if (objects.proxies[i] >= 0)
+        expected.push_back(tree.getFatBox(objects.proxies[i]).distanceSquared(point));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    for (int32 i = 0; i < k; i++)
+    {
+      SMOL_TEST_EXPECT_EQ(distances[i], expected[i]);
+      SMOL_TEST_EXPECT_EQ(tree.getFatBox(objects.proxies[results[i]]).distanceSquared(point), distances[i]);
+    }
+  }
+
+  // Asking for more than there is
+  AABBTree small;
+  small.insert(AABB(Vector3(0.0f), Vector3(1.0f)), 1);
+  small.insert(AABB(Vector3(5.0f), Vector3(6.0f)), 2);
+  SMOL_TEST_EXPECT_EQ(small.queryNearest(Vector3(7.0f), k, results, distances), 2);
+  SMOL_TEST_EXPECT_EQ(results[0], (uint64) 2);
+  SMOL_TEST_EXPECT_EQ(results[1], (uint64) 1);
+}
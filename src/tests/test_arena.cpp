@@ -1,5 +1,6 @@
 #include "smol_test.h"
 #include <smol/smol_arena.h>
+#include <smol/smol_frame_allocator.h>
 
 SMOL_TEST(initialization)
 {
@@ -30,6 +31,8 @@ SMOL_TEST(used_amount)
   SMOL_TEST_EXPECT_EQ(arena.getUsed(), KILOBYTE(512));
   arena.pushSize(KILOBYTE(512));
   SMOL_TEST_EXPECT_EQ(arena.getUsed(), KILOBYTE(1024));
+  // Filling the arena exactly does not grow it
+  SMOL_TEST_EXPECT_EQ(arena.getCapacity(), capacity);
 }
 
 SMOL_TEST(used_amount_reset)
@@ -58,3 +61,131 @@ SMOL_TEST(expand)
   SMOL_TEST_EXPECT_EQ(arena.getUsed(), tooLargePushSize);
   SMOL_TEST_EXPECT_GE(arena.getCapacity(), tooLargePushSize);
 }
+
+SMOL_TEST(virtual_initialization)
+{
+  const unsigned long capacity = KILOBYTE(64);
+  const unsigned long reserve = MEGABYTE(64);
+  smol::Arena arena(capacity, reserve);
+  SMOL_TEST_EXPECT_GE(arena.getCapacity(), capacity);
+  SMOL_TEST_EXPECT_GE(arena.getReserved(), reserve);
+  SMOL_TEST_EXPECT_EQ(arena.getUsed(), 0);
+  SMOL_TEST_EXPECT_NEQ(arena.getData(), nullptr);
+}
+
+SMOL_TEST(virtual_expand_keeps_pointers)
+{
+  const unsigned long capacity = KILOBYTE(4);
+  smol::Arena arena(capacity, MEGABYTE(64));
+  const char* data = arena.getData();
+
+  char* first = arena.pushSize(16);
+  first[0] = 42;
+  arena.pushSize(MEGABYTE(8));
+
+  SMOL_TEST_EXPECT_TRUE(arena.getData() == data);
+  SMOL_TEST_EXPECT_EQ(first[0], 42);
+  SMOL_TEST_EXPECT_GE(arena.getCapacity(), MEGABYTE(8) + 16);
+}
+
+SMOL_TEST(virtual_decommit_on_reset)
+{
+  smol::Arena arena(KILOBYTE(64), MEGABYTE(64),
+      smol::Arena::VIRTUAL_MEMORY | smol::Arena::DECOMMIT_ON_RESET);
+  arena.pushSize(MEGABYTE(1));
+  arena.reset();
+  SMOL_TEST_EXPECT_EQ(arena.getUsed(), 0);
+  SMOL_TEST_EXPECT_EQ(arena.getCapacity(), 0);
+
+  char* memory = arena.pushSize(KILOBYTE(1));
+  memory[KILOBYTE(1) - 1] = 1;
+  SMOL_TEST_EXPECT_GE(arena.getCapacity(), KILOBYTE(1));
+}
+
+SMOL_TEST(push_aligned)
+{
+  smol::Arena arena(KILOBYTE(1));
+  arena.pushSize(3);
+  char* p16 = arena.pushAligned(8, 16);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) p16) % 16, 0);
+  arena.pushSize(1);
+  char* p64 = arena.pushAligned(8, 64);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) p64) % 64, 0);
+  SMOL_TEST_EXPECT_GE(arena.getUsed(), 64 + 8);
+}
+
+SMOL_TEST(push_typed)
+{
+  struct alignas(32) Wide { float v[8]; };
+
+  smol::Arena arena(0);
+  arena.pushSize(5);
+  double* d = arena.push<double>(4);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) d) % alignof(double), 0);
+  arena.pushSize(1);
+  Wide* w = arena.push<Wide>(2);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) w) % alignof(Wide), 0);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) w) % SMOL_ARENA_MIN_ALIGNMENT, 0);
+}
+
+SMOL_TEST(push_aligned_survives_expand)
+{
+  smol::Arena arena(16);
+  arena.pushSize(1);
+  arena.pushAligned(8, 32);
+  char* p = arena.pushAligned(MEGABYTE(1), 64);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) p) % 64, 0);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) arena.getData()) % SMOL_ARENA_MAX_ALIGNMENT, 0);
+}
+
+SMOL_TEST(mark_rewind)
+{
+  smol::Arena arena(KILOBYTE(1));
+  arena.pushSize(10);
+  smol::ArenaMarker marker = arena.mark();
+  arena.pushSize(100);
+  arena.pushSize(MEGABYTE(1));
+  const size_t capacity = arena.getCapacity();
+
+  arena.rewind(marker);
+  SMOL_TEST_EXPECT_EQ(arena.getUsed(), 10);
+  SMOL_TEST_EXPECT_EQ(arena.getCapacity(), capacity);
+  SMOL_TEST_EXPECT_EQ(arena.pushSize(100), arena.getData() + 10);
+}
+
+SMOL_TEST(frame_allocator_double_buffer)
+{
+  smol::FrameAllocator& frameAllocator = smol::FrameAllocator::get();
+
+  frameAllocator.beginFrame();
+  int* previous = frameAllocator.push<int>(4);
+  previous[3] = 42;
+
+  // Memory from the previous frame is still valid
+  frameAllocator.beginFrame();
+  SMOL_TEST_EXPECT_EQ(frameAllocator.getPreviousArena().getUsed(), 4 * sizeof(int));
+  SMOL_TEST_EXPECT_EQ(frameAllocator.getCurrentArena().getUsed(), 0);
+  int* current = frameAllocator.push<int>(4);
+  SMOL_TEST_EXPECT_NEQ(current, previous);
+  SMOL_TEST_EXPECT_EQ(previous[3], 42);
+
+  // Two frames later the buffer is reused
+  frameAllocator.beginFrame();
+  SMOL_TEST_EXPECT_EQ(frameAllocator.push<int>(4), previous);
+}
+
+SMOL_TEST(memory_tag_tracking)
+{
+  const smol::MemoryStats& stats = smol::Platform::getMemoryStats(smol::MemoryTag::PACKAGE);
+  const size_t liveBytes = stats.liveBytes;
+  {
+    smol::Arena arena(KILOBYTE(4), smol::MemoryTag::PACKAGE);
+    SMOL_TEST_EXPECT_EQ(arena.getMemoryTag(), smol::MemoryTag::PACKAGE);
+    SMOL_TEST_EXPECT_EQ(stats.liveBytes, liveBytes + KILOBYTE(4));
+
+    arena.pushSize(KILOBYTE(8));
+    SMOL_TEST_EXPECT_EQ(stats.liveBytes, liveBytes + arena.getCapacity());
+    SMOL_TEST_EXPECT_GE(stats.peakBytes, liveBytes + arena.getCapacity());
+  }
+  SMOL_TEST_EXPECT_EQ(stats.liveBytes, liveBytes);
+}
@@ -0,0 +1,229 @@
+#include "smol_test.h"
+#include <smol/smol_bounds.h>
+#include <smol/smol_mat4.h>
+#include <vector>
+
+using smol::AABB;
+using smol::BoundingSphere;
+using smol::Frustum;
+using smol::Mat4;
+using smol::Ray;
+using smol::Vector3;
+
+static bool nearlyEqual(float a, float b)
+{
+  return fabsf(a - b) < 0.0001f;
+}
+
+static bool nearlyEqual(const Vector3& a, const Vector3& b)
+{
+  return nearlyEqual(a.x, b.x) && nearlyEqual(a.y, b.y) && nearlyEqual(a.z, b.z);
+}
+
+SMOL_TEST(bounds_from_points)
+{
+  const Vector3 points[] =
+  {
+    Vector3(-1.0f, 0.0f, 2.0f),
+    Vector3(3.0f, -2.0f, 0.0f),
+    Vector3(1.0f, 4.0f, -2.0f)
+  };
+
+  AABB box = AABB::fromPoints(points, 3);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(box.min, Vector3(-1.0f, -2.0f, -2.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(box.max, Vector3(3.0f, 4.0f, 2.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(box.getCenter(), Vector3(1.0f, 1.0f, 0.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(box.getExtents(), Vector3(2.0f, 3.0f, 2.0f)));
+
+  // Every point must be inside the sphere
+  BoundingSphere sphere = BoundingSphere::fromPoints(points, 3);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(sphere.center, Vector3(1.0f, 1.0f, 0.0f)));
+  for (const Vector3& p : points)
+  {
+    const Vector3 d(p.x - sphere.center.x, p.y - sphere.center.y, p.z - sphere.center.z);
+    SMOL_TEST_EXPECT_TRUE(sqrtf(d.x * d.x + d.y * d.y + d.z * d.z) <= sphere.radius + 0.0001f);
+  }
+
+  AABB empty = AABB::fromPoints(nullptr, 0);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(empty.min, Vector3(0.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(empty.max, Vector3(0.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(BoundingSphere::fromPoints(nullptr, 0).radius, 0.0f));
+}
+
+SMOL_TEST(bounds_transformed)
+{
+  AABB box(Vector3(-1.0f, -1.0f, -1.0f), Vector3(1.0f, 1.0f, 1.0f));
+  Mat4 m = Mat4::initTranslation(10.0f, 0.0f, -5.0f).mul(Mat4::initScale(2.0f, 1.0f, 3.0f));
+
+  AABB movedBox = box.transformed(m);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(movedBox.min, Vector3(8.0f, -1.0f, -8.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(movedBox.max, Vector3(12.0f, 1.0f, -2.0f)));
+
+  // A rotated box grows to contain the rotated corners
+  AABB rotatedBox = box.transformed(Mat4::initRotation(0.0f, 0.0f, 45.0f));
+  const float halfDiagonal = sqrtf(2.0f);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(rotatedBox.max, Vector3(halfDiagonal, halfDiagonal, 1.0f)));
+
+  BoundingSphere sphere(Vector3(1.0f, 0.0f, 0.0f), 1.0f);
+  BoundingSphere movedSphere = sphere.transformed(m);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(movedSphere.center, Vector3(12.0f, 0.0f, -5.0f)));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(movedSphere.radius, 3.0f));
+}
+
+SMOL_TEST(frustum_perspective)
+{
+  // Camera at the origin looking down -Z
+  Frustum frustum = Frustum::fromMatrix(Mat4::perspective(60.0f, 1.0f, 1.0f, 100.0f));
+
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(BoundingSphere(Vector3(0.0f, 0.0f, -10.0f), 1.0f)));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(BoundingSphere(Vector3(0.0f, 0.0f, 10.0f), 1.0f)));     // behind
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(BoundingSphere(Vector3(50.0f, 0.0f, -10.0f), 1.0f)));   // right
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(BoundingSphere(Vector3(0.0f, -50.0f, -10.0f), 1.0f)));  // below
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(BoundingSphere(Vector3(0.0f, 0.0f, -150.0f), 1.0f)));   // past far
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(BoundingSphere(Vector3(0.0f, 0.0f, -0.5f), 1.0f)));      // crosses near
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(BoundingSphere(Vector3(0.0f, 0.0f, -105.0f), 10.0f)));   // crosses far
+
+  // tan(30) * 10 is about 5.77. A unit box at x = 6 still touches the frustum.
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(AABB(Vector3(5.5f, -0.5f, -10.5f), Vector3(6.5f, 0.5f, -9.5f))));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(AABB(Vector3(7.0f, -0.5f, -10.5f), Vector3(8.0f, 0.5f, -9.5f))));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(AABB(Vector3(-1.0f, -1.0f, 2.0f), Vector3(1.0f, 1.0f, 4.0f))));
+
+  // Moving the camera moves the frustum
+  Mat4 view = Mat4::initTranslation(-100.0f, 0.0f, 0.0f);
+  Frustum moved = Frustum::fromMatrix(Mat4::mul(Mat4::perspective(60.0f, 1.0f, 1.0f, 100.0f), view));
+  SMOL_TEST_EXPECT_FALSE(moved.intersects(BoundingSphere(Vector3(0.0f, 0.0f, -10.0f), 1.0f)));
+  SMOL_TEST_EXPECT_TRUE(moved.intersects(BoundingSphere(Vector3(100.0f, 0.0f, -10.0f), 1.0f)));
+}
+
+SMOL_TEST(frustum_ortho)
+{
+  Frustum frustum = Frustum::fromMatrix(Mat4::ortho(-10.0f, 10.0f, 10.0f, -10.0f, 0.1f, 100.0f));
+
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(AABB(Vector3(9.5f, 0.0f, -2.0f), Vector3(11.5f, 1.0f, -1.0f))));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(AABB(Vector3(10.5f, 0.0f, -2.0f), Vector3(12.5f, 1.0f, -1.0f))));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(AABB(Vector3(0.0f, 0.0f, 1.0f), Vector3(1.0f, 1.0f, 2.0f))));
+  SMOL_TEST_EXPECT_TRUE(frustum.intersects(BoundingSphere(Vector3(0.0f, -10.5f, -5.0f), 1.0f)));
+  SMOL_TEST_EXPECT_FALSE(frustum.intersects(BoundingSphere(Vector3(0.0f, -11.5f, -5.0f), 1.0f)));
+}
+
+SMOL_TEST(ray_box)
+{
+  AABB box(Vector3(-1.0f), Vector3(1.0f));
+  float distance = -1.0f;
+
+  SMOL_TEST_EXPECT_TRUE(box.intersects(Ray(Vector3(0.0f, 0.0f, 10.0f), Vector3(0.0f, 0.0f, -1.0f)), 100.0f, &distance));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(distance, 9.0f));
+  SMOL_TEST_EXPECT_FALSE(box.intersects(Ray(Vector3(0.0f, 0.0f, 10.0f), Vector3(0.0f, 0.0f, -1.0f)), 8.0f));   // too short
+  SMOL_TEST_EXPECT_FALSE(box.intersects(Ray(Vector3(0.0f, 0.0f, 10.0f), Vector3(0.0f, 0.0f, 1.0f)), 100.0f));   // pointing away
+
+  // Rays parallel to a slab either stay inside it or miss
+  SMOL_TEST_EXPECT_TRUE(box.intersects(Ray(Vector3(0.5f, 1.0f, 10.0f), Vector3(0.0f, 0.0f, -1.0f)), 100.0f));
+  SMOL_TEST_EXPECT_FALSE(box.intersects(Ray(Vector3(0.5f, 1.5f, 10.0f), Vector3(0.0f, 0.0f, -1.0f)), 100.0f));
+  SMOL_TEST_EXPECT_FALSE(box.intersects(Ray(Vector3(-1.5f, 0.0f, 10.0f), Vector3(0.0f, -0.0f, -1.0f)), 100.0f));
+
+  // Diagonal ray through a corner region
+  SMOL_TEST_EXPECT_TRUE(box.intersects(Ray(Vector3(-3.0f, -3.0f, 0.0f), Vector3(1.0f, 1.0f, 0.0f)), 100.0f, &distance));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(distance, 2.0f));
+  SMOL_TEST_EXPECT_FALSE(box.intersects(Ray(Vector3(-3.0f, 0.0f, 0.0f), Vector3(1.0f, 1.5f, 0.0f)), 100.0f));
+
+  // Starting inside hits at 0
+  SMOL_TEST_EXPECT_TRUE(box.intersects(Ray(Vector3(0.0f), Vector3(1.0f, 0.0f, 0.0f)), 100.0f, &distance));
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(distance, 0.0f));
+}
+
+// Plain Moller-Trumbore, one triangle at a time
+static int referenceIntersectTriangles(const Ray& ray, const Vector3* positions, const unsigned int* indices,
+    int count, float maxDistance, float* distance)
+{
+  int closest = -1;
+  for (int i = 0; i < count; i++)
+  {
+    const Vector3& a = positions[indices ? indices[3 * i] : 3 * i];
+    const Vector3& b = positions[indices ? indices[3 * i + 1] : 3 * i + 1];
+    const Vector3& c = positions[indices ? indices[3 * i + 2] : 3 * i + 2];
+    const Vector3 e1(b.x - a.x, b.y - a.y, b.z - a.z);
+    const Vector3 e2(c.x - a.x, c.y - a.y, c.z - a.z);
+    const Vector3& d = ray.direction;
+    const Vector3 p(d.y * e2.z - d.z * e2.y, d.z * e2.x - d.x * e2.z, d.x * e2.y - d.y * e2.x);
+    const float det = e1.x * p.x + e1.y * p.y + e1.z * p.z;
+    if (fabsf(det) < 1e-12f)
+      continue;
+    const Vector3 s(ray.origin.x - a.x, ray.origin.y - a.y, ray.origin.z - a.z);
+    const float u = (s.x * p.x + s.y * p.y + s.z * p.z) / det;
+    const Vector3 q(s.y * e1.z - s.z * e1.y, s.z * e1.x - s.x * e1.z, s.x * e1.y - s.y * e1.x);
+    const float v = (d.x * q.x + d.y * q.y + d.z * q.z) / det;
+    const float t = (e2.x * q.x + e2.y * q.y + e2.z * q.z) / det;
+    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t < maxDistance)
+    {
+      maxDistance = t;
+      closest = i;
+    }
+  }
+  if (closest >= 0)
+    *distance = maxDistance;
+  return closest;
+}
+
+// Small random triangles in a cube around the origin
+static void randomTriangles(std::vector<Vector3>& positions, std::vector<unsigned int>& indices, int count)
+{
+  unsigned int seed = 7;
+  auto random = [&seed](float min, float max)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    return min + (max - min) * (float) (seed >> 8) / (float) (1 << 24);
+  };
+
+  positions.resize(count * 3);
+  indices.resize(count * 3);
+  for (int i = 0; i < count; i++)
+  {
+    const Vector3 center(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+    for (int v = 0; v < 3; v++)
+    {
+      positions[3 * i + v] = Vector3(center.x + random(-1.0f, 1.0f), center.y + random(-1.0f, 1.0f), center.z + random(-1.0f, 1.0f));
+      indices[3 * i + v] = (unsigned int) (3 * (count - 1 - i) + v);   // reversed, so indexed and unindexed differ
+    }
+  }
+}
+
+SMOL_TEST(ray_triangles)
+{
+  // One triangle on the XY plane
+  const Vector3 triangle[] = { Vector3(0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f) };
+  float distance = -1.0f;
+  SMOL_TEST_EXPECT_EQ(Ray(Vector3(0.25f, 0.25f, 5.0f), Vector3(0.0f, 0.0f, -1.0f)).intersectTriangles(triangle, nullptr, 1, 100.0f, &distance), 0);
+  SMOL_TEST_EXPECT_TRUE(nearlyEqual(distance, 5.0f));
+  SMOL_TEST_EXPECT_EQ(Ray(Vector3(0.25f, 0.25f, -5.0f), Vector3(0.0f, 0.0f, 1.0f)).intersectTriangles(triangle, nullptr, 1, 100.0f), 0);   // back face
+  SMOL_TEST_EXPECT_EQ(Ray(Vector3(0.75f, 0.75f, 5.0f), Vector3(0.0f, 0.0f, -1.0f)).intersectTriangles(triangle, nullptr, 1, 100.0f), -1);
+  SMOL_TEST_EXPECT_EQ(Ray(Vector3(0.25f, 0.25f, 5.0f), Vector3(0.0f, 0.0f, -1.0f)).intersectTriangles(triangle, nullptr, 1, 4.0f), -1);
+  SMOL_TEST_EXPECT_EQ(Ray(Vector3(0.25f, 0.25f, 5.0f), Vector3(1.0f, 0.0f, 0.0f)).intersectTriangles(triangle, nullptr, 1, 100.0f), -1);  // parallel
+
+  // Counts that don't fill the last group of 4
+  std::vector<Vector3> positions;
+  std::vector<unsigned int> indices;
+  randomTriangles(positions, indices, 1003);
+
+  unsigned int seed = 3;
+  for (int i = 0; i < 200; i++)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    const Vector3 origin((float) (seed % 41) - 20.0f, (float) ((seed >> 8) % 41) - 20.0f, 30.0f);
+    const Ray ray(origin, Vector3(-origin.x * 0.02f, -origin.y * 0.02f, -1.0f));
+
+    for (int count : { 1003, 1001, 3 })
+    {
+      float expectedDistance = 0.0f;
+      const int expected = referenceIntersectTriangles(ray, positions.data(), indices.data(), count, 100.0f, &expectedDistance);
+      const int found = ray.intersectTriangles(positions.data(), indices.data(), count, 100.0f, &distance);
+      SMOL_TEST_EXPECT_EQ(found, expected);
+      if (found >= 0 && expected >= 0)
+      {
+        SMOL_TEST_EXPECT_TRUE(fabsf(distance - expectedDistance) < 0.001f);
+      }
+
+      const int unindexed = ray.intersectTriangles(positions.data(), nullptr, count, 100.0f);
+      SMOL_TEST_EXPECT_EQ(unindexed, referenceIntersectTriangles(ray, positions.data(), nullptr, count, 100.0f, &expectedDistance));
+    }
+  }
+}
@@ -1,5 +1,8 @@
 #include "smol_test.h"
 #include <smol/smol_handle_list.h>
+#include <smol/smol_concurrent_handle_list.h>
+#include <thread>
+#include <vector>
 
 struct Foo
 {
@@ -235,3 +238,231 @@ SMOL_TEST(reset_and_lookup)
   SMOL_TEST_EXPECT_NULL(hList.lookup(h8));
   smol::Handle<Foo>::registerList(nullptr);
 }
+
+SMOL_TEST(remove_after_previous_removes)
+{
+  smol::HandleList<Foo> hList(8);
+  smol::Handle<Foo> h0 = hList.add(Foo(0, 0.0f));
+  smol::Handle<Foo> h1 = hList.add(Foo(1, 1.0f));
+  smol::Handle<Foo> h2 = hList.add(Foo(2, 2.0f));
+  smol::Handle<Foo> h3 = hList.add(Foo(3, 3.0f));
+
+  // After this the last resource no longer lives in the last slot
+  hList.remove(h0);
+  smol::Handle<Foo> h4 = hList.add(Foo(4, 4.0f));
+  hList.remove(h1);
+  hList.remove(h2);
+
+  SMOL_TEST_EXPECT_EQ(hList.count(), 2);
+  SMOL_TEST_EXPECT_EQ(hList.lookup(h3)->x, 3);
+  SMOL_TEST_EXPECT_EQ(hList.lookup(h4)->x, 4);
+  SMOL_TEST_EXPECT_NULL(hList.lookup(h0));
+  SMOL_TEST_EXPECT_NULL(hList.lookup(h1));
+  SMOL_TEST_EXPECT_NULL(hList.lookup(h2));
+
+  // Removing a stale handle must not touch live resources
+  hList.remove(h2);
+  SMOL_TEST_EXPECT_EQ(hList.count(), 2);
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(for_each_handle)
+{
+  smol::HandleList<Foo> hList(8);
+  smol::Handle<Foo> hDelete = hList.add(Foo(10, 0.0f));
+  hList.add(Foo(20, 0.0f));
+  hList.add(Foo(30, 0.0f));
+  hList.remove(hDelete);
+
+  int visited = 0;
+  hList.forEach([&](smol::Handle<Foo> handle, Foo& foo)
+      {
+        SMOL_TEST_EXPECT_TRUE(hList.lookup(handle) == &foo);
+        foo.y = 1.0f;
+        visited++;
+      });
+
+  SMOL_TEST_EXPECT_EQ(visited, 2);
+  SMOL_TEST_EXPECT_TRUE(hList.getHandle(5) == INVALID_HANDLE(Foo));
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(defragment)
+{
+  smol::HandleList<Foo> hList(8);
+  smol::Handle<Foo> handles[6];
+  for (int i = 0; i < 6; i++)
+    handles[i] = hList.add(Foo(i, 0.0f));
+
+  hList.remove(handles[0]);
+  hList.remove(handles[2]);
+
+  // Swap-removes leave resources out of creation order
+  SMOL_TEST_EXPECT_EQ(hList.getArray()[0].x, 5);
+  hList.defragment();
+
+  const Foo* foos = hList.getArray();
+  SMOL_TEST_EXPECT_EQ(foos[0].x, 1);
+  SMOL_TEST_EXPECT_EQ(foos[1].x, 3);
+  SMOL_TEST_EXPECT_EQ(foos[2].x, 4);
+  SMOL_TEST_EXPECT_EQ(foos[3].x, 5);
+  for (int i = 1; i < 6; i += 2)
+    SMOL_TEST_EXPECT_EQ(hList.lookup(handles[i])->x, i);
+
+  // Free slots are reused from the lowest index
+  SMOL_TEST_EXPECT_EQ(hList.add(Foo(6, 0.0f)).slotIndex, 0);
+
+  // Custom order
+  hList.defragment([](const Foo& a, const Foo& b) { return a.x > b.x; });
+  SMOL_TEST_EXPECT_EQ(hList.getArray()[0].x, 6);
+  SMOL_TEST_EXPECT_EQ(hList.lookup(handles[4])->x, 4);
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(reset_keeps_handles_invalid)
+{
+  smol::HandleList<Foo> hList(8);
+  smol::Handle<Foo> hOld = hList.add(Foo(1, 0.0f));
+  hList.reset();
+
+  smol::Handle<Foo> hNew = hList.add(Foo(2, 0.0f));
+  SMOL_TEST_EXPECT_EQ(hNew.slotIndex, hOld.slotIndex);
+  SMOL_TEST_EXPECT_NULL(hList.lookup(hOld));
+  SMOL_TEST_EXPECT_EQ(hList.lookup(hNew)->x, 2);
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(pointer_stable_add)
+{
+  smol::HandleList<Foo> hList(8, 100000);
+  SMOL_TEST_EXPECT_TRUE(hList.isPointerStable());
+
+  smol::Handle<Foo> hFirst = hList.add(Foo(1, 1.0f));
+  Foo* first = hList.lookup(hFirst);
+  const Foo* array = hList.getArray();
+
+  for (int i = 0; i < 50000; i++)
+    hList.add(Foo(i, 0.0f));
+
+  SMOL_TEST_EXPECT_TRUE(hList.lookup(hFirst) == first);
+  SMOL_TEST_EXPECT_TRUE(hList.getArray() == array);
+  SMOL_TEST_EXPECT_EQ(first->x, 1);
+  SMOL_TEST_EXPECT_EQ(hList.count(), 50001);
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(concurrent_add_lookup_remove)
+{
+  smol::ConcurrentHandleList<Foo> hList(16);
+  smol::Handle<Foo> h1 = hList.add(Foo(1, 1.0f));
+  smol::Handle<Foo> h2 = hList.add(Foo(2, 2.0f));
+  SMOL_TEST_EXPECT_EQ(hList.count(), 2);
+  SMOL_TEST_EXPECT_EQ(hList.lookup(h2)->x, 2);
+
+  SMOL_TEST_EXPECT_TRUE(hList.remove(h1));
+  SMOL_TEST_EXPECT_FALSE(hList.remove(h1));
+  SMOL_TEST_EXPECT_NULL(hList.lookup(h1));
+
+  // The freed slot is reused with a new version
+  smol::Handle<Foo> h3 = hList.add(Foo(3, 3.0f));
+  SMOL_TEST_EXPECT_EQ(h3.slotIndex, h1.slotIndex);
+  SMOL_TEST_EXPECT_NULL(hList.lookup(h1));
+  SMOL_TEST_EXPECT_EQ(hList.lookup(h3)->x, 3);
+}
+
+SMOL_TEST(concurrent_full)
+{
+  smol::ConcurrentHandleList<Foo> hList(2);
+  hList.add(Foo(1, 1.0f));
+  hList.add(Foo(2, 2.0f));
+  smol::Handle<Foo> hFull = hList.add(Foo(3, 3.0f));
+  SMOL_TEST_EXPECT_TRUE(hFull == INVALID_HANDLE(Foo));
+  SMOL_TEST_EXPECT_EQ(hList.count(), 2);
+}
+
+SMOL_TEST(concurrent_threads)
+{
+  const int numThreads = 4;
+  const int numIterations = 20000;
+  smol::ConcurrentHandleList<Foo> hList(numThreads * 8);
+  bool failed[numThreads] = {};
+  std::thread threads[numThreads];
+
+  for (int t = 0; t < numThreads; t++)
+  {
+    threads[t] = std::thread([&hList, &failed, t, numIterations]()
+        {
+          for (int i = 0; i < numIterations; i++)
+          {
+            smol::Handle<Foo> handle = hList.add(Foo(t, (float) i));
+            Foo* foo = hList.lookup(handle);
+            if (!foo || foo->x != t || foo->y != (float) i || !hList.remove(handle) || hList.lookup(handle))
+              failed[t] = true;
+          }
+        });
+  }
+
+  for (int t = 0; t < numThreads; t++)
+  {
+    threads[t].join();
+    SMOL_TEST_EXPECT_FALSE(failed[t]);
+  }
+
+  SMOL_TEST_EXPECT_EQ(hList.count(), 0);
+
+  int visited = 0;
+  hList.forEach([&visited](smol::Handle<Foo>, Foo&) { visited++; });
+  SMOL_TEST_EXPECT_EQ(visited, 0);
+}
+
+SMOL_TEST(add_many)
+{
+  smol::HandleList<Foo> hList(4);
+  smol::Handle<Foo> hRemoved = hList.add(Foo(-1, 0.0f));
+  hList.remove(hRemoved);
+
+  std::vector<Foo> source;
+  for (int i = 0; i < 100; i++)
+    source.push_back(Foo(i, (float) i));
+
+  smol::Handle<Foo> handles[100];
+  hList.addMany(source.data(), 100, handles);
+
+  SMOL_TEST_EXPECT_EQ(hList.count(), 100);
+  SMOL_TEST_EXPECT_EQ(handles[0].slotIndex, hRemoved.slotIndex);
+  SMOL_TEST_EXPECT_NULL(hList.lookup(hRemoved));
+  for (int i = 0; i < 100; i++)
+  {
+    SMOL_TEST_EXPECT_EQ(hList.lookup(handles[i])->x, i);
+    SMOL_TEST_EXPECT_EQ(hList.getArray()[i].x, i);
+  }
+  smol::Handle<Foo>::registerList(nullptr);
+}
+
+SMOL_TEST(remove_many)
+{
+  smol::HandleList<Foo> hList(8);
+  smol::Handle<Foo> handles[10];
+  for (int i = 0; i < 10; i++)
+    handles[i] = hList.add(Foo(i, 0.0f));
+
+  smol::Handle<Foo> toRemove[] = { handles[7], handles[2], handles[3], handles[2], INVALID_HANDLE(Foo) };
+  SMOL_TEST_EXPECT_EQ(hList.removeMany(toRemove, 5), 3);
+  SMOL_TEST_EXPECT_EQ(hList.count(), 7);
+
+  // Remaining resources keep their order
+  const int expected[] = { 0, 1, 4, 5, 6, 8, 9 };
+  for (int i = 0; i < 7; i++)
+  {
+    SMOL_TEST_EXPECT_EQ(hList.getArray()[i].x, expected[i]);
+    SMOL_TEST_EXPECT_EQ(hList.lookup(handles[expected[i]])->x, expected[i]);
+  }
+  SMOL_TEST_EXPECT_NULL(hList.lookup(handles[2]));
+
+  // Freed slots are reused
+  smol::Handle<Foo> added[4];
+  hList.reserveMany(4, added);
+  SMOL_TEST_EXPECT_EQ(hList.count(), 11);
+  SMOL_TEST_EXPECT_EQ(hList.lookup(handles[9])->x, 9);
+  smol::Handle<Foo>::registerList(nullptr);
+}
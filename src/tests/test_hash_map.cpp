@@ -0,0 +1,128 @@
+#include "smol_test.h"
+#include <smol/smol_hash_map.h>
+#include <smol/smol_string_hash.h>
+
+SMOL_TEST(insert_and_find)
+{
+  smol::HashMap<int> map(8);
+  SMOL_TEST_EXPECT_NULL(map.find(smol::stringToHash("missing")));
+
+  map.insert(smol::stringToHash("diffuse"), 1);
+  map.insert(smol::stringToHash("normal"), 2);
+  map.insert(smol::stringToHash("specular"), 3);
+
+  SMOL_TEST_EXPECT_EQ(map.count(), 3);
+  SMOL_TEST_EXPECT_EQ(*map.find(smol::stringToHash("diffuse")), 1);
+  SMOL_TEST_EXPECT_EQ(*map.find(smol::stringToHash("normal")), 2);
+  SMOL_TEST_EXPECT_EQ(*map.find(smol::stringToHash("specular")), 3);
+  SMOL_TEST_EXPECT_NULL(map.find(smol::stringToHash("missing")));
+
+  // Inserting an existing key replaces the value
+  map.insert(smol::stringToHash("normal"), 20);
+  SMOL_TEST_EXPECT_EQ(map.count(), 3);
+  SMOL_TEST_EXPECT_EQ(*map.find(smol::stringToHash("normal")), 20);
+}
+
+SMOL_TEST(remove)
+{
+  smol::HashMap<int> map(8);
+  for (int i = 0; i < 100; i++)
+    map.insert(i, i * 10);
+
+  for (int i = 0; i < 100; i += 2)
+    SMOL_TEST_EXPECT_TRUE(map.remove(i));
+
+  SMOL_TEST_EXPECT_FALSE(map.remove(0));
+  SMOL_TEST_EXPECT_EQ(map.count(), 50);
+
+  for (int i = 0; i < 100; i++)
+  {
+    if (i % 2)
+    {
+      SMOL_TEST_EXPECT_EQ(*map.find(i), i * 10);
+    }
+    else
+    {
+      SMOL_TEST_EXPECT_NULL(map.find(i));
+    }
+  }
+
+  map.reset();
+  SMOL_TEST_EXPECT_EQ(map.count(), 0);
+  SMOL_TEST_EXPECT_NULL(map.find(1));
+}
+
+SMOL_TEST(grow)
+{
+  smol::HashMap<uint32> map;
+  const uint32 numItems = 10000;
+
+  for (uint32 i = 0; i < numItems; i++)
+    map.insert(i, i);
+
+  SMOL_TEST_EXPECT_EQ(map.count(), numItems);
+  SMOL_TEST_EXPECT_GE(map.getCapacity(), numItems);
+
+  bool allFound = true;
+  for (uint32 i = 0; i < numItems; i++)
+  {
+    uint32* value = map.find(i);
+    allFound &= (value != nullptr && *value == i);
+  }
+  SMOL_TEST_EXPECT_TRUE(allFound);
+}
+
+SMOL_TEST(churn_keeps_working)
+{
+  // Insert and remove many times so tombstones pile up without the map growing
+  smol::HashMap<uint32> map(64);
+  const size_t capacity = map.getCapacity();
+
+  for (uint32 i = 0; i < 10000; i++)
+  {
+    map.insert(i, i);
+    if (i >= 32)
+      SMOL_TEST_EXPECT_TRUE(map.remove(i - 32));
+  }
+
+  SMOL_TEST_EXPECT_EQ(map.count(), 32);
+  SMOL_TEST_EXPECT_EQ(map.getCapacity(), capacity);
+  SMOL_TEST_EXPECT_EQ(*map.find(9999), 9999);
+  SMOL_TEST_EXPECT_NULL(map.find(9967));
+}
+
+SMOL_TEST(arena_memory)
+{
+  smol::Arena arena(KILOBYTE(4));
+  smol::HashMap<uint16> map;
+  map.initialize(arena, 100);
+
+  SMOL_TEST_EXPECT_EQ(arena.getUsed(), smol::HashMap<uint16>::getMemorySize(100));
+  SMOL_TEST_EXPECT_GE(map.getCapacity(), 100);
+
+  for (uint16 i = 0; i < 100; i++)
+    SMOL_TEST_EXPECT_NOT_NULL(map.insert(i + 32, i));
+
+  for (uint16 i = 0; i < 100; i++)
+    SMOL_TEST_EXPECT_EQ(*map.find(i + 32), i);
+
+  // Fixed size maps never grow
+  const size_t capacity = map.getCapacity();
+  for (uint16 i = 100; i < capacity; i++)
+    SMOL_TEST_EXPECT_NOT_NULL(map.insert(i + 32, i));
+
+  SMOL_TEST_EXPECT_NULL(map.insert(0xFFFF, 0));
+  SMOL_TEST_EXPECT_EQ(map.count(), capacity);
+}
+
+SMOL_TEST(external_memory)
+{
+  alignas(8) char memory[1024];
+  SMOL_TEST_EXPECT_LE(smol::HashMap<uint64>::getMemorySize(10), sizeof(memory));
+
+  smol::HashMap<uint64> map;
+  map.initialize(memory, 10);
+  map.insert(42, 4242);
+  SMOL_TEST_EXPECT_EQ(*map.find(42), 4242);
+  SMOL_TEST_EXPECT_NULL(map.find(43));
+}
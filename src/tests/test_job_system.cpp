@@ -0,0 +1,202 @@
+#include "smol_test.h"
+#include <smol/smol_job_system.h>
+#include <atomic>
+#include <vector>
+
+// Enough workers to exercise stealing even on machines with few cores
+static const int TEST_WORKER_COUNT = 3;
+
+static void incrementJob(void* data)
+{
+  ((std::atomic<int>*) data)->fetch_add(1);
+}
+
+SMOL_TEST(run_and_wait)
+{
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  SMOL_TEST_EXPECT_TRUE(jobSystem.initialize(TEST_WORKER_COUNT));
+  SMOL_TEST_EXPECT_EQ(jobSystem.getWorkerCount(), TEST_WORKER_COUNT);
+
+  std::atomic<int> value(0);
+  smol::JobCounter counter;
+  for (int i = 0; i < 10000; i++)
+    jobSystem.run(incrementJob, &value, &counter);
+
+  jobSystem.wait(&counter);
+  SMOL_TEST_EXPECT_TRUE(counter.isDone());
+  SMOL_TEST_EXPECT_EQ(value.load(), 10000);
+
+  jobSystem.shutdown();
+  SMOL_TEST_EXPECT_FALSE(jobSystem.isInitialized());
+}
+
+SMOL_TEST(run_without_initializing)
+{
+  // Jobs run immediately when there is no job system
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  std::atomic<int> value(0);
+  smol::JobCounter counter;
+  jobSystem.run(incrementJob, &value, &counter);
+  SMOL_TEST_EXPECT_EQ(value.load(), 1);
+  SMOL_TEST_EXPECT_TRUE(counter.isDone());
+  jobSystem.wait(&counter);
+}
+
+struct DependencyTestData
+{
+  int values[100];
+  std::atomic<int> next;
+  int sum;
+  bool sumRanAfterValues;
+};
+
+static void writeValueJob(void* data)
+{
+  DependencyTestData* test = (DependencyTestData*) data;
+  int index = test->next.fetch_add(1);
+  test->values[index] = index + 1;
+}
+
+static void sumValuesJob(void* data)
+{
+  DependencyTestData* test = (DependencyTestData*) data;
+  test->sumRanAfterValues = test->next.load() == 100;
+  test->sum = 0;
+  for (int i = 0; i < 100; i++)
+    test->sum += test->values[i];
+}
+
+SMOL_TEST(dependencies)
+{
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  jobSystem.initialize(TEST_WORKER_COUNT);
+
+  for (int round = 0; round < 100; round++)
+  {
+    DependencyTestData data;
+    data.next.store(0);
+    data.sum = 0;
+    data.sumRanAfterValues = false;
+
+    smol::JobCounter valuesDone;
+    smol::JobCounter sumDone;
+
+    for (int i = 0; i < 100; i++)
+      jobSystem.run(writeValueJob, &data, &valuesDone);
+    jobSystem.run(sumValuesJob, &data, &sumDone, &valuesDone);
+
+    jobSystem.wait(&sumDone);
+    jobSystem.wait(&valuesDone);
+    SMOL_TEST_EXPECT_TRUE(data.sumRanAfterValues);
+    SMOL_TEST_EXPECT_EQ(data.sum, 5050);
+  }
+
+  // A dependency that is already done does not block
+  std::atomic<int> value(0);
+  smol::JobCounter done;
+  smol::JobCounter counter;
+  jobSystem.run(incrementJob, &value, &counter, &done);
+  jobSystem.wait(&counter);
+  SMOL_TEST_EXPECT_EQ(value.load(), 1);
+
+  jobSystem.shutdown();
+}
+
+static void parentJob(void* data)
+{
+  // Jobs can schedule and wait for other jobs
+  smol::JobCounter children;
+  for (int i = 0; i < 10; i++)
+    smol::JobSystem::get().run(incrementJob, data, &children);
+  smol::JobSystem::get().wait(&children);
+}
+
+SMOL_TEST(nested_jobs)
+{
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  jobSystem.initialize(TEST_WORKER_COUNT);
+
+  std::atomic<int> value(0);
+  smol::JobCounter counter;
+  for (int i = 0; i < 100; i++)
+    jobSystem.run(parentJob, &value, &counter);
+
+  jobSystem.wait(&counter);
+  SMOL_TEST_EXPECT_EQ(value.load(), 1000);
+  jobSystem.shutdown();
+}
+
+static void markRange(int32 start, int32 end, void* data)
+{
+  std::atomic<int>* visits = (std::atomic<int>*) data;
+  for (int32 i = start; i < end; i++)
+    visits[i].fetch_add(1);
+}
+
+SMOL_TEST(parallel_for)
+{
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  const int count = 100003;
+  std::vector<std::atomic<int>> visits(count);
+
+  // Runs on the calling thread without a job system
+  for (int i = 0; i < count; i++)
+    visits[i].store(0);
+  jobSystem.parallelFor(count, 64, markRange, visits.data());
+
+  jobSystem.initialize(TEST_WORKER_COUNT);
+  jobSystem.parallelFor(count, 64, markRange, visits.data());
+  jobSystem.parallelFor(count, 1000000, markRange, visits.data());
+  jobSystem.parallelFor(0, 64, markRange, visits.data());
+
+  bool allVisitedThreeTimes = true;
+  for (int i = 0; i < count; i++)
+    allVisitedThreeTimes &= visits[i].load() == 3;
+
+  SMOL_TEST_EXPECT_TRUE(allVisitedThreeTimes);
+  jobSystem.shutdown();
+}
+
+struct RangeCheck
+{
+  int32 count;
+  int32 batchSize;
+  std::atomic<int> ranges;
+  std::atomic<int> badRanges;
+};
+
+static void checkRange(int32 start, int32 end, void* data)
+{
+  RangeCheck* check = (RangeCheck*) data;
+  const int32 expectedEnd = start + check->batchSize < check->count ? start + check->batchSize : check->count;
+  if (start % check->batchSize != 0 || end != expectedEnd)
+    check->badRanges.fetch_add(1);
+  check->ranges.fetch_add(1);
+}
+
+SMOL_TEST(parallel_for_ranges)
+{
+  // Callers index per batch data by start / batchSize, so every path must
+  // hand out the same ranges
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  RangeCheck check;
+  check.count = 10000;
+  check.batchSize = 1024;
+
+  for (int run = 0; run < 3; run++)
+  {
+    if (run == 1)
+      jobSystem.initialize(0);
+    else if (run == 2)
+      jobSystem.initialize(TEST_WORKER_COUNT);
+
+    check.ranges.store(0);
+    check.badRanges.store(0);
+    jobSystem.parallelFor(check.count, check.batchSize, checkRange, &check);
+    SMOL_TEST_EXPECT_EQ(check.ranges.load(), 10);
+    SMOL_TEST_EXPECT_EQ(check.badRanges.load(), 0);
+
+    if (run > 0)
+      jobSystem.shutdown();
+  }
+}
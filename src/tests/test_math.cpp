@@ -1,5 +1,231 @@
 #include "smol_test.h"
 #include <smol/smol_mat4.h>
+#include <smol/smol_quaternion.h>
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+//
+// Scalar reference implementations. These are the Mat4 kernels from before
+// the SIMD code path and are used to check and benchmark the current ones.
+//
+
+static smol::Mat4 referenceMul(const smol::Mat4& a, const smol::Mat4& b)
+{
+  smol::Mat4 m;
+  for (int line = 0; line < 4; line++)
+  {
+    for (int column = 0; column < 4; column++)
+    {
+      m.e[column][line] =
+        a.e[0][line] * b.e[column][0] +
+        a.e[1][line] * b.e[column][1] +
+        a.e[2][line] * b.e[column][2] +
+        a.e[3][line] * b.e[column][3];
+    }
+  }
+  return m;
+}
+
+static smol::Mat4 referenceInvert(const smol::Mat4& m)
+{
+  double inv[16];
+  float* me = (float*) m.e; // just access target matrix elements lineraly. 
+
+  //NOTE(marcio): our matrices are floats. But we calculate the determinant as doubles to enforce precision. I'm not really sure how effectit this is.
+  inv[0] = me[5]  * me[10] * me[15] - 
+    me[5]  * me[11] * me[14] - 
+    me[9]  * me[6]  * me[15] + 
+    me[9]  * me[7]  * me[14] +
+    me[13] * me[6]  * me[11] - 
+    me[13] * me[7]  * me[10];
+
+  inv[4] = -me[4]  * me[10] * me[15] + 
+    me[4]  * me[11] * me[14] + 
+    me[8]  * me[6]  * me[15] - 
+    me[8]  * me[7]  * me[14] - 
+    me[12] * me[6]  * me[11] + 
+    me[12] * me[7]  * me[10];
+
+  inv[8] = me[4]  * me[9] * me[15] - 
+    me[4]  * me[11] * me[13] - 
+    me[8]  * me[5] * me[15] + 
+    me[8]  * me[7] * me[13] + 
+    me[12] * me[5] * me[11] - 
+    me[12] * me[7] * me[9];
+
+  inv[12] = -me[4]  * me[9] * me[14] + 
+    me[4]  * me[10] * me[13] +
+    me[8]  * me[5] * me[14] - 
+    me[8]  * me[6] * me[13] - 
+    me[12] * me[5] * me[10] + 
+    me[12] * me[6] * me[9];
+
+  inv[1] = -me[1]  * me[10] * me[15] + 
+    me[1]  * me[11] * me[14] + 
+    me[9]  * me[2] * me[15] - 
+    me[9]  * me[3] * me[14] - 
+    me[13] * me[2] * me[11] + 
+    me[13] * me[3] * me[10];
+
+  inv[5] = me[0]  * me[10] * me[15] - 
+    me[0]  * me[11] * me[14] - 
+    me[8]  * me[2] * me[15] + 
+    me[8]  * me[3] * me[14] + 
+    me[12] * me[2] * me[11] - 
+    me[12] * me[3] * me[10];
+
+  inv[9] = -me[0]  * me[9] * me[15] + 
+    me[0]  * me[11] * me[13] + 
+    me[8]  * me[1] * me[15] - 
+    me[8]  * me[3] * me[13] - 
+    me[12] * me[1] * me[11] + 
+    me[12] * me[3] * me[9];
+
+  inv[13] = me[0]  * me[9] * me[14] - 
+    me[0]  * me[10] * me[13] - 
+    me[8]  * me[1] * me[14] + 
+    me[8]  * me[2] * me[13] + 
+    me[12] * me[1] * me[10] - 
+    me[12] * me[2] * me[9];
+
+  inv[2] = me[1]  * me[6] * me[15] - 
+    me[1]  * me[7] * me[14] - 
+    me[5]  * me[2] * me[15] + 
+    me[5]  * me[3] * me[14] + 
+    me[13] * me[2] * me[7] - 
+    me[13] * me[3] * me[6];
+
+  inv[6] = -me[0]  * me[6] * me[15] + 
+    me[0]  * me[7] * me[14] + 
+    me[4]  * me[2] * me[15] - 
+    me[4]  * me[3] * me[14] - 
+    me[12] * me[2] * me[7] + 
+    me[12] * me[3] * me[6];
+
+  inv[10] = me[0]  * me[5] * me[15] - 
+    me[0]  * me[7] * me[13] - 
+    me[4]  * me[1] * me[15] + 
+    me[4]  * me[3] * me[13] + 
+    me[12] * me[1] * me[7] - 
+    me[12] * me[3] * me[5];
+
+  inv[14] = -me[0]  * me[5] * me[14] + 
+    me[0]  * me[6] * me[13] + 
+    me[4]  * me[1] * me[14] - 
+    me[4]  * me[2] * me[13] - 
+    me[12] * me[1] * me[6] + 
+    me[12] * me[2] * me[5];
+
+  inv[3] = -me[1] * me[6] * me[11] + 
+    me[1] * me[7] * me[10] + 
+    me[5] * me[2] * me[11] - 
+    me[5] * me[3] * me[10] - 
+    me[9] * me[2] * me[7] + 
+    me[9] * me[3] * me[6];
+
+  inv[7] = me[0] * me[6] * me[11] - 
+    me[0] * me[7] * me[10] - 
+    me[4] * me[2] * me[11] + 
+    me[4] * me[3] * me[10] + 
+    me[8] * me[2] * me[7] - 
+    me[8] * me[3] * me[6];
+
+  inv[11] = -me[0] * me[5] * me[11] + 
+    me[0] * me[7] * me[9] + 
+    me[4] * me[1] * me[11] - 
+    me[4] * me[3] * me[9] - 
+    me[8] * me[1] * me[7] + 
+    me[8] * me[3] * me[5];
+
+  inv[15] = me[0] * me[5] * me[10] - 
+    me[0] * me[6] * me[9] - 
+    me[4] * me[1] * me[10] + 
+    me[4] * me[2] * me[9] + 
+    me[8] * me[1] * me[6] - 
+    me[8] * me[2] * me[5];
+
+  double det = me[0] * inv[0] + me[1] * inv[4] + me[2] * inv[8] + me[3] * inv[12];
+
+  if (det == 0)
+    return smol::Mat4::initIdentity();
+
+  det = 1.0 / det;
+
+  // Stores the result on a new matrix
+  smol::Mat4 inverseMatrix;
+  me = (float*) inverseMatrix.e;
+  for (int i = 0; i < 16; i++)
+    me[i] = (float) (inv[i] * det);
+
+  return inverseMatrix;
+}
+
+
+static smol::Mat4 referenceRotation(float x, float y, float z)
+{
+  const double toRad = (M_PI/180.0);
+
+  const double angleX = x * toRad;
+  const double angleY = y * toRad;
+  const double angleZ = z * toRad;
+
+  const double cx = cos(angleX);
+  const double cy = cos(angleY);
+  const double cz = cos(angleZ);
+
+  const double sx = sin(angleX);
+  const double sy = sin(angleY);
+  const double sz = sin(angleZ);
+
+  // Right-hand rotation matrices
+  smol::Mat4 xRot = smol::Mat4::initIdentity();
+  xRot.e[1][1] = (float)(cx);
+  xRot.e[1][2] = (float)(sx);
+  xRot.e[2][1] = (float)(-sx);
+  xRot.e[2][2] = (float)(cx);
+
+  smol::Mat4 yRot = smol::Mat4::initIdentity();
+  yRot.e[0][0] = (float)(cy);
+  yRot.e[0][2] = (float)(-sy);
+  yRot.e[2][0] = (float)(sy);
+  yRot.e[2][2] = (float)(cy);
+
+  smol::Mat4 zRot = smol::Mat4::initIdentity();
+  zRot.e[0][0] = (float)(cz);
+  zRot.e[0][1] = (float)(sz);
+  zRot.e[1][0] = (float)(-sz);
+  zRot.e[1][1] = (float)(cz);
+
+  return referenceMul(zRot, referenceMul(yRot, xRot));
+}
+
+
+// Transform::update used to compose separate matrices like this
+static smol::Mat4 referenceTRS(const smol::Vector3& p, const smol::Vector3& r, const smol::Vector3& s)
+{
+  smol::Mat4 transformed = referenceMul(referenceRotation(r.x, r.y, r.z), smol::Mat4::initScale(s.x, s.y, s.z));
+  return referenceMul(smol::Mat4::initTranslation(p.x, p.y, p.z), transformed);
+}
+
+static smol::Mat4 makeTestMatrix(float seed)
+{
+  smol::Mat4 m = smol::Mat4::mul(
+      smol::Mat4::initTranslation(seed, -2.0f * seed, 3.5f),
+      smol::Mat4::initRotation(10.0f * seed, 20.0f + seed, -30.0f));
+  return smol::Mat4::mul(m, smol::Mat4::initScale(1.0f + seed * 0.1f, 2.0f, 0.5f));
+}
+
+static bool matricesNear(const smol::Mat4& a, const smol::Mat4& b, float epsilon = 0.0001f)
+{
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++)
+      if (fabs(a.e[i][j] - b.e[i][j]) > epsilon)
+        return false;
+  return true;
+}
 
 SMOL_TEST(identity)
 {
@@ -45,3 +271,235 @@ SMOL_TEST(identity_multiplication)
     }
   }
 }
+
+SMOL_TEST(multiplication_matches_reference)
+{
+  smol::Mat4 a = makeTestMatrix(1.0f);
+  smol::Mat4 b = makeTestMatrix(2.5f);
+  a.e[0][3] = 0.25f; // make it not affine
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::mul(a, b), referenceMul(a, b)));
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::mul(b, a), referenceMul(b, a)));
+}
+
+SMOL_TEST(multiplication_batch)
+{
+  const int count = 7;
+  std::vector<smol::Mat4> a(count), b(count), out(count);
+  for (int i = 0; i < count; i++)
+  {
+    a[i] = makeTestMatrix((float) i);
+    b[i] = makeTestMatrix((float) i * 0.5f + 1.0f);
+  }
+
+  smol::Mat4::mulBatch(a.data(), b.data(), out.data(), count);
+  for (int i = 0; i < count; i++)
+    SMOL_TEST_EXPECT_TRUE(matricesNear(out[i], referenceMul(a[i], b[i])));
+
+  // In place
+  smol::Mat4::mulBatch(a.data(), b.data(), a.data(), count);
+  for (int i = 0; i < count; i++)
+    SMOL_TEST_EXPECT_TRUE(matricesNear(a[i], out[i]));
+}
+
+SMOL_TEST(inverse)
+{
+  smol::Mat4 m = makeTestMatrix(1.5f);
+  smol::Mat4 inverse = smol::Mat4::invert(m);
+
+  SMOL_TEST_EXPECT_TRUE(matricesNear(inverse, referenceInvert(m)));
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::mul(m, inverse), smol::Mat4::initIdentity()));
+
+  smol::Mat4 perspective = smol::Mat4::perspective(60.0f, 1.5f, 0.1f, 100.0f);
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::mul(perspective, perspective.inverse()), smol::Mat4::initIdentity()));
+
+  // Singular matrices have no inverse. We get the identity back.
+  smol::Mat4 singular = {};
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::invert(singular), smol::Mat4::initIdentity()));
+}
+
+SMOL_TEST(transpose)
+{
+  smol::Mat4 m = makeTestMatrix(3.0f);
+  smol::Mat4 t = smol::Mat4::transpose(m);
+
+  for (int i = 0; i < 4; i++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      SMOL_TEST_EXPECT_FLOAT_EQ(t.e[i][j], m.e[j][i]);
+    }
+  }
+}
+
+SMOL_TEST(transform_point)
+{
+  smol::Mat4 m = smol::Mat4::mul(smol::Mat4::initTranslation(1.0f, 2.0f, 3.0f), smol::Mat4::initScale(2.0f));
+  smol::Vector3 p = smol::Mat4::mul(m, smol::Vector3(1.0f, 1.0f, 1.0f));
+  SMOL_TEST_EXPECT_FLOAT_EQ(p.x, 3.0f);
+  SMOL_TEST_EXPECT_FLOAT_EQ(p.y, 4.0f);
+  SMOL_TEST_EXPECT_FLOAT_EQ(p.z, 5.0f);
+}
+
+SMOL_TEST(benchmark_kernels)
+{
+  const int count = 100000;
+  std::vector<smol::Mat4> a(count), b(count), out(count);
+  for (int i = 0; i < count; i++)
+  {
+    a[i] = makeTestMatrix((float) (i % 100));
+    b[i] = makeTestMatrix((float) (i % 37));
+  }
+
+  auto elapsed = [](std::chrono::high_resolution_clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  };
+
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < count; i++)
+    out[i] = referenceMul(a[i], b[i]);
+  double referenceMulMs = elapsed(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < count; i++)
+    out[i] = smol::Mat4::mul(a[i], b[i]);
+  double mulMs = elapsed(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  smol::Mat4::mulBatch(a.data(), b.data(), out.data(), count);
+  double mulBatchMs = elapsed(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < count; i++)
+    out[i] = referenceInvert(a[i]);
+  double referenceInvertMs = elapsed(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < count; i++)
+    out[i] = smol::Mat4::invert(a[i]);
+  double invertMs = elapsed(start);
+
+  SMOL_TEST_EXPECT_TRUE(matricesNear(out[count - 1], referenceInvert(a[count - 1])));
+  printf("\n\t%d matrices: mul %.2f ms (reference %.2f ms), mulBatch %.2f ms, invert %.2f ms (reference %.2f ms)\n",
+      count, mulMs, referenceMulMs, mulBatchMs, invertMs, referenceInvertMs);
+}
+
+SMOL_TEST(from_trs)
+{
+  const smol::Vector3 position(1.0f, -2.0f, 3.0f);
+  const smol::Vector3 rotation(30.0f, -45.0f, 170.0f);
+  const smol::Vector3 scale(2.0f, 0.5f, 1.5f);
+
+  smol::Mat4 m = smol::Mat4::fromTRS(position, rotation, scale);
+  SMOL_TEST_EXPECT_TRUE(matricesNear(m, referenceTRS(position, rotation, scale)));
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::initRotation(10.0f, 20.0f, 30.0f), referenceRotation(10.0f, 20.0f, 30.0f)));
+}
+
+SMOL_TEST(affine_inverse)
+{
+  // Non uniform scale under a rotated parent adds shear
+  smol::Mat4 parent = smol::Mat4::fromTRS(smol::Vector3(5.0f, 0.0f, -1.0f), smol::Vector3(0.0f, 45.0f, 0.0f), smol::Vector3(1.0f, 3.0f, 1.0f));
+  smol::Mat4 child = smol::Mat4::fromTRS(smol::Vector3(1.0f, 2.0f, 3.0f), smol::Vector3(15.0f, 0.0f, 60.0f), smol::Vector3(0.5f, 1.0f, 2.0f));
+  smol::Mat4 m = smol::Mat4::mul(parent, child);
+
+  smol::Mat4 inverse = m.affineInverse();
+  SMOL_TEST_EXPECT_TRUE(matricesNear(inverse, referenceInvert(m)));
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::mul(m, inverse), smol::Mat4::initIdentity()));
+  SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::affineInvert(smol::Mat4::initScale(0.0f)), smol::Mat4::initIdentity()));
+}
+
+static bool quaternionsNear(const smol::Quaternion& a, const smol::Quaternion& b, float epsilon)
+{
+  // q and -q are the same rotation
+  return fabsf(fabsf(smol::Quaternion::dot(a, b)) - 1.0f) <= epsilon;
+}
+
+SMOL_TEST(quaternion_from_euler)
+{
+  const smol::Vector3 rotations[] =
+  {
+    smol::Vector3(0.0f, 0.0f, 0.0f),
+    smol::Vector3(90.0f, 0.0f, 0.0f),
+    smol::Vector3(0.0f, -45.0f, 0.0f),
+    smol::Vector3(0.0f, 0.0f, 180.0f),
+    smol::Vector3(30.0f, 60.0f, -120.0f),
+    smol::Vector3(-90.0f, 10.0f, 270.0f),
+  };
+
+  const smol::Vector3 position(1.0f, -2.0f, 3.0f);
+  const smol::Vector3 scale(2.0f, 1.0f, 0.5f);
+
+  for (const smol::Vector3& r : rotations)
+  {
+    smol::Quaternion q = smol::Quaternion::fromEuler(r);
+    SMOL_TEST_EXPECT_TRUE(fabsf(q.length() - 1.0f) < 0.0001f);
+    SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::fromTRS(position, q, scale), smol::Mat4::fromTRS(position, r, scale), 0.0001f));
+    SMOL_TEST_EXPECT_TRUE(matricesNear(smol::Mat4::initRotation(q), referenceRotation(r.x, r.y, r.z), 0.0001f));
+
+    // Back to Euler angles. They may differ from r but must describe the same rotation.
+    smol::Vector3 euler = q.toEuler();
+    SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::fromEuler(euler), q, 0.0001f));
+  }
+}
+
+SMOL_TEST(quaternion_rotate)
+{
+  smol::Quaternion a = smol::Quaternion::fromEuler(30.0f, 60.0f, -120.0f);
+  smol::Quaternion b = smol::Quaternion::fromAxisAngle(smol::Vector3(0.0f, 1.0f, 0.0f), 90.0f);
+  smol::Vector3 v(1.0f, 2.0f, 3.0f);
+
+  smol::Vector3 expected = smol::Mat4::mul(smol::Mat4::initRotation(a), v);
+  smol::Vector3 rotated = a.rotate(v);
+  SMOL_TEST_EXPECT_TRUE(fabsf(rotated.x - expected.x) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(rotated.y - expected.y) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(rotated.z - expected.z) < 0.0001f);
+
+  // 90 degrees around Y takes +X to -Z
+  rotated = b.rotate(smol::Vector3(1.0f, 0.0f, 0.0f));
+  SMOL_TEST_EXPECT_TRUE(fabsf(rotated.x) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(rotated.z + 1.0f) < 0.0001f);
+
+  // mul(a, b) rotates by b, then by a
+  smol::Vector3 composed = smol::Quaternion::mul(a, b).rotate(v);
+  expected = a.rotate(b.rotate(v));
+  SMOL_TEST_EXPECT_TRUE(fabsf(composed.x - expected.x) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(composed.y - expected.y) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(composed.z - expected.z) < 0.0001f);
+
+  // conjugated() undoes the rotation
+  smol::Vector3 back = a.conjugated().rotate(a.rotate(v));
+  SMOL_TEST_EXPECT_TRUE(fabsf(back.x - v.x) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(back.y - v.y) < 0.0001f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(back.z - v.z) < 0.0001f);
+}
+
+SMOL_TEST(quaternion_interpolation)
+{
+  const smol::Vector3 up(0.0f, 1.0f, 0.0f);
+  smol::Quaternion a = smol::Quaternion::identity();
+  smol::Quaternion b = smol::Quaternion::fromAxisAngle(up, 120.0f);
+
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::slerp(a, b, 0.0f), a, 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::slerp(a, b, 1.0f), b, 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::nlerp(a, b, 0.0f), a, 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::nlerp(a, b, 1.0f), b, 0.0001f));
+
+  // slerp has constant angular speed
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::slerp(a, b, 0.25f), smol::Quaternion::fromAxisAngle(up, 30.0f), 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::slerp(a, b, 0.5f), smol::Quaternion::fromAxisAngle(up, 60.0f), 0.0001f));
+
+  // nlerp is exact at the midpoint only
+  smol::Quaternion n = smol::Quaternion::nlerp(a, b, 0.5f);
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(n, smol::Quaternion::fromAxisAngle(up, 60.0f), 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(fabsf(n.length() - 1.0f) < 0.0001f);
+
+  // Interpolating towards -b must take the short way, same as towards b
+  smol::Quaternion negB(-b.x, -b.y, -b.z, -b.w);
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::slerp(a, negB, 0.5f), smol::Quaternion::fromAxisAngle(up, 60.0f), 0.0001f));
+  SMOL_TEST_EXPECT_TRUE(quaternionsNear(smol::Quaternion::nlerp(a, negB, 0.5f), smol::Quaternion::fromAxisAngle(up, 60.0f), 0.0001f));
+
+  // Nearly identical rotations
+  smol::Quaternion c = smol::Quaternion::fromAxisAngle(up, 0.01f);
+  smol::Quaternion s = smol::Quaternion::slerp(a, c, 0.5f);
+  SMOL_TEST_EXPECT_TRUE(fabsf(s.length() - 1.0f) < 0.0001f);
+}
@@ -0,0 +1,76 @@
+#include "smol_test.h"
+#include <smol/smol_pool_allocator.h>
+
+SMOL_TEST(block_sizes)
+{
+  SMOL_TEST_EXPECT_EQ(smol::PoolAllocator::getBlockSize(1), 64);
+  SMOL_TEST_EXPECT_EQ(smol::PoolAllocator::getBlockSize(64), 64);
+  SMOL_TEST_EXPECT_EQ(smol::PoolAllocator::getBlockSize(65), 128);
+  SMOL_TEST_EXPECT_EQ(smol::PoolAllocator::getBlockSize(KILOBYTE(16)), KILOBYTE(16));
+  SMOL_TEST_EXPECT_EQ(smol::PoolAllocator::getBlockSize(KILOBYTE(16) + 1), KILOBYTE(16) + 1);
+}
+
+SMOL_TEST(allocate_and_reuse)
+{
+  smol::PoolAllocator pool;
+  char* a = (char*) pool.getMemory(100);
+  char* b = (char*) pool.getMemory(100);
+  SMOL_TEST_EXPECT_NOT_NULL(a);
+  SMOL_TEST_EXPECT_NOT_NULL(b);
+  SMOL_TEST_EXPECT_NEQ(a, b);
+  SMOL_TEST_EXPECT_EQ(((uintptr_t) a) % SMOL_POOL_MIN_BLOCK_SIZE, 0);
+  a[127] = 1;
+
+  // The last freed block is the first one handed out again
+  pool.freeMemory(a, 100);
+  SMOL_TEST_EXPECT_EQ(pool.getMemory(120), a);
+
+  pool.freeMemory(a, 120);
+  pool.freeMemory(b, 100);
+  SMOL_TEST_EXPECT_EQ(pool.getStats().allocationCount, 0);
+}
+
+SMOL_TEST(large_allocations)
+{
+  smol::PoolAllocator pool;
+  void* memory = pool.getMemory(KILOBYTE(20));
+  SMOL_TEST_EXPECT_NOT_NULL(memory);
+
+  smol::PoolAllocatorStats stats = pool.getStats();
+  SMOL_TEST_EXPECT_EQ(stats.largeBytes, KILOBYTE(20));
+  SMOL_TEST_EXPECT_EQ(stats.chunkCount, 0);
+
+  pool.freeMemory(memory, KILOBYTE(20));
+  stats = pool.getStats();
+  SMOL_TEST_EXPECT_EQ(stats.largeBytes, 0);
+  SMOL_TEST_EXPECT_EQ(stats.peakLargeBytes, KILOBYTE(20));
+}
+
+SMOL_TEST(stats_and_fragmentation)
+{
+  smol::PoolAllocator pool;
+  const int count = 2000;
+  void* blocks[count];
+  for (int i = 0; i < count; i++)
+    blocks[i] = pool.getMemory(48);
+
+  smol::PoolAllocatorStats stats = pool.getStats();
+  SMOL_TEST_EXPECT_EQ(stats.allocationCount, count);
+  SMOL_TEST_EXPECT_EQ(stats.requestedBytes, count * 48);
+  SMOL_TEST_EXPECT_EQ(stats.usedBytes, count * 64);
+  SMOL_TEST_EXPECT_EQ(stats.sizeClass[0].blocksInUse, count);
+  SMOL_TEST_EXPECT_FLOAT_EQ(stats.internalFragmentation, 0.25f);
+
+  // Freeing every other block leaves holes in the chunks
+  for (int i = 0; i < count; i += 2)
+    pool.freeMemory(blocks[i], 48);
+
+  stats = pool.getStats();
+  SMOL_TEST_EXPECT_EQ(stats.peakUsedBytes, count * 64);
+  SMOL_TEST_EXPECT_EQ(stats.usedBytes, (count / 2) * 64);
+  SMOL_TEST_EXPECT_EQ(stats.sizeClass[0].peakBlocksInUse, count);
+  SMOL_TEST_EXPECT_GT(stats.externalFragmentation, 0.5f);
+
+  for (int i = 1; i < count; i += 2)
+    pool.freeMemory(blocks[i], 48);
+}
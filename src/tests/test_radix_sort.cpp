@@ -0,0 +1,191 @@
+#include "smol_test.h"
+#include <smol/smol_radix_sort.h>
+#include <smol/smol_job_system.h>
+#include <smol/smol_render_key.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+static const int TEST_WORKER_COUNT = 3;
+
+static uint64 nextRandom(uint64& state)
+{
+  // xorshift64
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+static std::vector<uint64> randomKeys(uint32 count, uint64 seed)
+{
+  std::vector<uint64> keys(count);
+  for (uint32 i = 0; i < count; i++)
+    keys[i] = nextRandom(seed);
+  return keys;
+}
+
+// Reference stable sort on the lowest keyBits bits
+static std::vector<uint64> referenceSort(std::vector<uint64> keys, uint32 keyBits)
+{
+  const uint64 mask = keyBits >= 64 ? ~0ULL : (1ULL << keyBits) - 1;
+  std::stable_sort(keys.begin(), keys.end(),
+      [mask](uint64 a, uint64 b) { return (a & mask) < (b & mask); });
+  return keys;
+}
+
+SMOL_TEST(sort_full_keys)
+{
+  std::vector<uint64> keys = randomKeys(10000, 42);
+  std::vector<uint64> temp(keys.size());
+  std::vector<uint64> expected = referenceSort(keys, 64);
+
+  uint64* sorted = smol::radixSort(keys.data(), temp.data(), (uint32) keys.size());
+  SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+}
+
+SMOL_TEST(sort_key_width)
+{
+  // Bits above keyBits are carried along and don't affect order
+  const uint32 widths[] = { 1, 12, 32, 40 };
+  for (uint32 keyBits : widths)
+  {
+    std::vector<uint64> keys = randomKeys(5000, 7 + keyBits);
+    std::vector<uint64> temp(keys.size());
+    std::vector<uint64> expected = referenceSort(keys, keyBits);
+
+    uint64* sorted = smol::radixSort(keys.data(), temp.data(), (uint32) keys.size(), keyBits);
+    SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+  }
+}
+
+SMOL_TEST(sort_edge_cases)
+{
+  uint64 temp[4];
+  uint64 one = 5;
+  SMOL_TEST_EXPECT_EQ(smol::radixSort(nullptr, nullptr, 0), (uint64*) nullptr);
+  SMOL_TEST_EXPECT_EQ(smol::radixSort(&one, temp, 1), &one);
+
+  // Every digit is constant so there is nothing to move
+  uint64 same[] = { 0xFF00FF00FF00FF00ULL, 0xFF00FF00FF00FF00ULL, 0xFF00FF00FF00FF00ULL, 0xFF00FF00FF00FF00ULL };
+  SMOL_TEST_EXPECT_EQ(smol::radixSort(same, temp, 4), same);
+
+  // Only the highest digit differs and it uses bucket 255
+  uint64 high[] = { 0xFF00000000000000ULL, 0x0100000000000000ULL, 0xFE00000000000000ULL, 0x0000000000000000ULL };
+  uint64* sorted = smol::radixSort(high, temp, 4);
+  SMOL_TEST_EXPECT_EQ(sorted[0], 0x0000000000000000ULL);
+  SMOL_TEST_EXPECT_EQ(sorted[1], 0x0100000000000000ULL);
+  SMOL_TEST_EXPECT_EQ(sorted[2], 0xFE00000000000000ULL);
+  SMOL_TEST_EXPECT_EQ(sorted[3], 0xFF00000000000000ULL);
+}
+
+SMOL_TEST(sort_parallel)
+{
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  jobSystem.initialize(TEST_WORKER_COUNT);
+
+  const uint32 widths[] = { 20, 32, 64 };
+  for (uint32 keyBits : widths)
+  {
+    std::vector<uint64> keys = randomKeys(300007, 99 + keyBits);
+    std::vector<uint64> temp(keys.size());
+    std::vector<uint64> expected = referenceSort(keys, keyBits);
+
+    uint64* sorted = smol::radixSortParallel(keys.data(), temp.data(), (uint32) keys.size(), keyBits);
+    SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+  }
+
+  jobSystem.shutdown();
+}
+
+// Sorted keys with a few of them nudged away from their place
+static std::vector<uint64> nearlySortedKeys(uint32 count, uint32 nudges, uint64 seed)
+{
+  std::vector<uint64> keys = randomKeys(count, seed);
+  std::sort(keys.begin(), keys.end());
+  for (uint32 i = 0; i < nudges; i++)
+  {
+    uint32 a = (uint32) (nextRandom(seed) % count);
+    uint32 b = a + (uint32) (nextRandom(seed) % 16);
+    if (b < count)
+      std::swap(keys[a], keys[b]);
+  }
+  return keys;
+}
+
+SMOL_TEST(adaptive_sort)
+{
+  // Already sorted input is left in place
+  std::vector<uint64> keys = nearlySortedKeys(10000, 0, 3);
+  std::vector<uint64> temp(keys.size());
+  SMOL_TEST_EXPECT_EQ(smol::adaptiveSort(keys.data(), temp.data(), (uint32) keys.size()), keys.data());
+
+  // Nearly sorted, random and narrow keys all end up sorted and stable
+  const uint32 nudges[] = { 10, 100, 5000 };
+  const uint32 widths[] = { 64, 32, 12 };
+  for (uint32 nudgeCount : nudges)
+  {
+    for (uint32 keyBits : widths)
+    {
+      keys = nearlySortedKeys(10000, nudgeCount, nudgeCount + keyBits);
+      std::vector<uint64> expected = referenceSort(keys, keyBits);
+      uint64* sorted = smol::adaptiveSort(keys.data(), temp.data(), (uint32) keys.size(), keyBits);
+      SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+    }
+  }
+
+  keys = randomKeys(10000, 11);
+  std::vector<uint64> expected = referenceSort(keys, 64);
+  uint64* sorted = smol::adaptiveSort(keys.data(), temp.data(), (uint32) keys.size());
+  SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+
+  // Few descents but keys far from their place
+  keys = nearlySortedKeys(10000, 0, 5);
+  std::rotate(keys.begin(), keys.begin() + 5000, keys.end());
+  expected = referenceSort(keys, 64);
+  sorted = smol::adaptiveSort(keys.data(), temp.data(), (uint32) keys.size());
+  SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+}
+
+SMOL_TEST(benchmark_radix_sort)
+{
+  const uint32 count = 1000000;
+  const std::vector<uint64> input = randomKeys(count, 1234);
+  std::vector<uint64> keys, temp(count);
+
+  auto elapsed = [](std::chrono::high_resolution_clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  };
+
+  keys = input;
+  auto start = std::chrono::high_resolution_clock::now();
+  std::sort(keys.begin(), keys.end());
+  double stdSortMs = elapsed(start);
+  std::vector<uint64> expected = keys;
+
+  keys = input;
+  start = std::chrono::high_resolution_clock::now();
+  uint64* sorted = smol::radixSort(keys.data(), temp.data(), count);
+  double radixMs = elapsed(start);
+  SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+
+  // Camera render keys only sort on their lower bits, the node index rides along
+  keys = input;
+  start = std::chrono::high_resolution_clock::now();
+  smol::radixSort(keys.data(), temp.data(), count, smol::CAMERA_RENDER_KEY_BITS);
+  double radixRenderKeyMs = elapsed(start);
+
+  smol::JobSystem& jobSystem = smol::JobSystem::get();
+  jobSystem.initialize();
+  keys = input;
+  start = std::chrono::high_resolution_clock::now();
+  sorted = smol::radixSortParallel(keys.data(), temp.data(), count);
+  double parallelMs = elapsed(start);
+  SMOL_TEST_EXPECT_TRUE(std::equal(expected.begin(), expected.end(), sorted));
+
+  printf("\n\t%d keys: std::sort %.2f ms, radixSort %.2f ms, radixSort %u bits %.2f ms, radixSortParallel (%d workers) %.2f ms\n",
+      count, stdSortMs, radixMs, smol::CAMERA_RENDER_KEY_BITS, radixRenderKeyMs, jobSystem.getWorkerCount(), parallelMs);
+  jobSystem.shutdown();
+}
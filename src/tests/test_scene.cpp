@@ -0,0 +1,527 @@
+#include "smol_test.h"
+#include <smol/smol_scene.h>
+#include <smol/smol_frame_allocator.h>
+#include <smol/smol_job_system.h>
+#include <smol/smol_bounds.h>
+#include <smol/smol_mesh.h>
+#include <smol/smol_renderable.h>
+#include <smol/smol_render_key.h>
+#include <smol/smol_radix_sort.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static bool matricesEqual(const smol::Mat4& a, const smol::Mat4& b)
+{
+  for (int i = 0; i < 4; i++)
+    for (int j = 0; j < 4; j++)
+      if (fabs(a.e[i][j] - b.e[i][j]) > 0.0001f)
+        return false;
+  return true;
+}
+
+SMOL_TEST(update_transforms_parent_created_after_child)
+{
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  // The child comes first in the node list so a plain linear update would use a stale parent matrix
+  smol::Handle<smol::SceneNode> child = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(1.0f, 0.0f, 0.0f)));
+  smol::Handle<smol::SceneNode> parent = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(0.0f, 2.0f, 0.0f)));
+  smol::Handle<smol::SceneNode> root = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(0.0f, 0.0f, 3.0f)));
+  child->setParent(parent);
+  parent->setParent(root);
+
+  const uint8* state = scene.updateTransforms();
+  for (int i = 0; i < 3; i++)
+    SMOL_TEST_EXPECT_EQ(state[i], smol::Scene::NODE_ACTIVE | smol::Scene::NODE_TRANSFORM_CHANGED);
+
+  smol::Mat4 expected = smol::Mat4::initTranslation(1.0f, 2.0f, 3.0f);
+  SMOL_TEST_EXPECT_TRUE(matricesEqual(child->transform.getMatrix(), expected));
+
+  // Nothing changed
+  state = scene.updateTransforms();
+  for (int i = 0; i < 3; i++)
+    SMOL_TEST_EXPECT_EQ(state[i], smol::Scene::NODE_ACTIVE);
+
+  // Moving the root changes the whole hierarchy
+  root->transform.setPosition(0.0f, 0.0f, 5.0f);
+  state = scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(state[0], smol::Scene::NODE_ACTIVE | smol::Scene::NODE_TRANSFORM_CHANGED);
+  SMOL_TEST_EXPECT_TRUE(matricesEqual(child->transform.getMatrix(), smol::Mat4::initTranslation(1.0f, 2.0f, 5.0f)));
+
+  // Deactivating the parent deactivates the child
+  parent->setActive(false);
+  state = scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(state[0], 0);
+  SMOL_TEST_EXPECT_EQ(state[1], 0);
+  SMOL_TEST_EXPECT_EQ(state[2], smol::Scene::NODE_ACTIVE);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+}
+
+SMOL_TEST(update_transforms_benchmark)
+{
+  // 100k nodes in a tree where every node has up to 2 children (depth 16)
+  const int numNodes = 100000;
+  const int numFrames = 5;
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  std::vector<smol::Handle<smol::SceneNode>> handles(numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    smol::Transform transform(smol::Vector3(0.1f, 0.2f, 0.3f), smol::Vector3(0.0f, 1.0f, 0.0f));
+    if (i > 0)
+      transform.setParent(handles[(i - 1) / 2]);
+    handles[i] = scene.createNode(smol::SceneNode::MESH, transform);
+  }
+
+  uint32 count;
+  smol::SceneNode* allNodes = (smol::SceneNode*) scene.getNodes(&count);
+  SMOL_TEST_EXPECT_EQ((int) count, numNodes);
+
+  // Per node recursive update. Moving the root makes every node dirty.
+  auto start = std::chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    allNodes[0].transform.setPosition((float) frame, 0.0f, 0.0f);
+    for (int i = 0; i < numNodes; i++)
+      allNodes[i].transform.update(scene);
+    for (int i = 0; i < numNodes; i++)
+      allNodes[i].transform.setDirty(false);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  double recursiveMs = std::chrono::duration<double, std::milli>(end - start).count() / numFrames;
+  smol::Mat4 recursiveResult = allNodes[numNodes - 1].transform.getMatrix();
+
+  // Single linear pass
+  start = std::chrono::high_resolution_clock::now();
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    smol::FrameAllocator::get().beginFrame();
+    allNodes[0].transform.setPosition((float) frame, 0.0f, 0.0f);
+    scene.updateTransforms();
+  }
+  end = std::chrono::high_resolution_clock::now();
+  double linearMs = std::chrono::duration<double, std::milli>(end - start).count() / numFrames;
+
+  SMOL_TEST_EXPECT_TRUE(matricesEqual(allNodes[numNodes - 1].transform.getMatrix(), recursiveResult));
+  printf("\n\t%d nodes: recursive update %.2f ms/frame, linear update %.2f ms/frame (%.1fx)\n",
+      numNodes, recursiveMs, linearMs, recursiveMs / linearMs);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+}
+
+SMOL_TEST(update_transforms_parallel)
+{
+  // Wide and deep enough that every level is split across several jobs
+  const int numNodes = 60000;
+  const int numFrames = 5;
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  std::vector<smol::Handle<smol::SceneNode>> handles(numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    smol::Transform transform(smol::Vector3(0.1f, 0.2f, 0.3f), smol::Vector3(0.0f, 1.0f, 0.0f));
+    if (i > 0)
+      transform.setParent(handles[(i - 1) / 4]);
+    handles[i] = scene.createNode(smol::SceneNode::MESH, transform);
+  }
+
+  uint32 count;
+  smol::SceneNode* allNodes = (smol::SceneNode*) scene.getNodes(&count);
+  handles[7]->setActive(false);
+
+  // Serial reference
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    smol::FrameAllocator::get().beginFrame();
+    allNodes[0].transform.setPosition((float) frame, 0.0f, 0.0f);
+    scene.updateTransforms();
+  }
+
+  std::vector<smol::Mat4> serialMatrices(numNodes);
+  for (int i = 0; i < numNodes; i++)
+    serialMatrices[i] = allNodes[i].transform.getMatrix();
+
+  smol::JobSystem::get().initialize(3);
+  const uint8* state = nullptr;
+  for (int frame = 0; frame < numFrames; frame++)
+  {
+    smol::FrameAllocator::get().beginFrame();
+    allNodes[0].transform.setPosition((float) (numFrames - 1 - frame), 0.0f, 0.0f);
+    state = scene.updateTransforms();
+  }
+  smol::JobSystem::get().shutdown();
+
+  // The last frame of both runs put the root in a different place
+  int mismatches = 0;
+  int changed = 0;
+  for (int i = 0; i < numNodes; i++)
+  {
+    if (state[i] & smol::Scene::NODE_TRANSFORM_CHANGED)
+      changed++;
+    else if (!matricesEqual(allNodes[i].transform.getMatrix(), serialMatrices[i]))
+      mismatches++;
+  }
+  SMOL_TEST_EXPECT_EQ(mismatches, 0);
+  SMOL_TEST_EXPECT_TRUE(changed > 0 && changed < numNodes);
+  SMOL_TEST_EXPECT_EQ(state[7], 0);
+
+  // Same position as the serial run
+  smol::FrameAllocator::get().beginFrame();
+  allNodes[0].transform.setPosition((float) (numFrames - 1), 0.0f, 0.0f);
+  scene.updateTransforms();
+  for (int i = 0; i < numNodes; i++)
+  {
+    if (!matricesEqual(allNodes[i].transform.getMatrix(), serialMatrices[i]))
+      mismatches++;
+  }
+  SMOL_TEST_EXPECT_EQ(mismatches, 0);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+}
+
+SMOL_TEST(spatial_queries)
+{
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  smol::HandleList<smol::Mesh> meshes(4);
+  smol::Mesh mesh = {};
+  mesh.boundingBox = smol::AABB(smol::Vector3(-0.5f), smol::Vector3(0.5f));
+  smol::Handle<smol::Mesh> meshHandle = meshes.add(mesh);
+  smol::Handle<smol::Renderable> renderable = scene.createRenderable(INVALID_HANDLE(smol::Material), meshHandle);
+
+  // A row of unit cubes, one every 2 units along x
+  const int numNodes = 100;
+  std::vector<smol::Handle<smol::SceneNode>> handles(numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    handles[i] = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(i * 2.0f, 0.0f, 0.0f)));
+    handles[i]->mesh.renderable = renderable;
+  }
+  scene.updateTransforms();
+
+  smol::Handle<smol::SceneNode> results[numNodes];
+  const smol::AABB box(smol::Vector3(9.0f, -1.0f, -1.0f), smol::Vector3(13.0f, 1.0f, 1.0f));
+  int32 count = scene.queryNodes(box, results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 2);
+  SMOL_TEST_EXPECT_TRUE((results[0] == handles[5] && results[1] == handles[6]) || (results[0] == handles[6] && results[1] == handles[5]));
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(box, results, 1), 1);
+
+  // Orthographic camera 10 units away covering x from -5 to 5
+  const smol::Mat4 view = smol::Mat4::initTranslation(0.0f, 0.0f, -10.0f);
+  const smol::Frustum frustum = smol::Frustum::fromMatrix(
+      smol::Mat4::mul(smol::Mat4::ortho(-5.0f, 5.0f, 5.0f, -5.0f, 0.1f, 100.0f), view));
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(frustum, results, numNodes), 3);
+
+  count = scene.queryNearestNodes(smol::Vector3(20.2f, 0.0f, 0.0f), 3, results);
+  SMOL_TEST_EXPECT_EQ(count, 3);
+  SMOL_TEST_EXPECT_TRUE(results[0] == handles[10]);
+  SMOL_TEST_EXPECT_TRUE(results[1] == handles[11]);
+  SMOL_TEST_EXPECT_TRUE(results[2] == handles[9]);
+
+  // Moved nodes move on the index
+  smol::FrameAllocator::get().beginFrame();
+  handles[0]->transform.setPosition(500.0f, 0.0f, 0.0f);
+  scene.updateTransforms();
+  count = scene.queryNodes(smol::AABB(smol::Vector3(499.0f, -1.0f, -1.0f), smol::Vector3(501.0f, 1.0f, 1.0f)), results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 1);
+  SMOL_TEST_EXPECT_TRUE(results[0] == handles[0]);
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(frustum, results, numNodes), 2);
+
+  // Inactive and destroyed nodes leave the index
+  smol::FrameAllocator::get().beginFrame();
+  handles[5]->setActive(false);
+  scene.destroyNode(handles[6]);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(box, results, numNodes), 0);
+
+  handles[5]->setActive(true);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(box, results, numNodes), 1);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+  smol::Handle<smol::Mesh>::registerList(nullptr);
+}
+
+SMOL_TEST(sprite_queries)
+{
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  // A grid of 1x1 sprites, one every 2 units. Sprite quads go right and down
+  // from the node position.
+  const int gridSize = 50;
+  const int numNodes = gridSize * gridSize;
+  std::vector<smol::Handle<smol::SceneNode>> handles(numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    const smol::Vector3 position((i % gridSize) * 2.0f, (i / gridSize) * 2.0f, 0.0f);
+    handles[i] = scene.createNode(smol::SceneNode::SPRITE, smol::Transform(position));
+    handles[i]->sprite.node = handles[i];
+    handles[i]->sprite.width = 1.0f;
+    handles[i]->sprite.height = 1.0f;
+  }
+  scene.updateTransforms();
+
+  smol::Handle<smol::SceneNode> results[numNodes];
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(smol::Rectf(-100.0f, -100.0f, 1000.0f, 1000.0f), results, numNodes), numNodes);
+
+  // Covers the quads of the nodes at x = 10 and 12 on the row at y = 4
+  const smol::Rectf rect(9.5f, 3.5f, 3.0f, 0.2f);
+  int32 count = scene.queryNodes(rect, results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 2);
+  SMOL_TEST_EXPECT_TRUE((results[0] == handles[105] && results[1] == handles[106]) || (results[0] == handles[106] && results[1] == handles[105]));
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(rect, results, 1), 1);
+
+  // Nothing between the rows
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(smol::Rectf(0.0f, 4.2f, 100.0f, 0.5f), results, numNodes), 0);
+
+  // Scaled and moved nodes move on the index
+  smol::FrameAllocator::get().beginFrame();
+  handles[0]->transform.setPosition(500.0f, 500.0f, 0.0f);
+  handles[1]->transform.setScale(10.0f, 10.0f, 1.0f);
+  scene.updateTransforms();
+  count = scene.queryNodes(smol::Rectf(505.0f, 495.0f, 1.0f, 1.0f), results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 0);
+  count = scene.queryNodes(smol::Rectf(500.5f, 499.5f, 0.1f, 0.1f), results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 1);
+  SMOL_TEST_EXPECT_TRUE(results[0] == handles[0]);
+  count = scene.queryNodes(smol::Rectf(11.0f, -9.0f, 0.1f, 0.1f), results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 1);
+  SMOL_TEST_EXPECT_TRUE(results[0] == handles[1]);
+
+  // So do resized ones
+  const smol::Rectf resizedRect(43.5f, -3.0f, 0.1f, 0.1f);
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(resizedRect, results, numNodes), 0);
+  smol::FrameAllocator::get().beginFrame();
+  handles[20]->sprite.setSize(4.0f, 4.0f);
+  scene.updateTransforms();
+  count = scene.queryNodes(resizedRect, results, numNodes);
+  SMOL_TEST_EXPECT_EQ(count, 1);
+  SMOL_TEST_EXPECT_TRUE(results[0] == handles[20]);
+
+  // Inactive and destroyed nodes leave the index
+  smol::FrameAllocator::get().beginFrame();
+  handles[105]->setActive(false);
+  scene.destroyNode(handles[106]);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(rect, results, numNodes), 0);
+
+  handles[105]->setActive(true);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(scene.queryNodes(rect, results, numNodes), 1);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+}
+
+SMOL_TEST(render_keys_without_workers)
+{
+  // More nodes than fit in a job batch, all on the calling thread. Only
+  // cameras get keys as inactive nodes are skipped.
+  const int numNodes = 3000;
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  for (int i = 0; i < numNodes; i++)
+  {
+    if (i % 7 == 0)
+      scene.createNode(smol::SceneNode::CAMERA, smol::Transform());
+    else
+      scene.createNode(smol::SceneNode::MESH, smol::Transform())->setActive(false);
+  }
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    // Garbage in frame memory must not leak into the keys
+    smol::FrameAllocator::get().beginFrame();
+    memset(smol::FrameAllocator::get().push<uint8>(numNodes * 16), 0xFF, numNodes * 16);
+    smol::FrameAllocator::get().beginFrame();
+
+    // The second pass appends nodes after the ones that already have keys
+    if (pass == 1)
+      scene.createNode(smol::SceneNode::CAMERA, smol::Transform());
+
+    SMOL_TEST_EXPECT_TRUE(scene.updateRenderQueue(scene.updateTransforms()));
+
+    int32 count;
+    scene.getRenderKeys(&count);
+    SMOL_TEST_EXPECT_EQ(count, 0);
+
+    const uint64* cameraKeys = scene.getCameraRenderKeys(&count);
+    SMOL_TEST_EXPECT_EQ(count, (numNodes + 6) / 7 + pass);
+    bool inNodeOrder = true;
+    for (int32 i = 0; i < count; i++)
+      inNodeOrder &= (int32) (cameraKeys[i] >> 32) == (i * 7 < numNodes ? i * 7 : numNodes);
+    SMOL_TEST_EXPECT_TRUE(inNodeOrder);
+  }
+
+  smol::FrameAllocator::get().beginFrame();
+  SMOL_TEST_EXPECT_FALSE(scene.updateRenderQueue(scene.updateTransforms()));
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+}
+
+// Sprites and text on one batcher share material and queue. Their keys must
+// not interleave, as the batcher draws its sprites from consecutive keys.
+SMOL_TEST(sprite_and_text_render_keys)
+{
+  const uint8 queues[] = { smol::RenderQueue::QUEUE_OPAQUE, smol::RenderQueue::QUEUE_TRANSPARENT };
+  const uint16 materialRank = 5;
+
+  for (int q = 0; q < 2; q++)
+  {
+    // Node index % 3 tells the type: sprite, text or a mesh as near or as far as meshes go
+    std::vector<uint64> keys;
+    for (uint32 i = 0; i < 30; i++)
+    {
+      if (i % 3 == 0)
+        keys.push_back(smol::encodeBatchedCameraRenderKey(smol::SceneNode::SPRITE, i, queues[q], materialRank));
+      else if (i % 3 == 1)
+        keys.push_back(smol::encodeBatchedCameraRenderKey(smol::SceneNode::TEXT, i, queues[q], materialRank));
+      else
+        keys.push_back(smol::encodeCameraRenderKey(i, queues[q], materialRank, (i % 2) ? smol::RENDER_KEY_MAX_DEPTH : 0));
+    }
+
+    std::vector<uint64> temp(keys.size());
+    const uint64* sorted = smol::radixSort(keys.data(), temp.data(), (uint32) keys.size(), smol::CAMERA_RENDER_KEY_BITS);
+
+    int runs[3] = {};
+    int lastType = -1;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      const int type = smol::getNodeIndexFromCameraRenderKey(sorted[i]) % 3;
+      if (type != lastType)
+        runs[type]++;
+      lastType = type;
+      SMOL_TEST_EXPECT_EQ(smol::getMaterialRankFromCameraRenderKey(sorted[i]), (uint32) materialRank);
+    }
+
+    SMOL_TEST_EXPECT_EQ(runs[0], 1);
+    SMOL_TEST_EXPECT_EQ(runs[1], 1);
+  }
+}
+
+// A mesh with a single triangle covering half of the unit quad on the XY plane
+static smol::Vector3 trianglePositions[] = { smol::Vector3(0.0f), smol::Vector3(1.0f, 0.0f, 0.0f), smol::Vector3(0.0f, 1.0f, 0.0f) };
+static unsigned int triangleIndices[] = { 0, 1, 2 };
+
+static smol::Mesh createTriangleMesh()
+{
+  smol::Mesh mesh = {};
+  mesh.boundingBox = smol::AABB(smol::Vector3(0.0f), smol::Vector3(1.0f, 1.0f, 0.0f));
+  mesh.positions = trianglePositions;
+  mesh.indices = triangleIndices;
+  mesh.numVertices = 3;
+  mesh.numIndices = 3;
+  return mesh;
+}
+
+SMOL_TEST(raycast)
+{
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  smol::HandleList<smol::Mesh> meshes(4);
+  smol::Handle<smol::Renderable> renderable = scene.createRenderable(INVALID_HANDLE(smol::Material), meshes.add(createTriangleMesh()));
+
+  // Triangles facing +Z, one every 2 units going away from the ray origin
+  const int numNodes = 10;
+  std::vector<smol::Handle<smol::SceneNode>> handles(numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    handles[i] = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(0.0f, 0.0f, i * -2.0f)));
+    handles[i]->mesh.renderable = renderable;
+  }
+  scene.updateTransforms();
+
+  const uint32 allLayers = 0xFFFFFFFF;
+  const smol::Ray ray(smol::Vector3(0.2f, 0.2f, 10.0f), smol::Vector3(0.0f, 0.0f, -1.0f));
+  smol::RaycastHit hits[numNodes];
+  SMOL_TEST_EXPECT_EQ(scene.raycast(ray, allLayers, hits, numNodes), numNodes);
+  for (int i = 0; i < numNodes; i++)
+  {
+    SMOL_TEST_EXPECT_TRUE(hits[i].node == handles[i]);
+    SMOL_TEST_EXPECT_TRUE(fabsf(hits[i].distance - (10.0f + i * 2.0f)) < 0.0001f);
+    SMOL_TEST_EXPECT_EQ(hits[i].triangle, 0);
+  }
+  SMOL_TEST_EXPECT_TRUE(fabsf(hits[3].point.z + 6.0f) < 0.0001f);
+
+  // Only the closest hits are kept
+  SMOL_TEST_EXPECT_EQ(scene.raycast(ray, allLayers, hits, 3), 3);
+  SMOL_TEST_EXPECT_TRUE(hits[0].node == handles[0] && hits[1].node == handles[1] && hits[2].node == handles[2]);
+  SMOL_TEST_EXPECT_EQ(scene.raycast(ray, allLayers, hits, numNodes, 13.0f), 2);
+
+  // Inside the bounds but outside the triangle
+  const smol::Ray missRay(smol::Vector3(0.9f, 0.9f, 10.0f), smol::Vector3(0.0f, 0.0f, -1.0f));
+  SMOL_TEST_EXPECT_EQ(scene.raycast(missRay, allLayers, hits, numNodes), 0);
+  SMOL_TEST_EXPECT_EQ(scene.raycast(missRay, allLayers, hits, 1, FLT_MAX, false), 1);
+  SMOL_TEST_EXPECT_EQ(hits[0].triangle, -1);
+
+  // Layers filter nodes and rays are tested in mesh space
+  smol::FrameAllocator::get().beginFrame();
+  handles[0]->setLayer(smol::Layer::LAYER_1);
+  handles[numNodes - 1]->transform.setScale(4.0f, 4.0f, 1.0f);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_EQ(scene.raycast(ray, smol::Layer::LAYER_1, hits, numNodes), 1);
+  SMOL_TEST_EXPECT_EQ(scene.raycast(ray, ~(uint32) smol::Layer::LAYER_1, hits, 1), 1);
+  SMOL_TEST_EXPECT_TRUE(hits[0].node == handles[1]);
+  const smol::Ray scaledRay(smol::Vector3(1.5f, 1.5f, 10.0f), smol::Vector3(0.0f, 0.0f, -1.0f));
+  SMOL_TEST_EXPECT_EQ(scene.raycast(scaledRay, allLayers, hits, numNodes), 1);
+  SMOL_TEST_EXPECT_TRUE(hits[0].node == handles[numNodes - 1]);
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+  smol::Handle<smol::Mesh>::registerList(nullptr);
+}
+
+SMOL_TEST(pick)
+{
+  smol::FrameAllocator::get().beginFrame();
+  smol::Scene scene;
+
+  smol::HandleList<smol::Mesh> meshes(4);
+  smol::Handle<smol::Renderable> renderable = scene.createRenderable(INVALID_HANDLE(smol::Material), meshes.add(createTriangleMesh()));
+
+  // The triangle covers the center of the screen, another one sits past the far plane
+  smol::Handle<smol::SceneNode> near = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(-0.25f, -0.25f, 0.0f)));
+  near->mesh.renderable = renderable;
+  smol::Handle<smol::SceneNode> far = scene.createNode(smol::SceneNode::MESH, smol::Transform(smol::Vector3(-0.25f, -0.25f, -200.0f), smol::Vector3(0.0f), smol::Vector3(500.0f)));
+  far->mesh.renderable = renderable;
+
+  smol::Handle<smol::SceneNode> camera = scene.createNode(smol::SceneNode::CAMERA, smol::Transform(smol::Vector3(0.0f, 0.0f, 10.0f)));
+  camera->camera.setViewportRect(smol::Rectf(0.0f, 0.0f, 1.0f, 1.0f)).setLayerMask(smol::Layer::LAYER_0).setPerspective(60.0f, 0.1f, 100.0f);
+  scene.updateTransforms();
+  camera->camera.updateView(camera->transform.getMatrix(), true);
+
+  // The stub display is 800x600
+  smol::RaycastHit hit;
+  SMOL_TEST_EXPECT_TRUE(scene.pick(smol::Point2{400, 300}, camera, &hit) == near);
+  SMOL_TEST_EXPECT_TRUE(fabsf(hit.point.z) < 0.0001f);
+
+  near->setActive(false);
+  scene.updateTransforms();
+  SMOL_TEST_EXPECT_TRUE(scene.pick(smol::Point2{400, 300}, camera) == INVALID_HANDLE(smol::SceneNode));
+
+  smol::Handle<smol::SceneNode>::registerList(nullptr);
+  smol::Handle<smol::Mesh>::registerList(nullptr);
+}
+
+SMOL_TEST(camera_projection_after_resize)
+{
+  smol::Camera camera;
+  camera.setPerspective(60.0f, 0.1f, 100.0f);
+  const smol::Mat4 worldMatrix = smol::Mat4::initIdentity();
+  SMOL_TEST_EXPECT_TRUE(camera.updateView(worldMatrix, true));
+  SMOL_TEST_EXPECT_FALSE(camera.updateView(worldMatrix, false));
+
+  // Cameras that were not rendered when the display was resized still catch up
+  smol::Camera::displayResized();
+  smol::Camera::displayResized();
+  SMOL_TEST_EXPECT_TRUE(camera.updateView(worldMatrix, false));
+  SMOL_TEST_EXPECT_FALSE(camera.updateView(worldMatrix, false));
+}
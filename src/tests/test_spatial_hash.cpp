@@ -0,0 +1,169 @@
+#include "smol_test.h"
+#include <smol/smol_spatial_hash.h>
+#include <algorithm>
+#include <vector>
+
+using smol::Rectf;
+using smol::SpatialHash;
+
+static uint64 nextRandom(uint64& state)
+{
+  // xorshift64
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+static float randomFloat(uint64& state, float min, float max)
+{
+  return min + (max - min) * (float) (nextRandom(state) % 100000) / 100000.0f;
+}
+
+static Rectf randomRect(uint64& state, float worldSize)
+{
+  const float size = randomFloat(state, 0.1f, 3.0f);
+  return Rectf(randomFloat(state, -worldSize, worldSize), randomFloat(state, -worldSize, worldSize), size, size);
+}
+
+static bool overlaps(const Rectf& a, const Rectf& b)
+{
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h && b.y <= a.y + a.h;
+}
+
+// Objects of the tests. Index is the proxy user data.
+struct TestObjects
+{
+  std::vector<Rectf> rects;
+  std::vector<int32> proxies;     // -1 when not on the hash
+};
+
+static bool collect(uint64 userData, void* context)
+{
+  ((std::vector<uint64>*) context)->push_back(userData);
+  return true;
+}
+
+static std::vector<uint64> sorted(std::vector<uint64> values)
+{
+  std::sort(values.begin(), values.end());
+  return values;
+}
+
+static std::vector<uint64> bruteForce(const TestObjects& objects, const Rectf& rect)
+{
+  std::vector<uint64> result;
+  for (size_t i = 0; i < objects.rects.size(); i++)
+  {
+    if (objects.proxies[i] >= 0 && overlaps(objects.rects[i], rect))
+      result.push_back((uint64) i);
+  }
+  return result;
+}
+
+// Populates the hash, moves some objects, removes others and adds a few
+// objects large enough to go to the large list
+static void buildTestHash(SpatialHash& hash, TestObjects& objects, int count, uint64 seed)
+{
+  objects.rects.resize(count);
+  objects.proxies.resize(count);
+  for (int i = 0; i < count; i++)
+  {
+    objects.rects[i] = (i % 500) ? randomRect(seed, 200.0f) : Rectf(randomFloat(seed, -200.0f, 200.0f), 0.0f, 60.0f, 30.0f);
+    objects.proxies[i] = hash.insert(objects.rects[i], (uint64) i);
+  }
+
+  for (int i = 0; i < count; i += 3)
+  {
+    // Small moves stay on the same cells, large ones don't
+    const float offset = (i % 2) ? 0.01f : randomFloat(seed, -30.0f, 30.0f);
+    Rectf& rect = objects.rects[i];
+    rect.x += offset;
+    rect.y -= offset;
+    hash.update(objects.proxies[i], rect);
+  }
+
+  for (int i = 0; i < count; i += 7)
+  {
+    hash.remove(objects.proxies[i]);
+    objects.proxies[i] = -1;
+  }
+}
+
+SMOL_TEST(insert_update_remove)
+{
+  SpatialHash hash(4.0f);
+  SMOL_TEST_EXPECT_EQ(hash.getProxyCount(), 0);
+
+  Rectf rect(0.5f, 0.5f, 1.0f, 1.0f);
+  int32 proxy = hash.insert(rect, 42);
+  SMOL_TEST_EXPECT_EQ(hash.getProxyCount(), 1);
+  SMOL_TEST_EXPECT_EQ(hash.getUserData(proxy), (uint64) 42);
+
+  // Moving inside the same cell only stores the rect
+  SMOL_TEST_EXPECT_FALSE(hash.update(proxy, Rectf(1.0f, 1.0f, 1.0f, 1.0f)));
+  SMOL_TEST_EXPECT_TRUE(hash.getRect(proxy).x == 1.0f);
+  SMOL_TEST_EXPECT_TRUE(hash.update(proxy, Rectf(-10.0f, 10.0f, 1.0f, 1.0f)));
+
+  std::vector<uint64> found;
+  hash.query(Rectf(-12.0f, 9.0f, 4.0f, 4.0f), collect, &found);
+  SMOL_TEST_EXPECT_EQ(found.size(), (size_t) 1);
+  found.clear();
+  hash.query(Rectf(0.0f, 0.0f, 4.0f, 4.0f), collect, &found);
+  SMOL_TEST_EXPECT_EQ(found.size(), (size_t) 0);
+
+  hash.remove(proxy);
+  SMOL_TEST_EXPECT_EQ(hash.getProxyCount(), 0);
+  hash.query(Rectf(-12.0f, 9.0f, 4.0f, 4.0f), collect, &found);
+  SMOL_TEST_EXPECT_EQ(found.size(), (size_t) 0);
+
+  // Freed proxies are reused
+  SMOL_TEST_EXPECT_EQ(hash.insert(rect, 7), proxy);
+  hash.reset();
+  SMOL_TEST_EXPECT_EQ(hash.getProxyCount(), 0);
+}
+
+SMOL_TEST(query_reports_once)
+{
+  SpatialHash hash(1.0f);
+
+  // Spans a few cells, then grows enough to go to the large list and back
+  const int32 proxy = hash.insert(Rectf(0.5f, 0.5f, 2.0f, 2.0f), 1);
+  hash.insert(Rectf(-5.0f, -5.0f, 0.5f, 0.5f), 2);
+
+  std::vector<uint64> found;
+  hash.query(Rectf(0.0f, 0.0f, 3.0f, 3.0f), collect, &found);
+  SMOL_TEST_EXPECT_TRUE(found == std::vector<uint64>{1});
+
+  hash.update(proxy, Rectf(-10.0f, -10.0f, 20.0f, 20.0f));
+  found.clear();
+  hash.query(Rectf(0.0f, 0.0f, 3.0f, 3.0f), collect, &found);
+  SMOL_TEST_EXPECT_TRUE(found == std::vector<uint64>{1});
+  found.clear();
+  hash.query(Rectf(-6.0f, -6.0f, 20.0f, 20.0f), collect, &found);
+  SMOL_TEST_EXPECT_TRUE(sorted(found) == (std::vector<uint64>{1, 2}));
+
+  hash.update(proxy, Rectf(0.5f, 0.5f, 2.0f, 2.0f));
+  found.clear();
+  hash.query(Rectf(-6.0f, -6.0f, 3.0f, 3.0f), collect, &found);
+  SMOL_TEST_EXPECT_TRUE(found == std::vector<uint64>{2});
+}
+
+SMOL_TEST(query_rect)
+{
+  SpatialHash hash;
+  TestObjects objects;
+  buildTestHash(hash, objects, 20000, 3);
+
+  uint64 seed = 11;
+  for (int i = 0; i < 100; i++)
+  {
+    // From rects smaller than a cell up to larger than the whole world
+    const float size = (i % 10 == 0) ? 1000.0f : randomFloat(seed, 0.5f, 60.0f);
+    const Rectf rect(randomFloat(seed, -220.0f, 220.0f), randomFloat(seed, -220.0f, 220.0f), size, size);
+
+    std::vector<uint64> found;
+    hash.query(rect, collect, &found);
+    SMOL_TEST_EXPECT_TRUE(sorted(found) == bruteForce(objects, rect));
+  }
+}
@@ -12,6 +12,7 @@
 #include <ShellScalingAPI.h>
 #include <cstdio>
 #include <stdlib.h>
+#include <malloc.h>
 #include <time.h>
 #include <shlwapi.h>
 #include <Commdlg.h>
@@ -80,6 +81,18 @@ namespace smol
     HMODULE handle;
   };
 
+  struct Thread
+  {
+    HANDLE handle;
+    Platform::ThreadFunction function;
+    void* data;
+  };
+
+  struct Semaphore
+  {
+    HANDLE handle;
+  };
+
   //
   // A Global structure for storing information about the currently used rendering API
   //
@@ -700,7 +713,7 @@ namespace smol
     ShowCursor(status);
   }
 
-  char* Platform::loadFileToBuffer(const char* fileName, size_t* loadedFileSize, size_t extraBytes, size_t offset)
+  char* Platform::loadFileToBuffer(const char* fileName, size_t* loadedFileSize, size_t extraBytes, size_t offset, MemoryTag tag)
   {
     FILE* fd = fopen(fileName, "rb");
 
@@ -715,13 +728,11 @@ namespace smol
     fseek(fd, 0, SEEK_SET);
 
     const size_t totalBufferSize = fileSize + extraBytes;
-    //TODO(marcio): Use our custom memory manager here
-    char* buffer = new char[totalBufferSize];
+    char* buffer = (char*) Platform::getMemory(totalBufferSize, 0, tag);
     if(! fread(buffer + offset, fileSize, 1, fd))
     {
       smol::Log::error("Failed to read from file '%s'", fileName);
-      //TODO(marcio): Use our custom memory manager here
-      delete[] buffer;
+      Platform::freeMemory(buffer);
       buffer = nullptr;
     }
 
@@ -745,8 +756,7 @@ namespace smol
 
   void Platform::unloadFileBuffer(const char* fileBuffer)
   {
-    //TODO(marcio): Use our custom memory manager here
-    delete[] fileBuffer;
+    Platform::freeMemory((void*) fileBuffer);
   }
 
   const char* Platform::getBinaryPath()
@@ -754,23 +764,240 @@ namespace smol
     return internal.binaryPath;
   }
 
-  void* Platform::getMemory(size_t size)
+  // Every block is allocated with _aligned_malloc() so callers can ask for
+  // any power of two alignment. Blocks are at least 16 byte aligned, just
+  // like malloc() would return.
+  //
+  // Blocks carry a small header used for memory tracking. The header and the
+  // padding before it take exactly 'alignment' bytes so the memory returned
+  // to the caller keeps the requested alignment.
+  // ------------------------------------------------
+  //| padding | MemoryBlockHeader | memory ...       |
+  // ------------------------------------------------
+  constexpr size_t SMOL_MEMORY_MIN_ALIGNMENT = 16;
+
+  struct MemoryBlockHeader
+  {
+    size_t size;
+    uint32 alignment;
+    MemoryTag tag;
+  };
+
+  static_assert(sizeof(MemoryBlockHeader) <= SMOL_MEMORY_MIN_ALIGNMENT, "MemoryBlockHeader must fit in the minimum alignment");
+
+  // The last entry holds the totals for all tags.
+  // This is plain data so it's ready before any static constructor allocates memory.
+  // A zeroed SRWLOCK is a valid unlocked lock, so that holds for the lock too.
+  static struct MemoryTracking
+  {
+    SRWLOCK lock;   // memory can be allocated from job threads
+    MemoryStats stats[(int) MemoryTag::COUNT + 1];
+    uint32 frameAllocations[(int) MemoryTag::COUNT + 1];
+    size_t frameBytes[(int) MemoryTag::COUNT + 1];
+  } memoryTracking;
+
+  static const char* memoryTagNames[(int) MemoryTag::COUNT + 1] =
+  {
+    "GENERAL",
+    "ARENA",
+    "HANDLE_LIST",
+    "CONFIG",
+    "FILE_BUFFER",
+    "IMAGE",
+    "POOL",
+    "FRAME",
+    "PACKAGE",
+    "TOTAL"
+  };
+
+  static void trackAllocation(int index, size_t size, bool newBlock)
+  {
+    MemoryStats& stats = memoryTracking.stats[index];
+    stats.liveBytes += size;
+    stats.totalAllocations++;
+    if (newBlock)
+      stats.liveAllocations++;
+
+    memoryTracking.frameAllocations[index]++;
+    memoryTracking.frameBytes[index] += size;
+
+    if (stats.liveBytes > stats.peakBytes)
+    {
+      // Only warn the first time the budget is exceeded
+      if (stats.budgetBytes && stats.peakBytes <= stats.budgetBytes && stats.liveBytes > stats.budgetBytes)
+        Log::warning("Memory budget for '%s' exceeded. %zu bytes in use, budget is %zu bytes",
+            memoryTagNames[index], stats.liveBytes, stats.budgetBytes);
+
+      stats.peakBytes = stats.liveBytes;
+    }
+  }
+
+  static void trackFree(int index, size_t size, bool releaseBlock)
+  {
+    MemoryStats& stats = memoryTracking.stats[index];
+    stats.liveBytes -= size;
+    if (releaseBlock)
+      stats.liveAllocations--;
+  }
+
+  static void trackAllocation(MemoryTag tag, size_t size, bool newBlock)
+  {
+    AcquireSRWLockExclusive(&memoryTracking.lock);
+    trackAllocation((int) tag, size, newBlock);
+    trackAllocation((int) MemoryTag::COUNT, size, newBlock);
+    ReleaseSRWLockExclusive(&memoryTracking.lock);
+  }
+
+  static void trackFree(MemoryTag tag, size_t size, bool releaseBlock)
+  {
+    AcquireSRWLockExclusive(&memoryTracking.lock);
+    trackFree((int) tag, size, releaseBlock);
+    trackFree((int) MemoryTag::COUNT, size, releaseBlock);
+    ReleaseSRWLockExclusive(&memoryTracking.lock);
+  }
+
+  inline static MemoryBlockHeader* getMemoryBlockHeader(void* memory)
+  {
+    return ((MemoryBlockHeader*) memory) - 1;
+  }
+
+  void* Platform::getMemory(size_t size, size_t alignment, MemoryTag tag)
   {
-    //TODO(marcio): Add metadata on allocated blocks in debug mode
-    //TODO(marcio): Make possible to allocate aligned memory
-    return malloc(size);
+    if (alignment < SMOL_MEMORY_MIN_ALIGNMENT)
+      alignment = SMOL_MEMORY_MIN_ALIGNMENT;
+
+    char* block = (char*) _aligned_malloc(size + alignment, alignment);
+    if (!block)
+      return nullptr;
+
+    char* memory = block + alignment;
+    MemoryBlockHeader* header = getMemoryBlockHeader(memory);
+    header->size = size;
+    header->alignment = (uint32) alignment;
+    header->tag = tag;
+
+    trackAllocation(tag, size, true);
+    return memory;
   }
 
   void Platform::freeMemory(void* memory)
   {
-    //TODO(marceio): Confirm the memory block is the correct size when we are doing memory management.
-    //TODO(marcio): Make sure passed address is not affected by alignment
-    free(memory);
+    if (!memory)
+      return;
+
+    MemoryBlockHeader* header = getMemoryBlockHeader(memory);
+    trackFree(header->tag, header->size, true);
+    _aligned_free(((char*) memory) - header->alignment);
+  }
+
+  void* Platform::resizeMemory(void* memory, size_t size, size_t alignment, MemoryTag tag)
+  {
+    if (!memory)
+      return getMemory(size, alignment, tag);
+
+    // The alignment must match the one used when the block was allocated
+    MemoryBlockHeader* header = getMemoryBlockHeader(memory);
+    const size_t blockAlignment = header->alignment;
+    const size_t oldSize = header->size;
+    SMOL_ASSERT(alignment <= blockAlignment,
+        "Resizing a %zu byte aligned memory block with %zu byte alignment", blockAlignment, alignment);
+
+    char* block = (char*) _aligned_realloc(((char*) memory) - blockAlignment, size + blockAlignment, blockAlignment);
+    if (!block)
+      return nullptr;
+
+    memory = block + blockAlignment;
+    header = getMemoryBlockHeader(memory);
+    header->size = size;
+
+    trackFree(header->tag, oldSize, false);
+    trackAllocation(header->tag, size, false);
+    return memory;
+  }
+
+  size_t Platform::getMemoryPageSize()
+  {
+    static size_t pageSize = 0;
+    if (pageSize == 0)
+    {
+      SYSTEM_INFO systemInfo;
+      GetSystemInfo(&systemInfo);
+      pageSize = (size_t) systemInfo.dwPageSize;
+    }
+    return pageSize;
+  }
+
+  void* Platform::reserveMemory(size_t size)
+  {
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+  }
+
+  bool Platform::commitMemory(void* memory, size_t size, MemoryTag tag)
+  {
+    if (!VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE))
+      return false;
+
+    trackAllocation(tag, size, false);
+    return true;
+  }
+
+  void Platform::decommitMemory(void* memory, size_t size, MemoryTag tag)
+  {
+    VirtualFree(memory, size, MEM_DECOMMIT);
+    trackFree(tag, size, false);
   }
 
-  void* Platform::resizeMemory(void* memory, size_t size)
+  void Platform::releaseMemory(void* memory, size_t size)
   {
-    return realloc(memory, size);
+    // MEM_RELEASE requires size to be 0 and releases the whole reserved range
+    VirtualFree(memory, 0, MEM_RELEASE);
+  }
+
+  const MemoryStats& Platform::getMemoryStats(MemoryTag tag)
+  {
+    return memoryTracking.stats[(int) tag];
+  }
+
+  const MemoryStats& Platform::getTotalMemoryStats()
+  {
+    return memoryTracking.stats[(int) MemoryTag::COUNT];
+  }
+
+  const char* Platform::getMemoryTagName(MemoryTag tag)
+  {
+    return memoryTagNames[(int) tag];
+  }
+
+  void Platform::setMemoryBudget(MemoryTag tag, size_t bytes)
+  {
+    memoryTracking.stats[(int) tag].budgetBytes = bytes;
+  }
+
+  void Platform::beginMemoryFrame()
+  {
+    for (int i = 0; i <= (int) MemoryTag::COUNT; i++)
+    {
+      MemoryStats& stats = memoryTracking.stats[i];
+      stats.frameAllocations = memoryTracking.frameAllocations[i];
+      stats.frameBytes = memoryTracking.frameBytes[i];
+      memoryTracking.frameAllocations[i] = 0;
+      memoryTracking.frameBytes[i] = 0;
+    }
+  }
+
+  void Platform::dumpMemoryStats()
+  {
+    Log::info("%-12s %12s %12s %12s %10s %12s %10s", "Tag", "Live", "Peak", "Budget", "Blocks", "Frame bytes", "Frame #");
+    for (int i = 0; i <= (int) MemoryTag::COUNT; i++)
+    {
+      const MemoryStats& stats = memoryTracking.stats[i];
+      if (stats.totalAllocations == 0 && i != (int) MemoryTag::COUNT)
+        continue;
+
+      Log::info("%-12s %12zu %12zu %12zu %10u %12zu %10u",
+          memoryTagNames[i], stats.liveBytes, stats.peakBytes, stats.budgetBytes,
+          stats.liveAllocations, stats.frameBytes, stats.frameAllocations);
+    }
   }
 
   uint64 Platform::getTicks()
@@ -801,6 +1028,89 @@ namespace smol
     return (float)ticksSinceStartup /  internal.ticksPerSecond.QuadPart;
   }
 
+  static DWORD WINAPI threadEntryPoint(LPVOID param)
+  {
+    Thread* thread = (Thread*) param;
+    return (DWORD) thread->function(thread->data);
+  }
+
+  Thread* Platform::createThread(ThreadFunction function, void* data)
+  {
+    Thread* thread = (Thread*) Platform::getMemory(sizeof(Thread));
+    thread->function = function;
+    thread->data = data;
+    thread->handle = CreateThread(NULL, 0, threadEntryPoint, thread, 0, NULL);
+
+    if (!thread->handle)
+    {
+      Log::error("Failed to create thread. Error %d", GetLastError());
+      Platform::freeMemory(thread);
+      return nullptr;
+    }
+
+    return thread;
+  }
+
+  void Platform::waitThread(Thread* thread)
+  {
+    if (!thread)
+      return;
+
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    Platform::freeMemory(thread);
+  }
+
+  uint32 Platform::getProcessorCount()
+  {
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    return (uint32) systemInfo.dwNumberOfProcessors;
+  }
+
+  uint32 Platform::getCurrentThreadId()
+  {
+    return (uint32) GetCurrentThreadId();
+  }
+
+  void Platform::yieldThread()
+  {
+    SwitchToThread();
+  }
+
+  Semaphore* Platform::createSemaphore(uint32 initialCount)
+  {
+    HANDLE handle = CreateSemaphore(NULL, (LONG) initialCount, LONG_MAX, NULL);
+    if (!handle)
+    {
+      Log::error("Failed to create semaphore. Error %d", GetLastError());
+      return nullptr;
+    }
+
+    Semaphore* semaphore = (Semaphore*) Platform::getMemory(sizeof(Semaphore));
+    semaphore->handle = handle;
+    return semaphore;
+  }
+
+  void Platform::destroySemaphore(Semaphore* semaphore)
+  {
+    if (!semaphore)
+      return;
+
+    CloseHandle(semaphore->handle);
+    Platform::freeMemory(semaphore);
+  }
+
+  void Platform::waitSemaphore(Semaphore* semaphore)
+  {
+    WaitForSingleObject(semaphore->handle, INFINITE);
+  }
+
+  void Platform::signalSemaphore(Semaphore* semaphore, uint32 count)
+  {
+    ReleaseSemaphore(semaphore->handle, (LONG) count, NULL);
+  }
+
   bool Platform::getWorkingDirectory(char* buffer, size_t buffSize)
   {
     return (GetCurrentDirectory((DWORD) buffSize, buffer) != 0);